@@ -0,0 +1,81 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Utilities for benchmark programs.
+
+  Each benchmark case is a function that does a batch of operations.  Cases
+  are run repeatedly for at least BENCH_MIN_NS, and the results are written
+  to stdout as JSON like:
+
+  {
+    "benchmarks": [
+      {"name": "case", "ops": 1000, "ns": 2000, "ns_per_op": 2.000}
+    ]
+  }
+*/
+
+#include "util/lv2_profile.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define BENCH_MIN_NS 100000000u
+
+typedef void (*BenchFunc)(void* data);
+
+static bool bench_first = true;
+
+static void
+bench_begin(void)
+{
+	printf("{\n  \"benchmarks\": [");
+}
+
+/** Run `func`, which does `n_ops` operations, and report the results. */
+static void
+bench_run(const char* name, BenchFunc func, void* data, uint64_t n_ops)
+{
+	func(data);  // Warm up
+
+	const uint64_t start   = lv2_profile_now();
+	uint64_t       end     = start;
+	uint64_t       n_calls = 0;
+	do {
+		func(data);
+		++n_calls;
+		end = lv2_profile_now();
+	} while (end - start < BENCH_MIN_NS);
+
+	const uint64_t ops = n_calls * n_ops;
+	const uint64_t ns  = end - start;
+	printf("%s\n    {\"name\": \"%s\", \"ops\": %llu, \"ns\": %llu"
+	       ", \"ns_per_op\": %.3f}",
+	       bench_first ? "" : ",",
+	       name,
+	       (unsigned long long)ops,
+	       (unsigned long long)ns,
+	       (double)ns / (double)ops);
+
+	bench_first = false;
+}
+
+static void
+bench_end(void)
+{
+	printf("\n  ]\n}\n");
+}
@@ -0,0 +1,191 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   Benchmark of the C++ atom interface against the equivalent C.
+
+   Each case writes or reads a sequence of small objects (like time:Position
+   updates) many times, and reports the average time per event as JSON.
+*/
+
+#include "lv2/atom/atom-bench-utils.c"
+#include "lv2/atom/atom-test-utils.c"
+#include "lv2/atom/atom.h"
+#include "lv2/atom/atom.hpp"
+#include "lv2/atom/forge.h"
+#include "lv2/atom/util.h"
+#include "lv2/urid/urid.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t n_events = 1024;
+constexpr uint32_t capacity = 64 * n_events;
+
+enum Key : LV2_URID { OTYPE = 1000, KEY_BEAT, KEY_BPM, KEY_SPEED };
+
+struct Context
+{
+	explicit Context(LV2_URID_Map* map)
+		: urids{map}
+		, buf(capacity)
+	{
+		lv2_atom_forge_init(&forge, map);
+	}
+
+	LV2_Atom_Forge         forge;
+	lv2::atom::URIDs       urids;
+	std::vector<uint64_t>  buf;
+	double                 sum = 0.0;
+};
+
+LV2_Atom_Sequence*
+sequence(Context& ctx)
+{
+	return reinterpret_cast<LV2_Atom_Sequence*>(ctx.buf.data());
+}
+
+void
+write_c(Context& ctx)
+{
+	LV2_Atom_Forge* const forge = &ctx.forge;
+	lv2_atom_forge_set_buffer(
+		forge, reinterpret_cast<uint8_t*>(ctx.buf.data()), capacity);
+
+	LV2_Atom_Forge_Frame seq_frame;
+	lv2_atom_forge_sequence_head(forge, &seq_frame, 0);
+	for (uint32_t i = 0; i < n_events; ++i) {
+		LV2_Atom_Forge_Frame frame;
+		lv2_atom_forge_frame_time(forge, i);
+		lv2_atom_forge_object(forge, &frame, 0, OTYPE);
+		lv2_atom_forge_key(forge, KEY_BEAT);
+		lv2_atom_forge_double(forge, i * 0.25);
+		lv2_atom_forge_key(forge, KEY_BPM);
+		lv2_atom_forge_float(forge, 120.0f);
+		lv2_atom_forge_key(forge, KEY_SPEED);
+		lv2_atom_forge_float(forge, 1.0f);
+		lv2_atom_forge_pop(forge, &frame);
+	}
+	lv2_atom_forge_pop(forge, &seq_frame);
+}
+
+void
+write_cpp(Context& ctx)
+{
+	using lv2::atom::property;
+
+	LV2_Atom_Sequence* const seq = sequence(ctx);
+	seq->atom.type = ctx.forge.Sequence;
+	seq->body.unit = 0;
+	seq->body.pad  = 0;
+	lv2_atom_sequence_clear(seq);
+
+	lv2::atom::SequenceWriter writer(seq, capacity - sizeof(LV2_Atom));
+	for (uint32_t i = 0; i < n_events; ++i) {
+		writer.write_object(i,
+		                    ctx.urids,
+		                    OTYPE,
+		                    property(KEY_BEAT, i * 0.25),
+		                    property(KEY_BPM, 120.0f),
+		                    property(KEY_SPEED, 1.0f));
+	}
+}
+
+void
+read_c(Context& ctx)
+{
+	const LV2_Atom_Forge* const forge = &ctx.forge;
+
+	double sum = 0.0;
+	LV2_ATOM_SEQUENCE_FOREACH(sequence(ctx), ev) {
+		const LV2_Atom_Object* obj   = (const LV2_Atom_Object*)&ev->body;
+		const LV2_Atom*        beat  = NULL;
+		const LV2_Atom*        bpm   = NULL;
+		const LV2_Atom*        speed = NULL;
+		lv2_atom_object_get(obj,
+		                    KEY_BEAT, &beat,
+		                    KEY_BPM, &bpm,
+		                    KEY_SPEED, &speed,
+		                    0);
+		if (beat && beat->type == forge->Double) {
+			sum += ((const LV2_Atom_Double*)beat)->body;
+		}
+		if (bpm && bpm->type == forge->Float) {
+			sum += ((const LV2_Atom_Float*)bpm)->body;
+		}
+		if (speed && speed->type == forge->Float) {
+			sum += ((const LV2_Atom_Float*)speed)->body;
+		}
+	}
+
+	ctx.sum += sum;
+}
+
+void
+read_cpp(Context& ctx)
+{
+	using lv2::atom::get;
+
+	double sum = 0.0;
+	for (const LV2_Atom_Event& ev : lv2::atom::SequenceView(sequence(ctx))) {
+		const auto* obj = reinterpret_cast<const LV2_Atom_Object*>(&ev.body);
+		for (const LV2_Atom_Property_Body& prop : lv2::atom::ObjectView(obj)) {
+			if (prop.key == KEY_BEAT) {
+				const double* beat = get<double>(ctx.urids, &prop.value);
+				if (beat) {
+					sum += *beat;
+				}
+			} else if (prop.key == KEY_BPM || prop.key == KEY_SPEED) {
+				const float* value = get<float>(ctx.urids, &prop.value);
+				if (value) {
+					sum += *value;
+				}
+			}
+		}
+	}
+
+	ctx.sum += sum;
+}
+
+template<void (*func)(Context&)>
+void
+bench(void* data)
+{
+	func(*static_cast<Context*>(data));
+}
+
+} // namespace
+
+int
+main()
+{
+	LV2_URID_Map map = {nullptr, urid_map};
+	Context      ctx(&map);
+
+	bench_begin();
+	bench_run("write_c", bench<write_c>, &ctx, n_events);
+	bench_run("write_cpp", bench<write_cpp>, &ctx, n_events);
+	bench_run("read_c", bench<read_c>, &ctx, n_events);
+	bench_run("read_cpp", bench<read_cpp>, &ctx, n_events);
+	bench_end();
+
+	free_urid_map();
+
+	return ctx.sum > 0.0 ? 0 : 1;
+}
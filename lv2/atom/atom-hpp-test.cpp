@@ -0,0 +1,225 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "lv2/atom/atom-test-utils.c"
+#include "lv2/atom/atom.h"
+#include "lv2/atom/atom.hpp"
+#include "lv2/atom/forge.h"
+#include "lv2/atom/util.h"
+#include "lv2/urid/urid.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t capacity = 1024;
+
+// Sizes are compile time constants
+static_assert(lv2::atom::pad_size(5) == 8, "");
+static_assert(lv2::atom::property_size<int32_t>() == 24, "");
+static_assert(lv2::atom::property_size<double>() == 24, "");
+static_assert(lv2::atom::object_body_size<>() == 8, "");
+static_assert(lv2::atom::object_body_size<int32_t, bool, float>() == 80, "");
+
+/** Forge the same events as write_events() with the C forge. */
+void
+forge_events(LV2_Atom_Forge& forge, uint8_t* buf, const int32_t* vec)
+{
+	lv2_atom_forge_set_buffer(&forge, buf, capacity);
+
+	LV2_Atom_Forge_Frame seq_frame;
+	LV2_Atom_Forge_Frame obj_frame;
+	lv2_atom_forge_sequence_head(&forge, &seq_frame, 0);
+
+	lv2_atom_forge_frame_time(&forge, 1);
+	lv2_atom_forge_int(&forge, 42);
+
+	lv2_atom_forge_frame_time(&forge, 2);
+	lv2_atom_forge_object(&forge, &obj_frame, 0, 100);
+	lv2_atom_forge_key(&forge, 101);
+	lv2_atom_forge_int(&forge, 1);
+	lv2_atom_forge_key(&forge, 102);
+	lv2_atom_forge_long(&forge, 2);
+	lv2_atom_forge_key(&forge, 103);
+	lv2_atom_forge_float(&forge, 3.0f);
+	lv2_atom_forge_key(&forge, 104);
+	lv2_atom_forge_double(&forge, 4.0);
+	lv2_atom_forge_key(&forge, 105);
+	lv2_atom_forge_bool(&forge, true);
+	lv2_atom_forge_key(&forge, 106);
+	lv2_atom_forge_urid(&forge, 6);
+	lv2_atom_forge_pop(&forge, &obj_frame);
+
+	lv2_atom_forge_frame_time(&forge, 3);
+	lv2_atom_forge_vector(&forge, sizeof(int32_t), forge.Int, 3, vec);
+
+	lv2_atom_forge_pop(&forge, &seq_frame);
+}
+
+/** Write the same events as forge_events() with the C++ interface. */
+bool
+write_events(const lv2::atom::URIDs& urids,
+             const LV2_URID          sequence_type,
+             uint8_t*                buf,
+             const int32_t*          vec)
+{
+	using lv2::atom::property;
+
+	auto* const seq = reinterpret_cast<LV2_Atom_Sequence*>(buf);
+	seq->atom.type  = sequence_type;
+	seq->body.unit  = 0;
+	seq->body.pad   = 0;
+	lv2_atom_sequence_clear(seq);
+
+	lv2::atom::SequenceWriter writer(seq, capacity - sizeof(LV2_Atom));
+
+	return (writer.write(1, urids, int32_t(42)) &&
+	        writer.write_object(2,
+	                            urids,
+	                            100,
+	                            property(101, int32_t(1)),
+	                            property(102, int64_t(2)),
+	                            property(103, 3.0f),
+	                            property(104, 4.0),
+	                            property(105, true),
+	                            property(106, uint32_t(6))) &&
+	        writer.write_vector<int32_t>(3, urids, vec, 3));
+}
+
+int
+test_write(void)
+{
+	using lv2::atom::property;
+
+	LV2_URID_Map   map = {nullptr, urid_map};
+	LV2_Atom_Forge forge;
+	lv2_atom_forge_init(&forge, &map);
+
+	const lv2::atom::URIDs urids(&map);
+	const int32_t          vec[] = {1, 2, 3};
+
+	uint8_t c_buf[capacity]   = {};
+	uint8_t cpp_buf[capacity] = {};
+	forge_events(forge, c_buf, vec);
+	if (!write_events(urids, forge.Sequence, cpp_buf, vec)) {
+		return test_fail("Failed to write events\n");
+	}
+
+	const auto* c_seq = reinterpret_cast<const LV2_Atom*>(c_buf);
+	if (memcmp(c_buf, cpp_buf, lv2_atom_total_size(c_seq))) {
+		return test_fail("C++ output differs from forge output\n");
+	}
+
+	// Writes that do not fit fail without writing anything
+	auto* const seq  = reinterpret_cast<LV2_Atom_Sequence*>(cpp_buf);
+	const auto  size = seq->atom.size;
+	lv2::atom::SequenceWriter full(seq, size + sizeof(LV2_Atom_Event) + 4);
+	if (full.write(4, urids, 1.0) ||
+	    full.write_object(4, urids, 100, property(101, 1.0f)) ||
+	    full.write_vector<int32_t>(4, urids, vec, 1) ||
+	    !full.write(4, urids, 1.0f) || seq->atom.size != size + 24) {
+		return test_fail("Incorrect writes to a full sequence\n");
+	}
+
+	return 0;
+}
+
+int
+test_read(void)
+{
+	LV2_URID_Map   map = {nullptr, urid_map};
+	LV2_Atom_Forge forge;
+	lv2_atom_forge_init(&forge, &map);
+
+	const lv2::atom::URIDs urids(&map);
+	const int32_t          vec[] = {1, 2, 3};
+
+	uint8_t buf[capacity] = {};
+	forge_events(forge, buf, vec);
+
+	const auto* seq = reinterpret_cast<const LV2_Atom_Sequence*>(buf);
+
+	uint32_t n = 0;
+	for (const LV2_Atom_Event& ev : lv2::atom::SequenceView(seq)) {
+		if (ev.time.frames != int64_t(++n)) {
+			return test_fail("Event %u has bad time\n", n);
+		}
+
+		if (n == 1) {
+			const int32_t* i = lv2::atom::get<int32_t>(urids, &ev.body);
+			if (!i || *i != 42) {
+				return test_fail("Failed to get Int event\n");
+			} else if (lv2::atom::get<float>(urids, &ev.body) ||
+			           lv2::atom::get<int64_t>(urids, &ev.body)) {
+				return test_fail("Got Int event as another type\n");
+			}
+		} else if (n == 2) {
+			const auto* obj = reinterpret_cast<const LV2_Atom_Object*>(&ev.body);
+			const lv2::atom::ObjectView view(obj);
+
+			uint32_t n_props = 0;
+			for (const LV2_Atom_Property_Body& prop : view) {
+				if (prop.key != 101 + n_props++) {
+					return test_fail("Property has bad key %u\n", prop.key);
+				}
+			}
+
+			const int64_t*  l = view.get<int64_t>(urids, 102);
+			const float*    f = view.get<float>(urids, 103);
+			const double*   d = view.get<double>(urids, 104);
+			const int32_t*  b = view.get<bool>(urids, 105);
+			const uint32_t* u = view.get<uint32_t>(urids, 106);
+			if (view.otype() != 100 || n_props != 6) {
+				return test_fail("Corrupt object\n");
+			} else if (!l || *l != 2 || !f || *f != 3.0f || !d || *d != 4.0 ||
+			           !b || !*b || !u || *u != 6) {
+				return test_fail("Failed to get object properties\n");
+			} else if (view.get<float>(urids, 101) ||
+			           view.get<int32_t>(urids, 107)) {
+				return test_fail("Got missing or mistyped property\n");
+			}
+		} else if (n == 3) {
+			const lv2::atom::VectorView<int32_t> ints(urids, &ev.body);
+			const lv2::atom::VectorView<float>   floats(urids, &ev.body);
+
+			int32_t sum = 0;
+			for (const int32_t i : ints) {
+				sum += i;
+			}
+
+			if (ints.size() != 3 || sum != 6 || ints[2] != 3) {
+				return test_fail("Corrupt vector\n");
+			} else if (!floats.empty()) {
+				return test_fail("Read Int vector as Float vector\n");
+			}
+		}
+	}
+
+	return n == 3 ? 0 : test_fail("Iterated over %u events != 3\n", n);
+}
+
+} // namespace
+
+int
+main()
+{
+	const int ret = test_write() || test_read();
+
+	free_urid_map();
+
+	return ret;
+}
@@ -357,6 +357,45 @@ main(void)
 		                                0);
 	}
 
+	typedef struct {
+		int32_t  one;
+		int32_t  two;
+		float    three;
+		int32_t  affirmative;
+		LV2_URID urid;
+		char     string[8];
+	} Decoded;
+
+	const LV2_Atom_Object_Field fields[] = {
+		LV2_ATOM_OBJECT_FIELD(eg_one, forge.Int, Decoded, one),
+		LV2_ATOM_OBJECT_FIELD(eg_two, forge.Int, Decoded, two),
+		LV2_ATOM_OBJECT_FIELD(eg_three, forge.Float, Decoded, three),
+		LV2_ATOM_OBJECT_FIELD(eg_true, forge.Bool, Decoded, affirmative),
+		LV2_ATOM_OBJECT_FIELD(eg_urid, 0, Decoded, urid),
+		LV2_ATOM_OBJECT_FIELD(eg_string, forge.String, Decoded, string),
+		LV2_ATOM_OBJECT_FIELD_END
+	};
+
+	Decoded decoded;
+	memset(&decoded, 0, sizeof(decoded));
+	const uint32_t found = lv2_atom_object_decode(
+		(LV2_Atom_Object*)obj, fields, &decoded);
+	if (found != 0x3D) {
+		return test_fail("Decoded fields 0x%X != 0x3D\n", found);
+	} else if (decoded.one != 1) {
+		return test_fail("Decoded one %d != 1\n", decoded.one);
+	} else if (decoded.two != 0) {
+		return test_fail("Decoded Long two as Int\n");
+	} else if (decoded.three != 3.0f) {
+		return test_fail("Decoded three %f != 3\n", decoded.three);
+	} else if (decoded.affirmative != 1) {
+		return test_fail("Decoded true %d != 1\n", decoded.affirmative);
+	} else if (decoded.urid != eg_value) {
+		return test_fail("Decoded URID %u != %u\n", decoded.urid, eg_value);
+	} else if (strcmp(decoded.string, "hello")) {
+		return test_fail("Decoded string %s != \"hello\"\n", decoded.string);
+	}
+
 	free_urid_map();
 
 	return 0;
@@ -0,0 +1,467 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @file atom.hpp C++ interface for reading and writing atoms.
+
+   This is a thin typed layer over util.h for C++17 code.  Values are accessed
+   through templates parameterised by their C++ type, fixed-layout messages
+   have their sizes computed at compile time, and containers can be iterated
+   over with range-based for loops.  Everything is inline and compiles to the
+   same code as the equivalent C.
+
+   This header is non-normative, it is provided for convenience.
+*/
+
+/**
+   @defgroup atom_hpp C++ Interface
+   @ingroup atom
+   @{
+*/
+
+#ifndef LV2_ATOM_ATOM_HPP
+#define LV2_ATOM_ATOM_HPP
+
+#include "lv2/atom/atom.h"
+#include "lv2/atom/util.h"
+#include "lv2/urid/urid.h"
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace lv2 {
+namespace atom {
+
+/** Pad a size to 64 bits, at compile time if possible. */
+constexpr uint32_t
+pad_size(const uint32_t size) noexcept
+{
+	return (size + 7U) & (~7U);
+}
+
+/**
+   Atom type for a C++ value type.
+
+   This is specialised for the value types which correspond to a primitive
+   atom type: int32_t (Int), int64_t (Long), float (Float), double (Double),
+   bool (Bool), and uint32_t (URID).
+*/
+template<class T>
+struct Primitive;
+
+template<>
+struct Primitive<int32_t> { using Atom = LV2_Atom_Int; };
+
+template<>
+struct Primitive<int64_t> { using Atom = LV2_Atom_Long; };
+
+template<>
+struct Primitive<float> { using Atom = LV2_Atom_Float; };
+
+template<>
+struct Primitive<double> { using Atom = LV2_Atom_Double; };
+
+template<>
+struct Primitive<bool> { using Atom = LV2_Atom_Bool; };
+
+template<>
+struct Primitive<uint32_t> { using Atom = LV2_Atom_URID; };
+
+/** The body type used to store a `T` in an atom (e.g. int32_t for bool). */
+template<class T>
+using Body = decltype(Primitive<T>::Atom::body);
+
+/** Size of a property with a value of type `T`, including padding. */
+template<class T>
+constexpr uint32_t
+property_size() noexcept
+{
+	return sizeof(LV2_Atom_Property_Body) + pad_size(sizeof(Body<T>));
+}
+
+/** Size of the body of an object with properties of types `Ts`. */
+template<class... Ts>
+constexpr uint32_t
+object_body_size() noexcept
+{
+	return sizeof(LV2_Atom_Object_Body) + (0 + ... + property_size<Ts>());
+}
+
+/** URIDs of the atom types, mapped once. */
+struct URIDs
+{
+	explicit URIDs(const LV2_URID_Map* map) noexcept
+		: Bool{map->map(map->handle, LV2_ATOM__Bool)}
+		, Double{map->map(map->handle, LV2_ATOM__Double)}
+		, Float{map->map(map->handle, LV2_ATOM__Float)}
+		, Int{map->map(map->handle, LV2_ATOM__Int)}
+		, Long{map->map(map->handle, LV2_ATOM__Long)}
+		, Object{map->map(map->handle, LV2_ATOM__Object)}
+		, Sequence{map->map(map->handle, LV2_ATOM__Sequence)}
+		, URID{map->map(map->handle, LV2_ATOM__URID)}
+		, Vector{map->map(map->handle, LV2_ATOM__Vector)}
+	{}
+
+	/** Return the URID of the atom type for values of type `T`. */
+	template<class T>
+	LV2_URID type() const noexcept
+	{
+		static_assert(sizeof(typename Primitive<T>::Atom), "Unsupported type");
+		if constexpr (std::is_same_v<T, int32_t>) {
+			return Int;
+		} else if constexpr (std::is_same_v<T, int64_t>) {
+			return Long;
+		} else if constexpr (std::is_same_v<T, float>) {
+			return Float;
+		} else if constexpr (std::is_same_v<T, double>) {
+			return Double;
+		} else if constexpr (std::is_same_v<T, bool>) {
+			return Bool;
+		} else {
+			return URID;
+		}
+	}
+
+	LV2_URID Bool;
+	LV2_URID Double;
+	LV2_URID Float;
+	LV2_URID Int;
+	LV2_URID Long;
+	LV2_URID Object;
+	LV2_URID Sequence;
+	LV2_URID URID;
+	LV2_URID Vector;
+};
+
+/**
+   Return a pointer to the value of `atom` if it is a `T`, or null.
+
+   The type and size of `atom` are both checked, so the result is always safe
+   to dereference.
+*/
+template<class T>
+const Body<T>*
+get(const URIDs& urids, const LV2_Atom* atom) noexcept
+{
+	return (atom && atom->type == urids.type<T>() &&
+	        atom->size == sizeof(Body<T>))
+		? reinterpret_cast<const Body<T>*>(atom + 1)
+		: nullptr;
+}
+
+/**
+   A view of a vector of `T`.
+
+   This is an empty range if the atom is not a vector of `T`, so it can be
+   iterated over without further checks.
+*/
+template<class T>
+class VectorView
+{
+public:
+	VectorView(const URIDs& urids, const LV2_Atom* atom) noexcept
+	{
+		if (atom && atom->type == urids.Vector &&
+		    atom->size >= sizeof(LV2_Atom_Vector_Body)) {
+			const auto* vec = reinterpret_cast<const LV2_Atom_Vector*>(atom);
+			if (vec->body.child_type == urids.type<T>() &&
+			    vec->body.child_size == sizeof(Body<T>)) {
+				const uint32_t n = (atom->size - sizeof(LV2_Atom_Vector_Body)) /
+					sizeof(Body<T>);
+
+				_begin = reinterpret_cast<const Body<T>*>(&vec->body + 1);
+				_end   = _begin + n;
+			}
+		}
+	}
+
+	const Body<T>* begin() const noexcept { return _begin; }
+	const Body<T>* end() const noexcept { return _end; }
+	const Body<T>* data() const noexcept { return _begin; }
+	uint32_t size() const noexcept { return uint32_t(_end - _begin); }
+	bool empty() const noexcept { return _begin == _end; }
+
+	const Body<T>& operator[](const uint32_t i) const noexcept
+	{
+		return _begin[i];
+	}
+
+private:
+	const Body<T>* _begin = nullptr;
+	const Body<T>* _end   = nullptr;
+};
+
+/** Return the event following `ev` in a sequence. */
+inline const LV2_Atom_Event*
+next(const LV2_Atom_Event* ev) noexcept
+{
+	return lv2_atom_sequence_next(ev);
+}
+
+/** Return the property following `prop` in an object. */
+inline const LV2_Atom_Property_Body*
+next(const LV2_Atom_Property_Body* prop) noexcept
+{
+	return lv2_atom_object_next(prop);
+}
+
+/**
+   Iterator over the elements of a sequence or object.
+
+   The end of the container is computed once when iteration starts, and
+   iteration stops when the position reaches or passes it, like
+   LV2_ATOM_SEQUENCE_FOREACH_VALID().  The container must be valid, and must
+   not change size during iteration.
+*/
+template<class Element>
+class Iterator
+{
+public:
+	explicit Iterator(const void* ptr) noexcept
+		: _ptr{static_cast<const Element*>(ptr)}
+	{}
+
+	const Element& operator*() const noexcept { return *_ptr; }
+	const Element* operator->() const noexcept { return _ptr; }
+
+	Iterator& operator++() noexcept
+	{
+		_ptr = atom::next(_ptr);
+		return *this;
+	}
+
+	/** Return true iff this has not reached the end position `end`. */
+	bool operator!=(const Iterator& end) const noexcept
+	{
+		return _ptr < end._ptr;
+	}
+
+private:
+	const Element* _ptr;
+};
+
+/** A range of events in a sequence, for use in range-based for loops. */
+class SequenceView
+{
+public:
+	using iterator = Iterator<LV2_Atom_Event>;
+
+	explicit SequenceView(const LV2_Atom_Sequence* seq) noexcept
+		: _begin{lv2_atom_sequence_begin(&seq->body)}
+		, _end{reinterpret_cast<const uint8_t*>(&seq->body) + seq->atom.size}
+	{}
+
+	iterator begin() const noexcept { return _begin; }
+	iterator end() const noexcept { return _end; }
+
+private:
+	iterator _begin;
+	iterator _end;
+};
+
+/** A range of properties in an object, for use in range-based for loops. */
+class ObjectView
+{
+public:
+	using iterator = Iterator<LV2_Atom_Property_Body>;
+
+	explicit ObjectView(const LV2_Atom_Object* obj) noexcept
+		: _obj{obj}
+		, _begin{lv2_atom_object_begin(&obj->body)}
+		, _end{reinterpret_cast<const uint8_t*>(&obj->body) + obj->atom.size}
+	{}
+
+	LV2_URID id() const noexcept { return _obj->body.id; }
+	LV2_URID otype() const noexcept { return _obj->body.otype; }
+
+	iterator begin() const noexcept { return _begin; }
+	iterator end() const noexcept { return _end; }
+
+	/** Return the value of property `key` if it is a `T`, or null. */
+	template<class T>
+	const Body<T>* get(const URIDs& urids, const LV2_URID key) const noexcept
+	{
+		for (const LV2_Atom_Property_Body& prop : *this) {
+			if (prop.key == key) {
+				return atom::get<T>(urids, &prop.value);
+			}
+		}
+
+		return nullptr;
+	}
+
+private:
+	const LV2_Atom_Object* _obj;
+	iterator               _begin;
+	iterator               _end;
+};
+
+/** A property with a value of type `T`, for writing objects. */
+template<class T>
+struct Property
+{
+	LV2_URID key;
+	T        value;
+};
+
+/** Convenience function for making a property with a deduced type. */
+template<class T>
+constexpr Property<T>
+property(const LV2_URID key, const T value) noexcept
+{
+	return Property<T>{key, value};
+}
+
+/**
+   A cursor for writing events to a sequence.
+
+   This wraps LV2_Atom_Sequence_Writer with methods for writing typed events.
+   Since the layout of primitive and object events with primitive properties
+   is known at compile time, they are written with a single capacity check
+   and fixed offsets, without the per-write checks and frame updates of
+   LV2_Atom_Forge.
+*/
+class SequenceWriter
+{
+public:
+	/**
+	   Start appending to the end of `seq`.
+
+	   @param seq Sequence to append to, which must have a valid header.
+	   @param capacity Total capacity of the sequence atom
+	   (e.g. as set by the host for sequence output ports).
+	*/
+	SequenceWriter(LV2_Atom_Sequence* seq, const uint32_t capacity) noexcept
+		: _writer{}
+	{
+		lv2_atom_sequence_writer_init(&_writer, seq, capacity);
+	}
+
+	/** Return the number of bytes remaining in the sequence buffer. */
+	uint32_t space() const noexcept
+	{
+		return lv2_atom_sequence_writer_space(&_writer);
+	}
+
+	/** Append a copy of an existing event. */
+	bool append(const LV2_Atom_Event& ev) noexcept
+	{
+		return lv2_atom_sequence_writer_append(&_writer, &ev) != nullptr;
+	}
+
+	/** Append an event with a primitive value. */
+	template<class T>
+	bool write(const int64_t frames, const URIDs& urids, const T value) noexcept
+	{
+		void* const body = lv2_atom_sequence_writer_reserve(
+			&_writer, frames, urids.type<T>(), sizeof(Body<T>));
+		if (!body) {
+			return false;
+		}
+
+		const Body<T> v = value;
+		memcpy(body, &v, sizeof(v));
+		return true;
+	}
+
+	/** Append an event with a vector of `n` values. */
+	template<class T>
+	bool write_vector(const int64_t  frames,
+	                  const URIDs&   urids,
+	                  const Body<T>* values,
+	                  const uint32_t n) noexcept
+	{
+		const LV2_Atom_Vector_Body head{sizeof(Body<T>), urids.type<T>()};
+		const uint32_t             values_size = n * sizeof(Body<T>);
+
+		auto* const body = static_cast<uint8_t*>(
+			lv2_atom_sequence_writer_reserve(&_writer,
+			                                 frames,
+			                                 urids.Vector,
+			                                 sizeof(head) + values_size));
+		if (!body) {
+			return false;
+		}
+
+		memcpy(body, &head, sizeof(head));
+		memcpy(body + sizeof(head), values, values_size);
+		return true;
+	}
+
+	/**
+	   Append an event with an object of primitive properties.
+
+	   The size of the object is a compile time constant, so this compiles to
+	   a single capacity check and a sequence of stores.
+	*/
+	template<class... Ts>
+	bool write_object(const int64_t         frames,
+	                  const URIDs&          urids,
+	                  const LV2_URID        otype,
+	                  const Property<Ts>&... props) noexcept
+	{
+		constexpr uint32_t size = object_body_size<Ts...>();
+
+		auto* const body = static_cast<uint8_t*>(
+			lv2_atom_sequence_writer_reserve(
+				&_writer, frames, urids.Object, size));
+		if (!body) {
+			return false;
+		}
+
+		const LV2_Atom_Object_Body head{0, otype};
+		memcpy(body, &head, sizeof(head));
+
+		uint8_t* out = body + sizeof(head);
+		((out = write_property(out, urids, props)), ...);
+		return true;
+	}
+
+private:
+	template<class T>
+	static uint8_t* write_property(uint8_t* const     out,
+	                               const URIDs&       urids,
+	                               const Property<T>& prop) noexcept
+	{
+		constexpr uint32_t size      = sizeof(Body<T>);
+		constexpr uint32_t pad       = pad_size(size) - size;
+		constexpr uint32_t head_size = sizeof(LV2_Atom_Property_Body);
+
+		const LV2_Atom_Property_Body head{
+			prop.key, 0, {size, urids.type<T>()}};
+		const Body<T> value = prop.value;
+
+		memcpy(out, &head, head_size);
+		memcpy(out + head_size, &value, size);
+		if constexpr (pad > 0) {
+			memset(out + head_size + size, 0, pad);
+		}
+
+		return out + head_size + size + pad;
+	}
+
+	LV2_Atom_Sequence_Writer _writer;
+};
+
+} // namespace atom
+} // namespace lv2
+
+/**
+   @}
+*/
+
+#endif // LV2_ATOM_ATOM_HPP
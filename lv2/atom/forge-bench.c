@@ -0,0 +1,217 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   Benchmark of writing objects, vectors, and sequences.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "lv2/atom/atom-bench-utils.c"
+#include "lv2/atom/atom-test-utils.c"
+#include "lv2/atom/atom.h"
+#include "lv2/atom/forge.h"
+#include "lv2/atom/util.h"
+#include "lv2/urid/urid.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define CAPACITY  (1u << 20u)
+#define N_OBJECTS 64u
+#define N_VECTORS 64u
+#define N_EVENTS  1024u
+
+enum { KEY_A = 1000, KEY_B, KEY_C, KEY_CHILD, OTYPE, MIDI_EVENT };
+
+typedef struct {
+	LV2_Atom_Forge forge;
+	uint8_t*       buf;
+	uint32_t       depth;      ///< Depth of objects
+	uint32_t       n_elems;    ///< Number of vector elements
+	float          elems[1024];
+	uint64_t       event[4];   ///< Event to append (3 byte MIDI)
+	bool           overflow;   ///< Set if the buffer overflowed
+} Context;
+
+static void
+set_buffer(Context* ctx)
+{
+	lv2_atom_forge_set_buffer(&ctx->forge, ctx->buf, CAPACITY);
+}
+
+static LV2_Atom_Forge_Ref
+write_object(Context* ctx, uint32_t depth)
+{
+	LV2_Atom_Forge* const forge = &ctx->forge;
+	LV2_Atom_Forge_Frame  frame;
+
+	const LV2_Atom_Forge_Ref ref = lv2_atom_forge_object(
+		forge, &frame, 0, OTYPE);
+	lv2_atom_forge_key(forge, KEY_A);
+	lv2_atom_forge_float(forge, 1.0f);
+	lv2_atom_forge_key(forge, KEY_B);
+	lv2_atom_forge_int(forge, 2);
+	lv2_atom_forge_key(forge, KEY_C);
+	lv2_atom_forge_double(forge, 3.0);
+	if (depth > 1) {
+		lv2_atom_forge_key(forge, KEY_CHILD);
+		write_object(ctx, depth - 1);
+	}
+	lv2_atom_forge_pop(forge, &frame);
+	return ref;
+}
+
+static void
+forge_objects(void* data)
+{
+	Context* const ctx = (Context*)data;
+	set_buffer(ctx);
+
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_tuple(&ctx->forge, &frame);
+	LV2_Atom_Forge_Ref ref = 0;
+	for (uint32_t i = 0; i < N_OBJECTS; ++i) {
+		ref = write_object(ctx, ctx->depth);
+	}
+	lv2_atom_forge_pop(&ctx->forge, &frame);
+	ctx->overflow |= !ref;
+}
+
+static void
+forge_vectors(void* data)
+{
+	Context* const ctx = (Context*)data;
+	set_buffer(ctx);
+
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_tuple(&ctx->forge, &frame);
+	LV2_Atom_Forge_Ref ref = 0;
+	for (uint32_t i = 0; i < N_VECTORS; ++i) {
+		ref = lv2_atom_forge_vector(&ctx->forge,
+		                            sizeof(float),
+		                            ctx->forge.Float,
+		                            ctx->n_elems,
+		                            ctx->elems);
+	}
+	lv2_atom_forge_pop(&ctx->forge, &frame);
+	ctx->overflow |= !ref;
+}
+
+static void
+forge_events(void* data)
+{
+	static const uint8_t msg[3] = { 0x90, 60, 100 };
+
+	Context* const ctx = (Context*)data;
+	set_buffer(ctx);
+
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_sequence_head(&ctx->forge, &frame, 0);
+	LV2_Atom_Forge_Ref ref = 0;
+	for (uint32_t i = 0; i < N_EVENTS; ++i) {
+		lv2_atom_forge_frame_time(&ctx->forge, i);
+		lv2_atom_forge_atom(&ctx->forge, sizeof(msg), MIDI_EVENT);
+		ref = lv2_atom_forge_write(&ctx->forge, msg, sizeof(msg));
+	}
+	lv2_atom_forge_pop(&ctx->forge, &frame);
+	ctx->overflow |= !ref;
+}
+
+static LV2_Atom_Sequence*
+clear_sequence(Context* ctx)
+{
+	LV2_Atom_Sequence* const seq = (LV2_Atom_Sequence*)ctx->buf;
+	seq->atom.type = ctx->forge.Sequence;
+	seq->body.unit = 0;
+	seq->body.pad  = 0;
+	lv2_atom_sequence_clear(seq);
+	return seq;
+}
+
+static void
+append_events(void* data)
+{
+	Context* const           ctx = (Context*)data;
+	LV2_Atom_Sequence* const seq = clear_sequence(ctx);
+	LV2_Atom_Event* const    ev  = (LV2_Atom_Event*)ctx->event;
+	for (uint32_t i = 0; i < N_EVENTS; ++i) {
+		ev->time.frames = i;
+		ctx->overflow |= !lv2_atom_sequence_append_event(seq, CAPACITY, ev);
+	}
+}
+
+static void
+append_events_writer(void* data)
+{
+	Context* const           ctx = (Context*)data;
+	LV2_Atom_Sequence* const seq = clear_sequence(ctx);
+	LV2_Atom_Event* const    ev  = (LV2_Atom_Event*)ctx->event;
+
+	LV2_Atom_Sequence_Writer writer;
+	lv2_atom_sequence_writer_init(&writer, seq, CAPACITY);
+	for (uint32_t i = 0; i < N_EVENTS; ++i) {
+		ev->time.frames = i;
+		ctx->overflow |= !lv2_atom_sequence_writer_append(&writer, ev);
+	}
+}
+
+int
+main(void)
+{
+	LV2_URID_Map map = { NULL, urid_map };
+	Context      ctx;
+	memset(&ctx, 0, sizeof(ctx));
+	lv2_atom_forge_init(&ctx.forge, &map);
+	ctx.buf = (uint8_t*)calloc(1, CAPACITY);
+	for (uint32_t i = 0; i < 1024; ++i) {
+		ctx.elems[i] = (float)i;
+	}
+
+	// Set up a 3 byte MIDI event to append
+	LV2_Atom_Event* const ev = (LV2_Atom_Event*)ctx.event;
+	ev->body.size            = 3;
+	ev->body.type            = MIDI_EVENT;
+
+	bench_begin();
+
+	static const uint32_t depths[] = { 1, 4, 16 };
+	for (uint32_t i = 0; i < sizeof(depths) / sizeof(uint32_t); ++i) {
+		char name[32];
+		snprintf(name, sizeof(name), "forge_object_depth_%u", depths[i]);
+		ctx.depth = depths[i];
+		bench_run(name, forge_objects, &ctx, N_OBJECTS);
+	}
+
+	static const uint32_t sizes[] = { 4, 64, 1024 };
+	for (uint32_t i = 0; i < sizeof(sizes) / sizeof(uint32_t); ++i) {
+		char name[32];
+		snprintf(name, sizeof(name), "forge_vector_%u", sizes[i]);
+		ctx.n_elems = sizes[i];
+		bench_run(name, forge_vectors, &ctx, N_VECTORS);
+	}
+
+	bench_run("sequence_forge_event", forge_events, &ctx, N_EVENTS);
+	bench_run("sequence_append_event", append_events, &ctx, N_EVENTS);
+	bench_run("sequence_writer_append", append_events_writer, &ctx, N_EVENTS);
+
+	bench_end();
+
+	free(ctx.buf);
+	free_urid_map();
+
+	return ctx.overflow ? test_fail("Buffer overflow\n") : 0;
+}
@@ -21,6 +21,7 @@
 #include "lv2/urid/urid.h"
 
 #include <assert.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -190,6 +191,33 @@ test_vector_overflow(void)
 		free(buf);
 	}
 
+	// Test over a range where the header fits but the elements do not
+	const uint32_t head = sizeof(LV2_Atom_Tuple) + sizeof(LV2_Atom_Vector);
+	const uint32_t full = head + sizeof(vec);
+	for (uint32_t capacity = head; capacity < full; ++capacity) {
+		uint8_t* buf = (uint8_t*)calloc(1, capacity);
+
+		LV2_Atom_Forge forge;
+		lv2_atom_forge_init(&forge, &map);
+		lv2_atom_forge_set_buffer(&forge, buf, capacity);
+
+		LV2_Atom_Forge_Frame frame;
+		lv2_atom_forge_tuple(&forge, &frame);
+
+		const LV2_Atom_Forge_Ref ref = lv2_atom_forge_vector(
+			&forge, sizeof(int32_t), forge.Int, 3, vec);
+
+		lv2_atom_forge_pop(&forge, &frame);
+		if (ref) {
+			return test_fail("Wrote vector without elements\n");
+		} else if (forge.offset != sizeof(LV2_Atom_Tuple) ||
+		           ((const LV2_Atom*)buf)->size != 0) {
+			return test_fail("Vector header was not rolled back\n");
+		}
+
+		free(buf);
+	}
+
 	return 0;
 }
 
@@ -224,12 +252,99 @@ test_tuple_overflow(void)
 	return 0;
 }
 
+static int
+test_checkpoint_rollback(void)
+{
+	static const size_t size = sizeof(LV2_Atom_Sequence) + 128;
+	LV2_URID_Map        map  = { NULL, urid_map };
+
+	// Test over a range that fails at every point in the second object
+	for (size_t capacity = sizeof(LV2_Atom_Sequence); capacity < size;
+	     ++capacity) {
+		uint8_t* buf = (uint8_t*)calloc(1, capacity);
+
+		LV2_Atom_Forge forge;
+		lv2_atom_forge_init(&forge, &map);
+		lv2_atom_forge_set_buffer(&forge, buf, capacity);
+
+		LV2_Atom_Forge_Frame seq_frame;
+		lv2_atom_forge_sequence_head(&forge, &seq_frame, 0);
+
+		// Write objects until one does not fit
+		uint32_t n_events = 0;
+		for (bool fits = true; fits; ++n_events) {
+			const LV2_Atom_Forge_Checkpoint checkpoint =
+				lv2_atom_forge_checkpoint(&forge);
+
+			LV2_Atom_Forge_Frame frame;
+			fits = (lv2_atom_forge_frame_time(&forge, n_events) &&
+			        lv2_atom_forge_object(&forge, &frame, 0, 1) &&
+			        lv2_atom_forge_key(&forge, 2) &&
+			        lv2_atom_forge_int(&forge, (int32_t)n_events) &&
+			        lv2_atom_forge_key(&forge, 3) &&
+			        lv2_atom_forge_string(&forge, "value", 5));
+			if (fits) {
+				lv2_atom_forge_pop(&forge, &frame);
+			} else {
+				if (!lv2_atom_forge_rollback(&forge, &checkpoint)) {
+					return test_fail("Failed to roll back\n");
+				} else if (forge.offset != checkpoint.offset ||
+				           forge.stack != &seq_frame) {
+					return test_fail("Rollback did not restore forge\n");
+				}
+				--n_events;
+			}
+		}
+		lv2_atom_forge_pop(&forge, &seq_frame);
+
+		// The sequence must contain only the complete objects
+		const LV2_Atom_Sequence* seq = (const LV2_Atom_Sequence*)buf;
+		if (lv2_atom_total_size(&seq->atom) != forge.offset) {
+			return test_fail("Rolled back sequence has size %u != %u\n",
+			                 lv2_atom_total_size(&seq->atom), forge.offset);
+		} else if (!lv2_atom_sequence_is_valid(seq, 0)) {
+			return test_fail("Rolled back sequence is invalid\n");
+		}
+
+		uint32_t n = 0;
+		LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+			const LV2_Atom_Object* obj = (const LV2_Atom_Object*)&ev->body;
+			const LV2_Atom_Int*    i   = NULL;
+			const LV2_Atom_String* str = NULL;
+			lv2_atom_object_get(obj, 2, &i, 3, &str, 0);
+			if (!i || i->body != (int32_t)n || !str) {
+				return test_fail("Corrupt event %u after rollback\n", n);
+			}
+			++n;
+		}
+
+		if (n != n_events) {
+			return test_fail("Sequence has %u events != %u\n", n, n_events);
+		}
+
+		free(buf);
+	}
+
+	// Rollback is not possible when writing to a sink
+	LV2_Atom_Forge forge;
+	lv2_atom_forge_init(&forge, &map);
+	lv2_atom_forge_set_sink(&forge, NULL, NULL, NULL);
+	const LV2_Atom_Forge_Checkpoint checkpoint =
+		lv2_atom_forge_checkpoint(&forge);
+	if (lv2_atom_forge_rollback(&forge, &checkpoint)) {
+		return test_fail("Successfully rolled back sink output\n");
+	}
+
+	return 0;
+}
+
 int
 main(void)
 {
 	const int ret = test_string_overflow() || test_literal_overflow() ||
 	                test_sequence_overflow() || test_vector_head_overflow() ||
-	                test_vector_overflow() || test_tuple_overflow();
+	                test_vector_overflow() || test_tuple_overflow() ||
+	                test_checkpoint_rollback();
 
 	free_urid_map();
 
@@ -335,6 +335,73 @@ lv2_atom_forge_string_body(LV2_Atom_Forge* forge,
 	return out;
 }
 
+/**
+   @}
+   @name Checkpoints
+   @{
+*/
+
+/**
+   A saved position in forge output.  See lv2_atom_forge_checkpoint().
+*/
+typedef struct {
+	uint32_t              offset;
+	LV2_Atom_Forge_Frame* stack;
+} LV2_Atom_Forge_Checkpoint;
+
+/**
+   Save the current position of `forge` so that output can be undone.
+
+   This makes it possible to write a complete message, then cleanly remove it
+   if any part of it did not fit, for example:
+
+   @code
+   LV2_Atom_Forge_Checkpoint checkpoint = lv2_atom_forge_checkpoint(forge);
+   if (!write_message(forge)) {
+       lv2_atom_forge_rollback(forge, &checkpoint);
+   }
+   @endcode
+
+   Checkpoints are only supported for forges writing to a buffer, since output
+   can not be taken back from a sink.
+*/
+static inline LV2_Atom_Forge_Checkpoint
+lv2_atom_forge_checkpoint(const LV2_Atom_Forge* forge)
+{
+	const LV2_Atom_Forge_Checkpoint checkpoint = { forge->offset,
+	                                               forge->stack };
+	return checkpoint;
+}
+
+/**
+   Undo all output written since `checkpoint`.
+
+   The offset and stack of `forge` are restored, and the size of every
+   container that was open at the checkpoint is reduced accordingly, as if
+   nothing had been written since.  Any frames pushed since the checkpoint are
+   discarded, and frames that were open at the checkpoint must not have been
+   popped.
+
+   @return True on success, or false if `forge` is writing to a sink.
+*/
+static inline bool
+lv2_atom_forge_rollback(LV2_Atom_Forge*                  forge,
+                        const LV2_Atom_Forge_Checkpoint* checkpoint)
+{
+	if (!forge->buf || checkpoint->offset > forge->offset) {
+		return false;
+	}
+
+	const uint32_t n_written = forge->offset - checkpoint->offset;
+	for (LV2_Atom_Forge_Frame* f = checkpoint->stack; f; f = f->parent) {
+		lv2_atom_forge_deref(forge, f->ref)->size -= n_written;
+	}
+
+	forge->offset = checkpoint->offset;
+	forge->stack  = checkpoint->stack;
+	return true;
+}
+
 /**
    @}
    @name Atom Output
@@ -491,7 +558,13 @@ lv2_atom_forge_vector_head(LV2_Atom_Forge*       forge,
 		forge, frame, lv2_atom_forge_write(forge, &a, sizeof(a)));
 }
 
-/** Write a complete atom:Vector. */
+/**
+   Write a complete atom:Vector.
+
+   If the elements do not fit, this fails, and the header is rolled back if
+   `forge` is writing to a buffer, so a vector is never left without the
+   elements its size claims.
+*/
 static inline LV2_Atom_Forge_Ref
 lv2_atom_forge_vector(LV2_Atom_Forge* forge,
                       uint32_t        child_size,
@@ -504,9 +577,13 @@ lv2_atom_forge_vector(LV2_Atom_Forge* forge,
 		  forge->Vector },
 		{ child_size, child_type }
 	};
+	const LV2_Atom_Forge_Checkpoint checkpoint =
+		lv2_atom_forge_checkpoint(forge);
+
 	LV2_Atom_Forge_Ref out = lv2_atom_forge_write(forge, &a, sizeof(a));
-	if (out) {
-		lv2_atom_forge_write(forge, elems, child_size * n_elems);
+	if (out && !lv2_atom_forge_write(forge, elems, child_size * n_elems)) {
+		lv2_atom_forge_rollback(forge, &checkpoint);
+		return 0;
 	}
 	return out;
 }
@@ -0,0 +1,521 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "lv2/atom/atom-test-utils.c"
+#include "lv2/atom/atom.h"
+#include "lv2/atom/forge.h"
+#include "lv2/atom/util.h"
+#include "lv2/urid/urid.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SEQ_CAPACITY 1024
+
+/** Forge a sequence of Int events with the given times into `buf`. */
+static LV2_Atom_Sequence*
+forge_int_sequence(LV2_Atom_Forge* forge,
+                   uint8_t*        buf,
+                   const int64_t*  times,
+                   uint32_t        n_events,
+                   int32_t         first_value)
+{
+	lv2_atom_forge_set_buffer(forge, buf, SEQ_CAPACITY);
+
+	LV2_Atom_Forge_Frame frame;
+	LV2_Atom_Sequence*   seq = (LV2_Atom_Sequence*)lv2_atom_forge_deref(
+		forge, lv2_atom_forge_sequence_head(forge, &frame, 0));
+	for (uint32_t i = 0; i < n_events; ++i) {
+		lv2_atom_forge_frame_time(forge, times[i]);
+		lv2_atom_forge_int(forge, first_value + (int32_t)i);
+	}
+	lv2_atom_forge_pop(forge, &frame);
+	return seq;
+}
+
+static int
+test_merge(void)
+{
+	LV2_URID_Map   map = { NULL, urid_map };
+	LV2_Atom_Forge forge;
+	lv2_atom_forge_init(&forge, &map);
+
+	static const int64_t a_times[] = { 0, 2, 2, 7 };
+	static const int64_t b_times[] = { 1, 2, 9 };
+	static const int64_t c_times[] = { 2 };
+
+	uint8_t a_buf[SEQ_CAPACITY];
+	uint8_t b_buf[SEQ_CAPACITY];
+	uint8_t c_buf[SEQ_CAPACITY];
+
+	const LV2_Atom_Sequence* seqs[] = {
+		forge_int_sequence(&forge, a_buf, a_times, 4, 0),
+		forge_int_sequence(&forge, b_buf, b_times, 3, 10),
+		NULL,
+		forge_int_sequence(&forge, c_buf, c_times, 1, 20)
+	};
+
+	// Expected events, ties are ordered by sequence index
+	static const int64_t  exp_times[]   = { 0, 1, 2, 2, 2, 2, 7, 9 };
+	static const int32_t  exp_values[]  = { 0, 10, 1, 2, 11, 20, 3, 12 };
+	static const uint32_t exp_indices[] = { 0, 1, 0, 0, 1, 3, 0, 1 };
+
+	LV2_Atom_Sequence_Merge merge;
+	if (lv2_atom_sequence_merge_init(&merge, seqs, 4) != 4) {
+		return test_fail("Failed to initialise merge\n");
+	}
+
+	uint32_t n = 0;
+	uint32_t index;
+	for (const LV2_Atom_Event* ev = NULL;
+	     (ev = lv2_atom_sequence_merge_next(&merge, &index));
+	     ++n) {
+		const int32_t value = ((const LV2_Atom_Int*)&ev->body)->body;
+		if (n >= 8) {
+			return test_fail("Merge produced too many events\n");
+		} else if (ev->time.frames != exp_times[n]) {
+			return test_fail("Merged event %u at %ld != %ld\n",
+			                 n, (long)ev->time.frames, (long)exp_times[n]);
+		} else if (value != exp_values[n]) {
+			return test_fail("Merged event %u value %d != %d\n",
+			                 n, value, exp_values[n]);
+		} else if (index != exp_indices[n]) {
+			return test_fail("Merged event %u has bad index %u\n", n, index);
+		}
+	}
+	if (n != 8) {
+		return test_fail("Merge produced %u events != 8\n", n);
+	}
+
+	// Merge directly into an output sequence that only fits 5 events
+	const uint32_t ev_size  = lv2_atom_pad_size(sizeof(LV2_Atom_Event) +
+	                                            sizeof(int32_t));
+	const uint32_t capacity = sizeof(LV2_Atom_Sequence_Body) + 5 * ev_size;
+	uint8_t            out_buf[SEQ_CAPACITY];
+	LV2_Atom_Sequence* out = (LV2_Atom_Sequence*)out_buf;
+	out->atom.type = forge.Sequence;
+	out->body.unit = out->body.pad = 0;
+	lv2_atom_sequence_clear(out);
+
+	lv2_atom_sequence_merge_init(&merge, seqs, 4);
+	uint32_t n_written = lv2_atom_sequence_merge_into(&merge, out, capacity);
+	if (n_written != 5) {
+		return test_fail("Merged %u events into full sequence != 5\n",
+		                 n_written);
+	}
+
+	n_written = lv2_atom_sequence_merge_into(&merge, out, SEQ_CAPACITY - 8);
+	if (n_written != 3) {
+		return test_fail("Merged %u remaining events != 3\n", n_written);
+	}
+
+	n = 0;
+	LV2_ATOM_SEQUENCE_FOREACH(out, ev) {
+		if (ev->time.frames != exp_times[n] ||
+		    ((const LV2_Atom_Int*)&ev->body)->body != exp_values[n]) {
+			return test_fail("Corrupt merged output event %u\n", n);
+		}
+		++n;
+	}
+
+	return n == 8 ? 0 : test_fail("Merged output has %u events != 8\n", n);
+}
+
+static int
+test_writer(void)
+{
+	LV2_URID_Map   map = { NULL, urid_map };
+	LV2_Atom_Forge forge;
+	lv2_atom_forge_init(&forge, &map);
+
+	static const int64_t in_times[] = { 0, 1, 2, 3 };
+
+	uint8_t                  in_buf[SEQ_CAPACITY];
+	const LV2_Atom_Sequence* in = forge_int_sequence(
+		&forge, in_buf, in_times, 4, 0);
+
+	// Sequence with room for exactly 6 Int events
+	const uint32_t ev_size  = lv2_atom_pad_size(sizeof(LV2_Atom_Event) +
+	                                            sizeof(int32_t));
+	const uint32_t capacity = sizeof(LV2_Atom_Sequence_Body) + 6 * ev_size;
+	uint8_t            out_buf[SEQ_CAPACITY];
+	LV2_Atom_Sequence* out = (LV2_Atom_Sequence*)out_buf;
+	out->atom.type = forge.Sequence;
+	out->body.unit = out->body.pad = 0;
+	lv2_atom_sequence_clear(out);
+
+	LV2_Atom_Sequence_Writer writer;
+	lv2_atom_sequence_writer_init(&writer, out, capacity);
+	if (lv2_atom_sequence_writer_space(&writer) != 6 * ev_size) {
+		return test_fail("Writer has bad initial space\n");
+	}
+
+	// Copy the first event, then the middle two as a run
+	const LV2_Atom_Event* i0 = lv2_atom_sequence_begin(&in->body);
+	const LV2_Atom_Event* i1 = lv2_atom_sequence_next(i0);
+	const LV2_Atom_Event* i3 = lv2_atom_sequence_next(
+		lv2_atom_sequence_next(i1));
+	if (!lv2_atom_sequence_writer_append(&writer, i0)) {
+		return test_fail("Failed to append event\n");
+	} else if (!lv2_atom_sequence_writer_append_run(&writer, i1, i3)) {
+		return test_fail("Failed to append run\n");
+	}
+
+	// Write two events in place
+	for (int32_t v = 3; v < 5; ++v) {
+		int32_t* body = (int32_t*)lv2_atom_sequence_writer_reserve(
+			&writer, v, forge.Int, sizeof(int32_t));
+		if (!body) {
+			return test_fail("Failed to reserve event %d\n", v);
+		}
+		*body = v;
+	}
+
+	// Fill the last slot, after which every write must fail
+	if (!lv2_atom_sequence_writer_append(&writer, i3)) {
+		return test_fail("Failed to append last event\n");
+	} else if (lv2_atom_sequence_writer_space(&writer)) {
+		return test_fail("Full writer has space left\n");
+	} else if (lv2_atom_sequence_writer_append(&writer, i0) ||
+	           lv2_atom_sequence_writer_append_run(&writer, i0, i1) ||
+	           lv2_atom_sequence_writer_reserve(&writer, 0, forge.Int, 0)) {
+		return test_fail("Successfully wrote past end of sequence\n");
+	}
+
+	if (out->atom.size != capacity) {
+		return test_fail("Written size %u != %u\n", out->atom.size, capacity);
+	}
+
+	static const int32_t exp_values[] = { 0, 1, 2, 3, 4, 3 };
+	uint32_t             n            = 0;
+	LV2_ATOM_SEQUENCE_FOREACH(out, ev) {
+		if (ev->body.type != forge.Int ||
+		    ((const LV2_Atom_Int*)&ev->body)->body != exp_values[n]) {
+			return test_fail("Corrupt written event %u\n", n);
+		}
+		++n;
+	}
+
+	return n == 6 ? 0 : test_fail("Written sequence has %u events != 6\n", n);
+}
+
+/** Return the next value of a simple deterministic LCG. */
+static uint32_t
+next_rand(uint32_t* state)
+{
+	*state = *state * 1664525u + 1013904223u;
+	return *state >> 8u;
+}
+
+static int
+test_validate(void)
+{
+	LV2_URID_Map   map = { NULL, urid_map };
+	LV2_Atom_Forge forge;
+	lv2_atom_forge_init(&forge, &map);
+
+	// Forge a sequence with a mix of event types and sizes
+	uint8_t buf[SEQ_CAPACITY];
+	lv2_atom_forge_set_buffer(&forge, buf, SEQ_CAPACITY);
+
+	LV2_Atom_Forge_Frame seq_frame;
+	LV2_Atom_Forge_Frame tup_frame;
+	LV2_Atom_Sequence*   seq = (LV2_Atom_Sequence*)lv2_atom_forge_deref(
+		&forge, lv2_atom_forge_sequence_head(&forge, &seq_frame, 0));
+	const int32_t vec[] = { 1, 2, 3 };
+	lv2_atom_forge_frame_time(&forge, 0);
+	lv2_atom_forge_int(&forge, 1);
+	lv2_atom_forge_frame_time(&forge, 1);
+	lv2_atom_forge_long(&forge, 2);
+	lv2_atom_forge_frame_time(&forge, 1);
+	lv2_atom_forge_string(&forge, "hello", 5);
+	lv2_atom_forge_frame_time(&forge, 3);
+	lv2_atom_forge_vector(&forge, sizeof(int32_t), forge.Int, 3, vec);
+	lv2_atom_forge_frame_time(&forge, 4);
+	lv2_atom_forge_tuple(&forge, &tup_frame);
+	lv2_atom_forge_float(&forge, 5.0f);
+	lv2_atom_forge_bool(&forge, true);
+	lv2_atom_forge_pop(&forge, &tup_frame);
+	lv2_atom_forge_frame_time(&forge, 5);
+	lv2_atom_forge_string(&forge, "", 0);
+	lv2_atom_forge_pop(&forge, &seq_frame);
+
+	const uint32_t total = lv2_atom_total_size(&seq->atom);
+	if (!lv2_atom_sequence_is_valid(seq, 0)) {
+		return test_fail("Valid sequence rejected\n");
+	}
+
+	// An empty sequence is valid, but not one too small for a body
+	uint8_t            copy[SEQ_CAPACITY];
+	LV2_Atom_Sequence* mut = (LV2_Atom_Sequence*)copy;
+	memcpy(copy, buf, sizeof(LV2_Atom_Sequence));
+	mut->atom.size = sizeof(LV2_Atom_Sequence_Body);
+	if (!lv2_atom_sequence_is_valid(mut, 0)) {
+		return test_fail("Empty sequence rejected\n");
+	}
+	mut->atom.size = sizeof(LV2_Atom_Sequence_Body) - 1;
+	if (lv2_atom_sequence_is_valid(mut, 0)) {
+		return test_fail("Truncated sequence body accepted\n");
+	}
+
+	// Every truncation that does not end in event padding is invalid
+	uint32_t n_boundaries = 0;
+	for (uint32_t size = sizeof(LV2_Atom_Sequence_Body);
+	     size <= seq->atom.size;
+	     ++size) {
+		memcpy(copy, buf, total);
+		mut->atom.size = size;
+
+		bool boundary = (size == sizeof(LV2_Atom_Sequence_Body));
+		LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+			const uint32_t end = (uint32_t)((const uint8_t*)(ev + 1) -
+			                                (const uint8_t*)&seq->body);
+			boundary = boundary || (size >= end + ev->body.size &&
+			                        size <= lv2_atom_pad_size(end + ev->body.size));
+		}
+
+		n_boundaries += boundary;
+		if (lv2_atom_sequence_is_valid(mut, 0) != boundary) {
+			return test_fail("Truncated to %u bytes, valid != %d\n",
+			                 size, boundary);
+		}
+	}
+	if (n_boundaries < 7) {
+		return test_fail("Only %u valid truncations\n", n_boundaries);
+	}
+
+	// Decreasing time stamps are invalid, whether as frames or beats
+	const LV2_URID beat_time = urid_map(NULL, LV2_ATOM__beatTime);
+	memcpy(copy, buf, total);
+	LV2_Atom_Event* last = NULL;
+	LV2_ATOM_SEQUENCE_FOREACH(mut, ev) {
+		last = ev;
+	}
+	last->time.frames = 2;
+	if (lv2_atom_sequence_is_valid(mut, 0)) {
+		return test_fail("Decreasing frame times accepted\n");
+	}
+
+	mut->body.unit = beat_time;
+	LV2_ATOM_SEQUENCE_FOREACH(mut, ev) {
+		ev->time.beats = ev == last ? 0.5 : 1.0;
+	}
+	if (lv2_atom_sequence_is_valid(mut, beat_time)) {
+		return test_fail("Decreasing beat times accepted\n");
+	}
+	last->time.beats = 1.0;
+	if (!lv2_atom_sequence_is_valid(mut, beat_time)) {
+		return test_fail("Valid beat times rejected\n");
+	}
+
+	/* Corrupt random bytes after the atom header (the size of which must
+	   match the buffer), and check that every sequence accepted by the
+	   validator can be iterated without reading out of bounds. */
+	uint32_t state   = 1;
+	uint32_t n_valid = 0;
+	for (uint32_t i = 0; i < 100000; ++i) {
+		memcpy(copy, buf, total);
+		const uint32_t n_mutations = 1 + next_rand(&state) % 4;
+		for (uint32_t m = 0; m < n_mutations; ++m) {
+			const uint32_t offset = (uint32_t)sizeof(LV2_Atom) +
+				next_rand(&state) % seq->atom.size;
+			const uint32_t r = next_rand(&state);
+			switch (r % 3) {
+			case 0: copy[offset] = (uint8_t)(r >> 8u); break;
+			case 1: copy[offset] ^= (uint8_t)(1u << (r >> 8u) % 8u); break;
+			default: copy[offset] = 0xFF; break;
+			}
+		}
+
+		if (!lv2_atom_sequence_is_valid(mut, 0)) {
+			continue;
+		}
+
+		const uint8_t* const end = (const uint8_t*)&mut->body + mut->atom.size;
+		int64_t              prev = INT64_MIN;
+		LV2_ATOM_SEQUENCE_FOREACH_VALID(mut, ev) {
+			const uint8_t* const body_end = (const uint8_t*)(ev + 1) +
+				ev->body.size;
+			if (body_end > end || body_end < (const uint8_t*)(ev + 1)) {
+				return test_fail("Accepted event overruns sequence\n");
+			} else if (ev->time.frames < prev) {
+				return test_fail("Accepted event goes back in time\n");
+			}
+			prev = ev->time.frames;
+		}
+		++n_valid;
+	}
+	if (n_valid == 0) {
+		return test_fail("No mutated sequences were valid\n");
+	}
+
+	return 0;
+}
+
+typedef struct {
+	uint32_t spans[8][2];
+	uint32_t frames[8];
+	uint32_t n_spans;
+	uint32_t n_events;
+} SplitLog;
+
+static void
+log_span(void* handle, uint32_t begin, uint32_t end)
+{
+	SplitLog* log = (SplitLog*)handle;
+	if (log->n_spans < 8) {
+		log->spans[log->n_spans][0] = begin;
+		log->spans[log->n_spans][1] = end;
+	}
+	++log->n_spans;
+}
+
+static void
+log_event(void* handle, uint32_t frame, const LV2_Atom_Event* ev)
+{
+	SplitLog* log = (SplitLog*)handle;
+	if (log->n_events < 8) {
+		log->frames[log->n_events] = frame;
+	}
+	++log->n_events;
+}
+
+static int
+check_split(const LV2_Atom_Sequence* seq,
+            uint32_t                 min_block,
+            const uint32_t           exp_spans[][2],
+            uint32_t                 n_exp_spans,
+            const uint32_t*          exp_frames)
+{
+	SplitLog log = { { { 0, 0 } }, { 0 }, 0, 0 };
+	lv2_atom_sequence_split(seq, 16, min_block, log_span, log_event, &log);
+	if (log.n_spans != n_exp_spans) {
+		return test_fail("Split into %u spans != %u\n",
+		                 log.n_spans, n_exp_spans);
+	} else if (log.n_events != 6) {
+		return test_fail("Split handled %u events != 6\n", log.n_events);
+	}
+
+	for (uint32_t i = 0; i < n_exp_spans; ++i) {
+		if (log.spans[i][0] != exp_spans[i][0] ||
+		    log.spans[i][1] != exp_spans[i][1]) {
+			return test_fail("Split span %u is [%u, %u) != [%u, %u)\n", i,
+			                 log.spans[i][0], log.spans[i][1],
+			                 exp_spans[i][0], exp_spans[i][1]);
+		}
+	}
+
+	for (uint32_t i = 0; i < 6; ++i) {
+		if (log.frames[i] != exp_frames[i]) {
+			return test_fail("Split event %u at %u != %u\n",
+			                 i, log.frames[i], exp_frames[i]);
+		}
+	}
+
+	return 0;
+}
+
+static int
+test_split(void)
+{
+	LV2_URID_Map   map = { NULL, urid_map };
+	LV2_Atom_Forge forge;
+	lv2_atom_forge_init(&forge, &map);
+
+	// The last event is past the end of the 16 frame cycle
+	static const int64_t times[] = { 0, 3, 3, 4, 10, 20 };
+
+	uint8_t                  buf[SEQ_CAPACITY];
+	const LV2_Atom_Sequence* seq = forge_int_sequence(
+		&forge, buf, times, 6, 0);
+
+	// Sample accurate, events at the same time do not produce empty spans
+	static const uint32_t exact_spans[][2] = {
+		{ 0, 3 }, { 3, 4 }, { 4, 10 }, { 10, 16 } };
+	static const uint32_t exact_frames[] = { 0, 3, 3, 4, 10, 16 };
+
+	// Quantised, events less than 4 frames after a split are handled early
+	static const uint32_t quant_spans[][2] = { { 0, 4 }, { 4, 10 }, { 10, 16 } };
+	static const uint32_t quant_frames[]   = { 0, 0, 0, 4, 10, 16 };
+
+	return (check_split(seq, 0, exact_spans, 4, exact_frames) ||
+	        check_split(seq, 1, exact_spans, 4, exact_frames) ||
+	        check_split(seq, 4, quant_spans, 3, quant_frames));
+}
+
+static int
+test_index(void)
+{
+	LV2_URID_Map   map = { NULL, urid_map };
+	LV2_Atom_Forge forge;
+	lv2_atom_forge_init(&forge, &map);
+
+	// Even times with gaps, every third event has the same time as the last
+	int64_t times[40];
+	for (uint32_t i = 0; i < 40; ++i) {
+		times[i] = 2 * (i - (i % 3 == 1));
+	}
+
+	uint8_t                  buf[SEQ_CAPACITY];
+	const LV2_Atom_Sequence* seq = forge_int_sequence(
+		&forge, buf, times, 40, 0);
+
+	LV2_Atom_Sequence_Index_Entry entries[40];
+	if (lv2_atom_sequence_index_build(seq, NULL, 0) != 40) {
+		return test_fail("Failed to count events for index\n");
+	} else if (lv2_atom_sequence_index_build(seq, entries, 40) != 40) {
+		return test_fail("Failed to build index\n");
+	}
+
+	// Compare every seek with a linear search
+	for (int64_t t = -1; t <= 80; ++t) {
+		const LV2_Atom_Event* expected = NULL;
+		LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+			if (ev->time.frames >= t) {
+				expected = ev;
+				break;
+			}
+		}
+
+		const LV2_Atom_Event* ev = lv2_atom_sequence_index_seek(
+			seq, entries, 40, t);
+		if (!expected) {
+			if (!lv2_atom_sequence_is_end(&seq->body, seq->atom.size, ev)) {
+				return test_fail("Seek past last event is not at end\n");
+			}
+		} else if (ev != expected) {
+			return test_fail("Seek to %ld found event at %ld != %ld\n",
+			                 (long)t,
+			                 (long)ev->time.frames,
+			                 (long)expected->time.frames);
+		}
+	}
+
+	return 0;
+}
+
+int
+main(void)
+{
+	const int ret = (test_merge() || test_writer() || test_validate() ||
+	                 test_split() || test_index());
+
+	free_urid_map();
+
+	return ret;
+}
@@ -0,0 +1,210 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   Benchmark of reading sequences and objects.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "lv2/atom/atom-bench-utils.c"
+#include "lv2/atom/atom-test-utils.c"
+#include "lv2/atom/atom.h"
+#include "lv2/atom/forge.h"
+#include "lv2/atom/util.h"
+#include "lv2/urid/urid.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define CAPACITY (1u << 16u)
+#define N_EVENTS 1024u
+#define N_GETS   1024u
+#define N_KEYS   32u
+#define KEY(i)   (1000u + (i))
+
+enum { OTYPE = 2000, MIDI_EVENT };
+
+typedef struct {
+	LV2_Atom_Forge         forge;
+	LV2_Atom_Sequence*     seq;         ///< Sequence of MIDI events
+	const LV2_Atom_Object* objects[2];  ///< Objects with 8 and 32 keys
+	uint64_t               sum;         ///< Sum of event times and sizes
+	uint64_t               n_bad;       ///< Number of incorrect results
+} Context;
+
+static LV2_Atom_Object*
+write_object(LV2_Atom_Forge* forge, uint8_t* buf, uint32_t n_keys)
+{
+	lv2_atom_forge_set_buffer(forge, buf, CAPACITY);
+
+	LV2_Atom_Forge_Frame frame;
+	LV2_Atom_Object*     obj = (LV2_Atom_Object*)lv2_atom_forge_deref(
+		forge, lv2_atom_forge_object(forge, &frame, 0, OTYPE));
+	for (uint32_t i = 0; i < n_keys; ++i) {
+		lv2_atom_forge_key(forge, KEY(i));
+		lv2_atom_forge_int(forge, (int32_t)i);
+	}
+	lv2_atom_forge_pop(forge, &frame);
+	return obj;
+}
+
+static void
+iterate_sequence(void* data)
+{
+	Context* const ctx = (Context*)data;
+	uint64_t       sum = 0;
+	LV2_ATOM_SEQUENCE_FOREACH(ctx->seq, ev) {
+		sum += (uint64_t)ev->time.frames + ev->body.size;
+	}
+	ctx->sum += sum;
+}
+
+static void
+get_4_of_8(void* data)
+{
+	Context* const ctx = (Context*)data;
+	for (uint32_t i = 0; i < N_GETS; ++i) {
+		const LV2_Atom* a = NULL;
+		const LV2_Atom* b = NULL;
+		const LV2_Atom* c = NULL;
+		const LV2_Atom* d = NULL;
+		const int n = lv2_atom_object_get(ctx->objects[0],
+		                                  KEY(1), &a,
+		                                  KEY(3), &b,
+		                                  KEY(5), &c,
+		                                  KEY(7), &d,
+		                                  0);
+		ctx->n_bad += n != 4;
+	}
+}
+
+static void
+get_8_of_32(void* data)
+{
+	Context* const ctx = (Context*)data;
+	for (uint32_t i = 0; i < N_GETS; ++i) {
+		const LV2_Atom* v[8] = { NULL, NULL, NULL, NULL,
+		                         NULL, NULL, NULL, NULL };
+		const int n = lv2_atom_object_get(ctx->objects[1],
+		                                  KEY(3), &v[0],
+		                                  KEY(7), &v[1],
+		                                  KEY(11), &v[2],
+		                                  KEY(15), &v[3],
+		                                  KEY(19), &v[4],
+		                                  KEY(23), &v[5],
+		                                  KEY(27), &v[6],
+		                                  KEY(31), &v[7],
+		                                  0);
+		ctx->n_bad += n != 8;
+	}
+}
+
+static void
+get_typed_8_of_32(void* data)
+{
+	Context* const ctx = (Context*)data;
+	const LV2_URID Int = ctx->forge.Int;
+	for (uint32_t i = 0; i < N_GETS; ++i) {
+		const LV2_Atom* v[8] = { NULL, NULL, NULL, NULL,
+		                         NULL, NULL, NULL, NULL };
+		const int n = lv2_atom_object_get_typed(ctx->objects[1],
+		                                        KEY(3), &v[0], Int,
+		                                        KEY(7), &v[1], Int,
+		                                        KEY(11), &v[2], Int,
+		                                        KEY(15), &v[3], Int,
+		                                        KEY(19), &v[4], Int,
+		                                        KEY(23), &v[5], Int,
+		                                        KEY(27), &v[6], Int,
+		                                        KEY(31), &v[7], Int,
+		                                        0);
+		ctx->n_bad += n != 8;
+	}
+}
+
+static void
+query_32_of_32(void* data)
+{
+	Context* const ctx = (Context*)data;
+	for (uint32_t i = 0; i < N_GETS; ++i) {
+		const LV2_Atom*       v[N_KEYS];
+		LV2_Atom_Object_Query q[N_KEYS + 1];
+		for (uint32_t k = 0; k < N_KEYS; ++k) {
+			v[k]       = NULL;
+			q[k].key   = KEY(N_KEYS - 1 - k);
+			q[k].value = &v[k];
+		}
+		q[N_KEYS].key   = 0;
+		q[N_KEYS].value = NULL;
+
+		ctx->n_bad += lv2_atom_object_query(ctx->objects[1], q) != (int)N_KEYS;
+	}
+}
+
+int
+main(void)
+{
+	LV2_URID_Map map = { NULL, urid_map };
+	Context      ctx;
+	memset(&ctx, 0, sizeof(ctx));
+	lv2_atom_forge_init(&ctx.forge, &map);
+
+	uint8_t* const seq_buf  = (uint8_t*)calloc(1, CAPACITY);
+	uint8_t* const obj_buf8 = (uint8_t*)calloc(1, CAPACITY);
+	uint8_t* const obj_buf  = (uint8_t*)calloc(1, CAPACITY);
+
+	// Write a sequence of MIDI events
+	static const uint8_t msg[3] = { 0x90, 60, 100 };
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_set_buffer(&ctx.forge, seq_buf, CAPACITY);
+	lv2_atom_forge_sequence_head(&ctx.forge, &frame, 0);
+	for (uint32_t i = 0; i < N_EVENTS; ++i) {
+		lv2_atom_forge_frame_time(&ctx.forge, i);
+		lv2_atom_forge_atom(&ctx.forge, sizeof(msg), MIDI_EVENT);
+		lv2_atom_forge_write(&ctx.forge, msg, sizeof(msg));
+	}
+	lv2_atom_forge_pop(&ctx.forge, &frame);
+	ctx.seq = (LV2_Atom_Sequence*)seq_buf;
+
+	// Write objects with 8 and 32 properties
+	ctx.objects[0] = write_object(&ctx.forge, obj_buf8, 8);
+	ctx.objects[1] = write_object(&ctx.forge, obj_buf, N_KEYS);
+
+	bench_begin();
+
+	bench_run("sequence_iterate", iterate_sequence, &ctx, N_EVENTS);
+	bench_run("object_get_4_of_8", get_4_of_8, &ctx, N_GETS);
+	bench_run("object_get_8_of_32", get_8_of_32, &ctx, N_GETS);
+	bench_run("object_get_typed_8_of_32", get_typed_8_of_32, &ctx, N_GETS);
+	bench_run("object_query_32_of_32", query_32_of_32, &ctx, N_GETS);
+
+	bench_end();
+
+	free(obj_buf);
+	free(obj_buf8);
+	free(seq_buf);
+	free_urid_map();
+
+	// Every iteration sums the times (0 to N_EVENTS - 1) and sizes (3)
+	const uint64_t iteration_sum = N_EVENTS * (N_EVENTS - 1) / 2 + 3 * N_EVENTS;
+	if (ctx.sum % iteration_sum) {
+		return test_fail("Incorrect sequence iteration sum\n");
+	} else if (ctx.n_bad) {
+		return test_fail("Incorrect number of object matches\n");
+	}
+
+	return 0;
+}
@@ -35,6 +35,7 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -132,6 +133,69 @@ lv2_atom_sequence_next(const LV2_Atom_Event* i)
 	     !lv2_atom_sequence_is_end(body, size, (iter)); \
 	     (iter) = lv2_atom_sequence_next(iter))
 
+/**
+   Return true iff `seq` is a well-formed sequence.
+
+   This walks the sequence once and checks that every event is entirely within
+   the sequence, that the sequence ends within the padding of the last event,
+   and that time stamps never decrease.  Time stamps are
+   compared as beats if the sequence unit is `beat_time`, and as frames
+   otherwise.  Passing 0 for `beat_time` always compares frames.
+
+   A sequence that passes this check can be iterated over with
+   LV2_ATOM_SEQUENCE_FOREACH_VALID() without any further checks.
+*/
+static inline bool
+lv2_atom_sequence_is_valid(const LV2_Atom_Sequence* seq, uint32_t beat_time)
+{
+	const uint32_t size  = seq->atom.size;
+	const bool     beats = beat_time && seq->body.unit == beat_time;
+	if (size < sizeof(LV2_Atom_Sequence_Body)) {
+		return false;
+	}
+
+	const uint8_t* const  body   = (const uint8_t*)&seq->body;
+	const LV2_Atom_Event* prev   = NULL;
+	uint32_t              offset = (uint32_t)sizeof(LV2_Atom_Sequence_Body);
+	while (offset < size) {
+		const LV2_Atom_Event* const ev = (const LV2_Atom_Event*)(body + offset);
+		if (size - offset < sizeof(LV2_Atom_Event)) {
+			return false;  // Trailing garbage smaller than an event
+		} else if (ev->body.size > size - offset - sizeof(LV2_Atom_Event)) {
+			return false;  // Event body overruns sequence
+		} else if (beats && !(ev->time.beats == ev->time.beats)) {
+			return false;  // Time stamp is NaN
+		} else if (prev && (beats ? ev->time.beats < prev->time.beats
+		                          : ev->time.frames < prev->time.frames)) {
+			return false;  // Time went backwards
+		}
+
+		prev   = ev;
+		offset += lv2_atom_pad_size(
+			(uint32_t)sizeof(LV2_Atom_Event) + ev->body.size);
+	}
+
+	return true;
+}
+
+/**
+   Like LV2_ATOM_SEQUENCE_FOREACH, but for a sequence known to be valid.
+
+   The end of the sequence is computed once before the loop, so the compiler
+   does not need to reload the sequence size after every write in the loop
+   body.  The sequence MUST NOT change size during iteration, and MUST have
+   been checked with lv2_atom_sequence_is_valid() if it comes from an
+   untrusted source.  The end is kept in an additional variable named
+   lv2_atom_`iter`_end, which is prefixed so it can not shadow or collide with
+   any names in the loop body.
+*/
+#define LV2_ATOM_SEQUENCE_FOREACH_VALID(seq, iter) \
+	for (LV2_Atom_Event* iter = lv2_atom_sequence_begin(&(seq)->body), \
+	     * const lv2_atom_##iter##_end = (LV2_Atom_Event*)( \
+		     (const uint8_t*)&(seq)->body + (seq)->atom.size); \
+	     (iter) < lv2_atom_##iter##_end; \
+	     (iter) = lv2_atom_sequence_next(iter))
+
 /**
    @}
    @name Sequence Utilities
@@ -178,6 +242,477 @@ lv2_atom_sequence_append_event(LV2_Atom_Sequence*    seq,
 	return e;
 }
 
+/**
+   @}
+   @name Sequence Writer
+   @{
+*/
+
+/**
+   A cursor for appending many events to a Sequence.
+
+   This caches the write position and the end of the buffer, so appending an
+   event only needs a single capacity check, rather than deriving the end of
+   the sequence from its size every time as lv2_atom_sequence_append_event()
+   does.  The size of the sequence is kept up to date after every append, so
+   there is nothing to finish when writing is done.
+*/
+typedef struct {
+	LV2_Atom_Sequence* seq;    /**< Sequence being written */
+	uint8_t*           head;   /**< Write position (end of sequence) */
+	uint8_t*           limit;  /**< End of sequence buffer */
+} LV2_Atom_Sequence_Writer;
+
+/**
+   Initialise `writer` to append to the end of `seq`.
+
+   @param writer The writer to initialise.
+   @param seq Sequence to append to, which must have a valid header.
+   @param capacity Total capacity of the sequence atom
+   (e.g. as set by the host for sequence output ports).
+*/
+static inline void
+lv2_atom_sequence_writer_init(LV2_Atom_Sequence_Writer* writer,
+                              LV2_Atom_Sequence*        seq,
+                              uint32_t                  capacity)
+{
+	writer->seq   = seq;
+	writer->head  = (uint8_t*)lv2_atom_sequence_end(&seq->body, seq->atom.size);
+	writer->limit = (uint8_t*)&seq->body + capacity;
+}
+
+/** Return the number of bytes remaining in the sequence buffer. */
+static inline uint32_t
+lv2_atom_sequence_writer_space(const LV2_Atom_Sequence_Writer* writer)
+{
+	return writer->head < writer->limit
+		? (uint32_t)(writer->limit - writer->head)
+		: 0;
+}
+
+/**
+   Reserve space for an event and write its header.
+
+   This is the fast path for small fixed-size events like MIDI messages: the
+   caller writes the body directly to the returned pointer, for example:
+
+   @code
+   uint8_t* const msg = (uint8_t*)lv2_atom_sequence_writer_reserve(
+       &writer, ev->time.frames, uris.midi_Event, 3);
+   if (msg) {
+       msg[0] = status;
+       msg[1] = note;
+       msg[2] = velocity;
+   }
+   @endcode
+
+   @return A pointer to the event body, or NULL on failure (insufficient
+   space).
+*/
+static inline void*
+lv2_atom_sequence_writer_reserve(LV2_Atom_Sequence_Writer* writer,
+                                 int64_t                   frames,
+                                 uint32_t                  type,
+                                 uint32_t                  size)
+{
+	const uint32_t total_size = (uint32_t)sizeof(LV2_Atom_Event) + size;
+	if (lv2_atom_sequence_writer_space(writer) < total_size) {
+		return NULL;
+	}
+
+	LV2_Atom_Event* const ev = (LV2_Atom_Event*)writer->head;
+	ev->time.frames = frames;
+	ev->body.size   = size;
+	ev->body.type   = type;
+
+	writer->head += lv2_atom_pad_size(total_size);
+	writer->seq->atom.size = (uint32_t)(writer->head -
+	                                    (uint8_t*)&writer->seq->body);
+
+	return ev + 1;
+}
+
+/**
+   Append a copy of `event` to the sequence.
+
+   @return A pointer to the newly written event, or NULL on failure
+   (insufficient space).
+*/
+static inline LV2_Atom_Event*
+lv2_atom_sequence_writer_append(LV2_Atom_Sequence_Writer* writer,
+                                const LV2_Atom_Event*     event)
+{
+	const uint32_t total_size = (uint32_t)sizeof(*event) + event->body.size;
+	if (lv2_atom_sequence_writer_space(writer) < total_size) {
+		return NULL;
+	}
+
+	LV2_Atom_Event* const e = (LV2_Atom_Event*)writer->head;
+	memcpy(e, event, total_size);
+
+	writer->head += lv2_atom_pad_size(total_size);
+	writer->seq->atom.size = (uint32_t)(writer->head -
+	                                    (uint8_t*)&writer->seq->body);
+
+	return e;
+}
+
+/**
+   Append a run of consecutive events from another sequence.
+
+   All events in the range [`begin`, `end`) are copied with a single memcpy(),
+   which is much faster than appending them one at a time.  The range must be
+   from a valid sequence, for example the range between two iterators in an
+   input sequence, and the caller is responsible for the events being in time
+   order with respect to those already written.
+
+   @return True on success, or false if the run does not fit, in which case
+   nothing is written.
+*/
+static inline bool
+lv2_atom_sequence_writer_append_run(LV2_Atom_Sequence_Writer* writer,
+                                    const LV2_Atom_Event*     begin,
+                                    const LV2_Atom_Event*     end)
+{
+	const uint32_t size = (uint32_t)((const uint8_t*)end -
+	                                 (const uint8_t*)begin);
+	if (lv2_atom_sequence_writer_space(writer) < size) {
+		return false;
+	}
+
+	memcpy(writer->head, begin, size);
+
+	writer->head += size;
+	writer->seq->atom.size = (uint32_t)(writer->head -
+	                                    (uint8_t*)&writer->seq->body);
+
+	return true;
+}
+
+/**
+   @}
+   @name Sequence Merging
+   @{
+*/
+
+/** Maximum number of sequences that can be merged at once. */
+#define LV2_ATOM_SEQUENCE_MERGE_MAX 16
+
+/**
+   An iterator over several Sequences in time order.
+
+   This is a plain struct that can be allocated on the stack, merging does not
+   allocate any memory.  All merged sequences must have the same time unit,
+   events are ordered by their `time.frames` stamp.
+*/
+typedef struct {
+	const LV2_Atom_Event* iters[LV2_ATOM_SEQUENCE_MERGE_MAX];
+	const uint8_t*        ends[LV2_ATOM_SEQUENCE_MERGE_MAX];
+	uint32_t              n_seqs;
+} LV2_Atom_Sequence_Merge;
+
+/**
+   Initialise `merge` to iterate over `n_seqs` sequences.
+
+   NULL entries in `seqs` are treated as empty sequences.
+
+   @return The number of sequences that will be merged, which is `n_seqs`
+   clamped to LV2_ATOM_SEQUENCE_MERGE_MAX.
+*/
+static inline uint32_t
+lv2_atom_sequence_merge_init(LV2_Atom_Sequence_Merge*        merge,
+                             const LV2_Atom_Sequence* const* seqs,
+                             uint32_t                        n_seqs)
+{
+	if (n_seqs > LV2_ATOM_SEQUENCE_MERGE_MAX) {
+		n_seqs = LV2_ATOM_SEQUENCE_MERGE_MAX;
+	}
+
+	merge->n_seqs = n_seqs;
+	for (uint32_t i = 0; i < n_seqs; ++i) {
+		const LV2_Atom_Sequence* const seq = seqs[i];
+		if (seq) {
+			merge->iters[i] = lv2_atom_sequence_begin(&seq->body);
+			merge->ends[i]  = (const uint8_t*)&seq->body + seq->atom.size;
+		} else {
+			merge->iters[i] = NULL;
+			merge->ends[i]  = NULL;
+		}
+	}
+	return n_seqs;
+}
+
+/**
+   Return the next event in time order without advancing `merge`.
+
+   Events with equal times are returned in the order of their sequences in
+   the array passed to lv2_atom_sequence_merge_init(), so merging is stable.
+
+   @param merge The merge iterator.
+   @param index Set to the index of the sequence the returned event is from.
+   @return The next event, or NULL if all sequences have been exhausted.
+*/
+static inline const LV2_Atom_Event*
+lv2_atom_sequence_merge_peek(const LV2_Atom_Sequence_Merge* merge,
+                             uint32_t*                      index)
+{
+	const LV2_Atom_Event* best = NULL;
+	for (uint32_t i = 0; i < merge->n_seqs; ++i) {
+		const LV2_Atom_Event* ev = merge->iters[i];
+		if (ev && (const uint8_t*)ev < merge->ends[i] &&
+		    (!best || ev->time.frames < best->time.frames)) {
+			best   = ev;
+			*index = i;
+		}
+	}
+	return best;
+}
+
+/**
+   Return the next event in time order and advance `merge` past it.
+
+   @param merge The merge iterator.
+   @param index If not NULL, set to the index of the sequence the returned
+   event came from.
+   @return The next event, or NULL if all sequences have been exhausted.
+*/
+static inline const LV2_Atom_Event*
+lv2_atom_sequence_merge_next(LV2_Atom_Sequence_Merge* merge, uint32_t* index)
+{
+	uint32_t              i  = 0;
+	const LV2_Atom_Event* ev = lv2_atom_sequence_merge_peek(merge, &i);
+	if (ev) {
+		merge->iters[i] = lv2_atom_sequence_next(ev);
+		if (index) {
+			*index = i;
+		}
+	}
+	return ev;
+}
+
+/**
+   Append all remaining events from `merge` to `out` in time order.
+
+   Events are copied directly into `out`, there is no intermediate buffer.  If
+   an event does not fit in the remaining space, it and all later events are
+   left in `merge`, so writing can be resumed with a larger buffer.
+
+   @param merge The merge iterator.
+   @param out Sequence to append to.
+   @param capacity Total capacity of the sequence atom
+   (e.g. as set by the host for sequence output ports).
+   @return The number of events written.
+*/
+static inline uint32_t
+lv2_atom_sequence_merge_into(LV2_Atom_Sequence_Merge* merge,
+                             LV2_Atom_Sequence*       out,
+                             uint32_t                 capacity)
+{
+	uint8_t* const body  = (uint8_t*)&out->body;
+	uint8_t*       dst   = (uint8_t*)lv2_atom_sequence_end(&out->body,
+	                                                       out->atom.size);
+	uint32_t       count = 0;
+	uint32_t       i     = 0;
+	for (const LV2_Atom_Event* ev = NULL;
+	     (ev = lv2_atom_sequence_merge_peek(merge, &i));
+	     ++count) {
+		const uint32_t size = (uint32_t)sizeof(LV2_Atom_Event) + ev->body.size;
+		if (capacity - (uint32_t)(dst - body) < size) {
+			break;
+		}
+
+		memcpy(dst, ev, size);
+		dst += lv2_atom_pad_size(size);
+		merge->iters[i] = lv2_atom_sequence_next(ev);
+	}
+
+	out->atom.size = (uint32_t)(dst - body);
+	return count;
+}
+
+/**
+   @}
+   @name Sequence Index
+   @{
+*/
+
+/**
+   An entry in a sequence index.
+
+   A sequence index is an array of these, one for each event in a sequence in
+   order, which allows finding events by time without walking the sequence.
+*/
+typedef struct {
+	int64_t  frames;  ///< Time stamp of event in frames
+	uint32_t offset;  ///< Offset of event from the start of the sequence body
+	uint32_t pad;     ///< Padding, always 0
+} LV2_Atom_Sequence_Index_Entry;
+
+/**
+   Build an index of the events in `seq` in a single pass.
+
+   At most `max_entries` entries are written, but the return value is always
+   the total number of events in `seq`, so this can be called with NULL
+   `entries` to find how many entries are required.
+
+   @param seq Sequence with frame time stamps to index.
+   @param entries Array of at least `max_entries` entries to write to.
+   @param max_entries Maximum number of entries to write.
+   @return The number of events in `seq`.
+*/
+static inline uint32_t
+lv2_atom_sequence_index_build(const LV2_Atom_Sequence*       seq,
+                              LV2_Atom_Sequence_Index_Entry* entries,
+                              uint32_t                       max_entries)
+{
+	const uint8_t* const body = (const uint8_t*)&seq->body;
+	uint32_t             n    = 0;
+	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+		if (n < max_entries) {
+			entries[n].frames = ev->time.frames;
+			entries[n].offset = (uint32_t)((const uint8_t*)ev - body);
+			entries[n].pad    = 0;
+		}
+		++n;
+	}
+
+	return n;
+}
+
+/**
+   Return the index of the first entry at or after `frames`.
+
+   This is a binary search, so the entries must be sorted by time, as they are
+   in any valid sequence.
+
+   @return An index in [0, `n_entries`], where `n_entries` means that all
+   entries are before `frames`.
+*/
+static inline uint32_t
+lv2_atom_sequence_index_find(const LV2_Atom_Sequence_Index_Entry* entries,
+                             uint32_t                             n_entries,
+                             int64_t                              frames)
+{
+	uint32_t lo = 0;
+	uint32_t hi = n_entries;
+	while (lo < hi) {
+		const uint32_t mid = lo + (hi - lo) / 2;
+		if (entries[mid].frames < frames) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+/**
+   Return an iterator to the first event in `seq` at or after `frames`.
+
+   The returned iterator can be used to continue iterating over the sequence
+   with lv2_atom_sequence_next() and lv2_atom_sequence_is_end() as usual.
+
+   @param seq Sequence to seek in.
+   @param entries Complete index of `seq`, from lv2_atom_sequence_index_build().
+   @param n_entries Number of entries in the index.
+   @param frames Time to seek to.
+   @return An iterator to the first event at or after `frames`, or the end of
+   `seq` if there is no such event.
+*/
+static inline LV2_Atom_Event*
+lv2_atom_sequence_index_seek(const LV2_Atom_Sequence*             seq,
+                             const LV2_Atom_Sequence_Index_Entry* entries,
+                             uint32_t                             n_entries,
+                             int64_t                              frames)
+{
+	const uint32_t i = lv2_atom_sequence_index_find(entries, n_entries, frames);
+
+	return (i < n_entries)
+		? (LV2_Atom_Event*)((const uint8_t*)&seq->body + entries[i].offset)
+		: lv2_atom_sequence_end(&seq->body, seq->atom.size);
+}
+
+/**
+   @}
+   @name Sequence Splitting
+   @{
+*/
+
+/**
+   Function to render a span of a cycle with no events.
+
+   @param handle The handle passed to lv2_atom_sequence_split().
+   @param begin The first frame of the span.
+   @param end One past the last frame of the span.
+*/
+typedef void (*LV2_Atom_Sequence_Render_Func)(void*    handle,
+                                              uint32_t begin,
+                                              uint32_t end);
+
+/**
+   Function to handle an event in a sequence.
+
+   @param handle The handle passed to lv2_atom_sequence_split().
+   @param frame The frame the event takes effect at, which may be earlier
+   than the event time stamp if splits are quantised.
+   @param ev The event.
+*/
+typedef void (*LV2_Atom_Sequence_Event_Func)(void*                 handle,
+                                             uint32_t              frame,
+                                             const LV2_Atom_Event* ev);
+
+/**
+   Run a cycle split into the largest possible spans between events.
+
+   This implements the common "render until the next event, then handle it"
+   loop.  `render` is called for every non-empty span of the cycle between
+   events, and `handle_event` is called for every event in between, so
+   several events at the same frame do not produce empty spans.  Event times
+   are clamped to the cycle, and must be frame times.
+
+   If `min_block` is greater than 1, then every span except the last is at
+   least `min_block` frames long: an event that would end a shorter span is
+   instead handled at the start of it, up to `min_block` - 1 frames early.
+   This trades timing accuracy for long runs that are cheaper to process.
+
+   Since this is inlined, the calls through `render` and `handle_event` are
+   typically direct when they are known at compile time.
+
+   @param seq Sequence of events to handle.
+   @param n_frames Number of frames in the cycle.
+   @param min_block Minimum span length, or 0 for sample accuracy.
+   @param render Function to render an event-free span.
+   @param handle_event Function to handle an event.
+   @param handle Opaque handle passed to `render` and `handle_event`.
+*/
+static inline void
+lv2_atom_sequence_split(const LV2_Atom_Sequence*      seq,
+                        uint32_t                      n_frames,
+                        uint32_t                      min_block,
+                        LV2_Atom_Sequence_Render_Func render,
+                        LV2_Atom_Sequence_Event_Func  handle_event,
+                        void*                         handle)
+{
+	uint32_t offset = 0;
+	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+		const int64_t  frames = ev->time.frames;
+		const uint32_t t      = (frames <= (int64_t)offset) ? offset
+		                      : (frames >= (int64_t)n_frames) ? n_frames
+		                      : (uint32_t)frames;
+		if (t - offset >= min_block && t > offset) {
+			render(handle, offset, t);
+			offset = t;
+		}
+
+		handle_event(handle, offset, ev);
+	}
+
+	if (offset < n_frames) {
+		render(handle, offset, n_frames);
+	}
+}
+
 /**
    @}
    @name Tuple Iterator
@@ -497,6 +1032,103 @@ lv2_atom_object_get_typed(const LV2_Atom_Object* object, ...)
 	return matches;
 }
 
+/**
+   @}
+   @name Object Decoding
+   @{
+*/
+
+/** A single field in an Object decoding schema. */
+typedef struct {
+	uint32_t key;     /**< Key of property to decode */
+	uint32_t type;    /**< Required value type, or 0 for any type */
+	uint32_t offset;  /**< Offset of destination field in output struct */
+	uint32_t size;    /**< Size of destination field in bytes */
+} LV2_Atom_Object_Field;
+
+/** Sentinel for lv2_atom_object_decode(). */
+static const LV2_Atom_Object_Field LV2_ATOM_OBJECT_FIELD_END = { 0, 0, 0, 0 };
+
+/**
+   Initialiser for an LV2_Atom_Object_Field that decodes into `member` of
+   struct type `s`.
+*/
+#define LV2_ATOM_OBJECT_FIELD(key, type, s, member) \
+	{ (key), (type), (uint32_t)offsetof(s, member), \
+	  (uint32_t)sizeof(((s*)0)->member) }
+
+/**
+   Decode an object's values into a plain struct.
+
+   The body of each property in `object` that matches a field in `fields` is
+   copied to `dest` at the field's offset.  A property matches if its key is
+   equal to the field key, its type is equal to the field type (if given), and
+   its body is no larger than the field.  Only the first matching property is
+   decoded for each field, and the remainder of a field larger than the value
+   is left untouched.  This function reads `object` in a single linear sweep
+   and is realtime safe.
+
+   The schema is typically built once when the plugin is instantiated, for
+   example:
+
+   @code
+   typedef struct {
+       float   gain;
+       int32_t mode;
+   } Settings;
+
+   // In instantiate()
+   const LV2_Atom_Object_Field fields[] = {
+       LV2_ATOM_OBJECT_FIELD(uris.eg_gain, uris.atom_Float, Settings, gain),
+       LV2_ATOM_OBJECT_FIELD(uris.eg_mode, uris.atom_Int, Settings, mode),
+       LV2_ATOM_OBJECT_FIELD_END
+   };
+
+   // In run()
+   Settings       settings;
+   const uint32_t found = lv2_atom_object_decode(obj, fields, &settings);
+   if (found & (1u << 0)) {
+       // settings.gain was set
+   }
+   @endcode
+
+   @param object The object to decode.
+   @param fields Array of fields terminated by LV2_ATOM_OBJECT_FIELD_END.  At
+   most 32 fields are supported.
+   @param dest Struct to write decoded values to.
+   @return A bitmask where bit `i` is set iff `fields[i]` was decoded.
+*/
+static inline uint32_t
+lv2_atom_object_decode(const LV2_Atom_Object*       object,
+                       const LV2_Atom_Object_Field* fields,
+                       void*                        dest)
+{
+	uint32_t n_fields = 0;
+	while (fields[n_fields].key && n_fields < 32) {
+		++n_fields;
+	}
+
+	const uint32_t all   = n_fields ? (0xFFFFFFFFu >> (32 - n_fields)) : 0;
+	uint32_t       found = 0;
+	LV2_ATOM_OBJECT_FOREACH(object, prop) {
+		for (uint32_t i = 0; i < n_fields; ++i) {
+			const LV2_Atom_Object_Field* f = &fields[i];
+			if (f->key == prop->key && !(found & (1u << i)) &&
+			    (!f->type || f->type == prop->value.type) &&
+			    prop->value.size <= f->size) {
+				memcpy((uint8_t*)dest + f->offset,
+				       &prop->value + 1,
+				       prop->value.size);
+				if ((found |= (1u << i)) == all) {
+					return found;
+				}
+				break;
+			}
+		}
+	}
+	return found;
+}
+
 /**
    @}
    @}
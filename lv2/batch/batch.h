@@ -0,0 +1,101 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @defgroup batch Batch
+
+   Running many instances of a plugin in a single call, see
+   <http://lv2plug.in/ns/ext/batch> for details.
+
+   @{
+*/
+
+#ifndef LV2_BATCH_H
+#define LV2_BATCH_H
+
+#include "lv2/core/lv2.h"
+
+#include <stdint.h>
+
+#define LV2_BATCH_URI    "http://lv2plug.in/ns/ext/batch"  ///< http://lv2plug.in/ns/ext/batch
+#define LV2_BATCH_PREFIX LV2_BATCH_URI "#"                ///< http://lv2plug.in/ns/ext/batch#
+
+#define LV2_BATCH__interface LV2_BATCH_PREFIX "interface"  ///< http://lv2plug.in/ns/ext/batch#interface
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+   Batch interface (extension data).
+
+   This is returned by LV2_Descriptor::extension_data() for
+   #LV2_BATCH__interface.
+*/
+typedef struct {
+	/**
+	   Run several instances for `sample_count` frames.
+
+	   This has the same effect as calling LV2_Descriptor::run() on each
+	   instance in order, and the same requirements apply to every instance.
+	   All instances MUST have been created from the descriptor that returned
+	   this interface, and no instance may appear more than once.  Instances
+	   may share buffers, including in-place input and output, unless the
+	   plugin is lv2:inPlaceBroken.
+
+	   This function is in the ``audio'' threading class for every instance
+	   in `instances`.
+
+	   @param instances Array of `n_instances` plugin instances.
+	   @param n_instances Number of instances, which may be zero.
+	   @param sample_count The block size (in samples) for every instance.
+	*/
+	void (*run)(const LV2_Handle* instances,
+	            uint32_t          n_instances,
+	            uint32_t          sample_count);
+} LV2_Batch_Interface;
+
+/**
+   Run several instances, using the batch interface if the plugin has one.
+
+   If `batch` is NULL, this simply calls LV2_Descriptor::run() on each
+   instance in turn, so hosts can use it regardless of plugin support.
+*/
+static inline void
+lv2_batch_run(const LV2_Descriptor*      descriptor,
+              const LV2_Batch_Interface* batch,
+              const LV2_Handle*          instances,
+              uint32_t                   n_instances,
+              uint32_t                   sample_count)
+{
+	if (batch) {
+		batch->run(instances, n_instances, sample_count);
+	} else {
+		for (uint32_t i = 0; i < n_instances; ++i) {
+			descriptor->run(instances[i], sample_count);
+		}
+	}
+}
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif  /* LV2_BATCH_H */
+
+/**
+   @}
+*/
@@ -0,0 +1,222 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   Benchmark of converting between event buffers and atom sequences.
+
+   Every operation is one event.  The "iter" cases convert one event at a
+   time with the event helpers and the sequence writer, for comparison.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "lv2/atom/atom-bench-utils.c"
+#include "lv2/atom/atom.h"
+#include "lv2/atom/util.h"
+#include "lv2/core/attributes.h"
+#include "lv2/event/bridge.h"
+#include "lv2/event/event-helpers.h"
+#include "lv2/event/event.h"
+#include "lv2/urid/urid.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+LV2_DISABLE_DEPRECATION_WARNINGS
+
+#define CAPACITY   (1u << 16u)
+#define N_EVENTS   1024u
+#define EVENT_MIDI 1u
+#define EVENT_BLOB 2u
+#define ATOM_MIDI  10u
+#define ATOM_BLOB  20u
+
+typedef struct {
+	LV2_Event_Bridge   bridge;
+	uint64_t           buf_data[CAPACITY / sizeof(uint64_t)];
+	LV2_Event_Buffer   buf;    ///< Input event buffer
+	uint64_t           seq_buf[CAPACITY / sizeof(uint64_t)];
+	LV2_Atom_Sequence* seq;    ///< Input sequence in seq_buf
+	uint64_t           out_data[CAPACITY / sizeof(uint64_t)];
+	LV2_Event_Buffer   out;    ///< Output event buffer
+	uint64_t           out_seq_buf[CAPACITY / sizeof(uint64_t)];
+	LV2_Atom_Sequence* out_seq;  ///< Output sequence in out_seq_buf
+	uint32_t           n_bad;  ///< Number of incorrect results
+} Context;
+
+/** Map the time units used by the bridge, the only URIs it maps. */
+static LV2_URID
+map_uri(LV2_URID_Map_Handle handle, const char* uri)
+{
+	return strcmp(uri, LV2_ATOM__frameTime) ? 31u : 30u;
+}
+
+/** Write the input buffer, with a 32-byte blob every `blob_period` events. */
+static void
+write_input(Context* ctx, uint32_t blob_period)
+{
+	static const uint8_t blob[32] = { 0 };
+
+	LV2_Event_Iterator iter;
+	ctx->buf.capacity = CAPACITY;
+	lv2_event_buffer_reset(
+		&ctx->buf, LV2_EVENT_AUDIO_STAMP, (uint8_t*)ctx->buf_data);
+	lv2_event_begin(&iter, &ctx->buf);
+	for (uint32_t i = 0; i < N_EVENTS; ++i) {
+		const uint8_t msg[] = { 0x90, (uint8_t)(i % 128), 100 };
+		if (blob_period && i % blob_period == blob_period - 1) {
+			lv2_event_write(&iter, i, 0, EVENT_BLOB, sizeof(blob), blob);
+		} else {
+			lv2_event_write(&iter, i, 0, EVENT_MIDI, 3, msg);
+		}
+	}
+
+	LV2_Atom_Sequence_Writer writer;
+	lv2_atom_sequence_clear(ctx->seq);
+	lv2_atom_sequence_writer_init(
+		&writer, ctx->seq, CAPACITY - sizeof(LV2_Atom));
+	ctx->n_bad += lv2_event_bridge_to_sequence(
+		&ctx->bridge, &ctx->buf, &writer);
+}
+
+static void
+to_sequence(void* data)
+{
+	Context* const ctx = (Context*)data;
+
+	LV2_Atom_Sequence_Writer writer;
+	lv2_atom_sequence_clear(ctx->out_seq);
+	lv2_atom_sequence_writer_init(
+		&writer, ctx->out_seq, CAPACITY - sizeof(LV2_Atom));
+	ctx->n_bad += lv2_event_bridge_to_sequence(
+		&ctx->bridge, &ctx->buf, &writer);
+}
+
+static void
+to_buffer(void* data)
+{
+	Context* const ctx = (Context*)data;
+
+	lv2_event_buffer_reset(
+		&ctx->out, LV2_EVENT_AUDIO_STAMP, (uint8_t*)ctx->out_data);
+	ctx->n_bad += lv2_event_bridge_to_buffer(
+		&ctx->bridge, ctx->seq, &ctx->out);
+}
+
+/** Convert to a sequence one event at a time with the event helpers. */
+static void
+to_sequence_iter(void* data)
+{
+	Context* const ctx = (Context*)data;
+
+	LV2_Atom_Sequence_Writer writer;
+	lv2_atom_sequence_clear(ctx->out_seq);
+	lv2_atom_sequence_writer_init(
+		&writer, ctx->out_seq, CAPACITY - sizeof(LV2_Atom));
+
+	LV2_Event_Iterator iter;
+	for (lv2_event_begin(&iter, &ctx->buf); lv2_event_is_valid(&iter);
+	     lv2_event_increment(&iter)) {
+		uint8_t*               body = NULL;
+		const LV2_Event* const ev   = lv2_event_get(&iter, &body);
+		const LV2_URID         type = lv2_event_bridge_atom_type(
+			&ctx->bridge, ev->type);
+		void* const out = lv2_atom_sequence_writer_reserve(
+			&writer, ev->frames, type, ev->size);
+		if (out) {
+			memcpy(out, body, ev->size);
+		} else {
+			++ctx->n_bad;
+		}
+	}
+}
+
+/** Convert to a buffer one event at a time with the event helpers. */
+static void
+to_buffer_iter(void* data)
+{
+	Context* const ctx = (Context*)data;
+
+	LV2_Event_Iterator iter;
+	lv2_event_buffer_reset(
+		&ctx->out, LV2_EVENT_AUDIO_STAMP, (uint8_t*)ctx->out_data);
+	lv2_event_begin(&iter, &ctx->out);
+	LV2_ATOM_SEQUENCE_FOREACH(ctx->seq, ev) {
+		const uint16_t type = lv2_event_bridge_event_type(
+			&ctx->bridge, ev->body.type);
+		if (!lv2_event_write(&iter,
+		                     (uint32_t)ev->time.frames,
+		                     0,
+		                     type,
+		                     (uint16_t)ev->body.size,
+		                     (const uint8_t*)(ev + 1))) {
+			++ctx->n_bad;
+		}
+	}
+}
+
+int
+main(void)
+{
+	static Context ctx;
+	ctx.seq          = (LV2_Atom_Sequence*)ctx.seq_buf;
+	ctx.out_seq      = (LV2_Atom_Sequence*)ctx.out_seq_buf;
+	ctx.out.capacity = CAPACITY;
+
+	LV2_URID_Map map = { NULL, map_uri };
+	lv2_event_bridge_init(&ctx.bridge, &map);
+	lv2_event_bridge_add_type(&ctx.bridge, EVENT_MIDI, ATOM_MIDI);
+	lv2_event_bridge_add_type(&ctx.bridge, EVENT_BLOB, ATOM_BLOB);
+
+	static const char* const names[]   = { "midi", "mixed" };
+	static const uint32_t    periods[] = { 0, 8 };
+
+	bench_begin();
+
+	for (uint32_t t = 0; t < 2; ++t) {
+		write_input(&ctx, periods[t]);
+
+		char name[48];
+		snprintf(name, sizeof(name), "to_sequence_%s", names[t]);
+		bench_run(name, to_sequence, &ctx, N_EVENTS);
+		ctx.n_bad += ctx.out_seq->atom.size != ctx.seq->atom.size;
+
+		snprintf(name, sizeof(name), "to_sequence_%s_iter", names[t]);
+		bench_run(name, to_sequence_iter, &ctx, N_EVENTS);
+
+		snprintf(name, sizeof(name), "to_buffer_%s", names[t]);
+		bench_run(name, to_buffer, &ctx, N_EVENTS);
+		ctx.n_bad += (ctx.out.size != ctx.buf.size ||
+		              ctx.out.event_count != N_EVENTS ||
+		              memcmp(ctx.out_data, ctx.buf_data, ctx.buf.size));
+
+		snprintf(name, sizeof(name), "to_buffer_%s_iter", names[t]);
+		bench_run(name, to_buffer_iter, &ctx, N_EVENTS);
+	}
+
+	bench_end();
+
+	if (ctx.n_bad) {
+		fprintf(stderr, "error: %u incorrect results\n", ctx.n_bad);
+		return 1;
+	}
+
+	return 0;
+}
+
+LV2_RESTORE_WARNINGS
@@ -0,0 +1,394 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "lv2/atom/atom-test-utils.c"
+#include "lv2/atom/atom.h"
+#include "lv2/atom/util.h"
+#include "lv2/core/attributes.h"
+#include "lv2/event/bridge.h"
+#include "lv2/event/event-helpers.h"
+#include "lv2/event/event.h"
+#include "lv2/midi/midi.h"
+#include "lv2/urid/urid.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+LV2_DISABLE_DEPRECATION_WARNINGS
+
+#define CAPACITY 2048u
+
+/** Event type IDs, as a host would get them from the URI map. */
+#define EVENT_MIDI     3u
+#define EVENT_OTHER    7u
+#define EVENT_UNMAPPED 9u
+
+static LV2_URID_Map     map = { NULL, urid_map };
+static LV2_URID         midi_MidiEvent;
+static LV2_URID         atom_Chunk;
+static LV2_URID         atom_frameTime;
+static LV2_URID         atom_beatTime;
+static LV2_Event_Bridge bridge;
+
+static uint64_t           buf_data[CAPACITY / sizeof(uint64_t)];
+static LV2_Event_Buffer   buf;
+static uint64_t           seq_buf[CAPACITY / sizeof(uint64_t)];
+static LV2_Atom_Sequence* seq = (LV2_Atom_Sequence*)seq_buf;
+static uint64_t           seq2_buf[CAPACITY / sizeof(uint64_t)];
+static LV2_Atom_Sequence* seq2 = (LV2_Atom_Sequence*)seq2_buf;
+
+/** Reset the event buffer to be empty with the given capacity. */
+static void
+reset_buffer(uint32_t capacity)
+{
+	buf.capacity = capacity;
+	lv2_event_buffer_reset(&buf, LV2_EVENT_AUDIO_STAMP, (uint8_t*)buf_data);
+}
+
+/** Clear `s` and set up `writer` to append to it. */
+static void
+begin_sequence(LV2_Atom_Sequence*        s,
+               LV2_Atom_Sequence_Writer* writer,
+               uint32_t                  capacity)
+{
+	lv2_atom_sequence_clear(s);
+	lv2_atom_sequence_writer_init(writer, s, capacity);
+}
+
+/** Return true if sequences `a` and `b` have identical events. */
+static bool
+sequences_equal(const LV2_Atom_Sequence* a, const LV2_Atom_Sequence* b)
+{
+	if (a->atom.size != b->atom.size) {
+		return false;
+	}
+
+	const LV2_Atom_Event* e = lv2_atom_sequence_begin(&b->body);
+	LV2_ATOM_SEQUENCE_FOREACH(a, ev) {
+		if (ev->time.frames != e->time.frames ||
+		    ev->body.type != e->body.type ||
+		    ev->body.size != e->body.size ||
+		    memcmp(ev + 1, e + 1, ev->body.size)) {
+			return false;
+		}
+		e = lv2_atom_sequence_next(e);
+	}
+
+	return true;
+}
+
+static int
+test_types(void)
+{
+	LV2_Event_Bridge b;
+	lv2_event_bridge_init(&b, &map);
+	if (lv2_event_bridge_add_type(&b, 0, midi_MidiEvent) ||
+	    lv2_event_bridge_add_type(&b, EVENT_MIDI, 0) ||
+	    !lv2_event_bridge_add_type(&b, EVENT_MIDI, midi_MidiEvent) ||
+	    lv2_event_bridge_add_type(&b, EVENT_MIDI, atom_Chunk) ||
+	    lv2_event_bridge_add_type(&b, EVENT_OTHER, midi_MidiEvent)) {
+		return test_fail("Invalid type mapping added\n");
+	}
+
+	if (lv2_event_bridge_atom_type(&b, EVENT_MIDI) != midi_MidiEvent ||
+	    lv2_event_bridge_atom_type(&b, EVENT_OTHER) ||
+	    lv2_event_bridge_event_type(&b, midi_MidiEvent) != EVENT_MIDI ||
+	    lv2_event_bridge_event_type(&b, atom_Chunk)) {
+		return test_fail("Incorrect type mapping\n");
+	}
+
+	for (uint32_t i = 1; i < LV2_EVENT_BRIDGE_MAX_TYPES; ++i) {
+		if (!lv2_event_bridge_add_type(&b, (uint16_t)(100 + i), 100 + i)) {
+			return test_fail("Failed to add type %u\n", i);
+		}
+	}
+
+	if (lv2_event_bridge_add_type(&b, 200, 200)) {
+		return test_fail("Type added to full bridge\n");
+	}
+
+	return 0;
+}
+
+static int
+test_to_sequence(void)
+{
+	static const uint8_t note_on[]  = { 0x90, 60, 100 };
+	static const uint8_t note_off[] = { 0x80, 60, 64 };
+	static const uint8_t other[]    = { 1, 2, 3, 4, 5 };
+
+	LV2_Event_Iterator iter;
+	reset_buffer(CAPACITY);
+	lv2_event_begin(&iter, &buf);
+	lv2_event_write(&iter, 0, 0, EVENT_MIDI, 3, note_on);
+	lv2_event_write(&iter, 1, 0, 0, 5, other);  // Non-POD, dropped
+	lv2_event_write(&iter, 2, 0, EVENT_UNMAPPED, 5, other);  // Dropped
+	lv2_event_write(&iter, 3, 99, EVENT_MIDI, 3, note_off);
+	lv2_event_write(&iter, 4, 0, EVENT_MIDI, 0, note_on);
+
+	LV2_Atom_Sequence_Writer writer;
+	begin_sequence(seq, &writer, CAPACITY - sizeof(LV2_Atom));
+	if (lv2_event_bridge_to_sequence(&bridge, &buf, &writer) != 2) {
+		return test_fail("Incorrect number of dropped events\n");
+	}
+
+	static const int64_t  frames[] = { 0, 3, 4 };
+	static const uint32_t sizes[]  = { 3, 3, 0 };
+	const uint8_t* const  bodies[] = { note_on, note_off, NULL };
+
+	uint32_t n_events = 0;
+	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+		if (n_events == 3 ||
+		    ev->time.frames != frames[n_events] ||
+		    ev->body.type != midi_MidiEvent ||
+		    ev->body.size != sizes[n_events] ||
+		    (sizes[n_events] &&
+		     memcmp(ev + 1, bodies[n_events], sizes[n_events]))) {
+			return test_fail("Incorrect event %u in sequence\n", n_events);
+		}
+		++n_events;
+	}
+
+	if (n_events != 3 || writer.head != (uint8_t*)lv2_atom_sequence_end(
+		    &seq->body, seq->atom.size)) {
+		return test_fail("Incorrect sequence size\n");
+	}
+
+	return 0;
+}
+
+static int
+test_round_trip(void)
+{
+	// Write MIDI events of every size up to 24 bytes, and some other atoms
+	uint8_t                  body[24];
+	LV2_Atom_Sequence_Writer writer;
+	begin_sequence(seq, &writer, CAPACITY - sizeof(LV2_Atom));
+	for (uint32_t i = 0; i < 24; ++i) {
+		for (uint32_t j = 0; j < i; ++j) {
+			body[j] = (uint8_t)(i + j);
+		}
+
+		const LV2_URID type = (i % 5 == 4) ? atom_Chunk : midi_MidiEvent;
+		void* const    out  = lv2_atom_sequence_writer_reserve(
+			&writer, (int64_t)i * 10, type, i);
+		if (!out) {
+			return test_fail("Failed to write input event %u\n", i);
+		}
+		memcpy(out, body, i);
+	}
+
+	// Convert to a buffer and back
+	reset_buffer(CAPACITY);
+	begin_sequence(seq2, &writer, CAPACITY - sizeof(LV2_Atom));
+	if (lv2_event_bridge_to_buffer(&bridge, seq, &buf) ||
+	    buf.event_count != 24 ||
+	    lv2_event_bridge_to_sequence(&bridge, &buf, &writer) ||
+	    !sequences_equal(seq, seq2)) {
+		return test_fail("Round trip through event buffer failed\n");
+	}
+
+	// Check the buffer can be read with the event helpers
+	LV2_Event_Iterator iter;
+	uint32_t           n_events = 0;
+	for (lv2_event_begin(&iter, &buf); lv2_event_is_valid(&iter);
+	     lv2_event_increment(&iter)) {
+		uint8_t*               data = NULL;
+		const LV2_Event* const ev   = lv2_event_get(&iter, &data);
+		if (ev->frames != n_events * 10 || ev->subframes ||
+		    ev->size != n_events ||
+		    ev->type != (n_events % 5 == 4 ? EVENT_OTHER : EVENT_MIDI) ||
+		    (n_events && data[0] != (uint8_t)n_events)) {
+			return test_fail("Incorrect event %u in buffer\n", n_events);
+		}
+		++n_events;
+	}
+
+	if (n_events != 24) {
+		return test_fail("Incorrect number of events in buffer\n");
+	}
+
+	// Appending to a buffer keeps the events already in it
+	if (lv2_event_bridge_to_buffer(&bridge, seq, &buf) ||
+	    buf.event_count != 48) {
+		return test_fail("Incorrect append to event buffer\n");
+	}
+
+	return 0;
+}
+
+static int
+test_overflow(void)
+{
+	static const uint8_t note_on[] = { 0x90, 60, 100 };
+
+	// Write 4 notes to a sequence
+	LV2_Atom_Sequence_Writer writer;
+	begin_sequence(seq, &writer, CAPACITY - sizeof(LV2_Atom));
+	for (uint32_t i = 0; i < 4; ++i) {
+		uint8_t* const msg = (uint8_t*)lv2_atom_sequence_writer_reserve(
+			&writer, i, midi_MidiEvent, 3);
+		memcpy(msg, note_on, 3);
+	}
+
+	// Only 2 notes fit in a buffer of 36 bytes, since each takes 16
+	reset_buffer(36);
+	if (lv2_event_bridge_to_buffer(&bridge, seq, &buf) != 2 ||
+	    buf.event_count != 2 || buf.size != 32) {
+		return test_fail("Incorrect event buffer overflow\n");
+	}
+
+	// Only 1 note fits in a sequence of 40 bytes, since each takes 24
+	begin_sequence(seq2, &writer, sizeof(LV2_Atom_Sequence_Body) + 40);
+	if (lv2_event_bridge_to_sequence(&bridge, &buf, &writer) != 1 ||
+	    seq2->atom.size != sizeof(LV2_Atom_Sequence_Body) + 24) {
+		return test_fail("Incorrect sequence overflow\n");
+	}
+
+	// A truncated event at the end of a buffer is dropped
+	reset_buffer(CAPACITY);
+	LV2_Event_Iterator iter;
+	lv2_event_begin(&iter, &buf);
+	lv2_event_write(&iter, 0, 0, EVENT_MIDI, 3, note_on);
+	lv2_event_write(&iter, 1, 0, EVENT_MIDI, 3, note_on);
+	buf.size -= 2;
+	begin_sequence(seq2, &writer, CAPACITY - sizeof(LV2_Atom));
+	if (lv2_event_bridge_to_sequence(&bridge, &buf, &writer) != 1 ||
+	    seq2->atom.size != sizeof(LV2_Atom_Sequence_Body) + 24) {
+		return test_fail("Truncated event not dropped\n");
+	}
+
+	// A truncated event at the end of a sequence is dropped
+	begin_sequence(seq, &writer, CAPACITY - sizeof(LV2_Atom));
+	lv2_atom_sequence_writer_reserve(&writer, 0, midi_MidiEvent, 3);
+	lv2_atom_sequence_writer_reserve(&writer, 1, midi_MidiEvent, 3);
+	seq->atom.size -= 8;
+	reset_buffer(CAPACITY);
+	if (lv2_event_bridge_to_buffer(&bridge, seq, &buf) != 1 ||
+	    buf.event_count != 1 || buf.size != 16) {
+		return test_fail("Truncated atom event not dropped\n");
+	}
+
+	// An event header that does not fit in a sequence is ignored
+	seq->atom.size -= 8;
+	reset_buffer(CAPACITY);
+	if (lv2_event_bridge_to_buffer(&bridge, seq, &buf) ||
+	    buf.event_count != 1 || buf.size != 16) {
+		return test_fail("Read partial atom event header\n");
+	}
+
+	// An atom too large for an event is dropped
+	static uint64_t    big_buf[(UINT16_MAX + 64) / sizeof(uint64_t)];
+	LV2_Atom_Sequence* big = (LV2_Atom_Sequence*)big_buf;
+	begin_sequence(big, &writer, sizeof(big_buf) - sizeof(LV2_Atom));
+	if (!lv2_atom_sequence_writer_reserve(
+		    &writer, 0, midi_MidiEvent, UINT16_MAX + 1u)) {
+		return test_fail("Failed to write large event\n");
+	}
+
+	reset_buffer(CAPACITY);
+	if (lv2_event_bridge_to_buffer(&bridge, big, &buf) != 1 ||
+	    buf.event_count) {
+		return test_fail("Event that is too large not dropped\n");
+	}
+
+	return 0;
+}
+
+static int
+test_time_stamps(void)
+{
+	static const uint8_t note_on[] = { 0x90, 60, 100 };
+
+	// A buffer with some other stamp type is not converted
+	LV2_Event_Iterator iter;
+	reset_buffer(CAPACITY);
+	buf.stamp_type = LV2_EVENT_AUDIO_STAMP + 1;
+	lv2_event_begin(&iter, &buf);
+	lv2_event_write(&iter, 0, 0, EVENT_MIDI, 3, note_on);
+	lv2_event_write(&iter, 1, 0, EVENT_MIDI, 3, note_on);
+
+	LV2_Atom_Sequence_Writer writer;
+	begin_sequence(seq, &writer, CAPACITY - sizeof(LV2_Atom));
+	if (lv2_event_bridge_to_sequence(&bridge, &buf, &writer) != 2 ||
+	    seq->atom.size != sizeof(LV2_Atom_Sequence_Body)) {
+		return test_fail("Buffer with non-audio stamps converted\n");
+	}
+
+	// Nor is a buffer with audio stamps to a beat-timed sequence
+	buf.stamp_type = LV2_EVENT_AUDIO_STAMP;
+	begin_sequence(seq, &writer, CAPACITY - sizeof(LV2_Atom));
+	seq->body.unit = atom_beatTime;
+	if (lv2_event_bridge_to_sequence(&bridge, &buf, &writer) != 2 ||
+	    seq->atom.size != sizeof(LV2_Atom_Sequence_Body)) {
+		return test_fail("Buffer converted to beat-timed sequence\n");
+	}
+
+	// A sequence with explicit frame time is converted
+	seq->body.unit = atom_frameTime;
+	if (lv2_event_bridge_to_sequence(&bridge, &buf, &writer) ||
+	    seq->atom.size != sizeof(LV2_Atom_Sequence_Body) + 48) {
+		return test_fail("Failed to convert to frame-timed sequence\n");
+	}
+
+	// Converting to a buffer sets its stamp type
+	reset_buffer(CAPACITY);
+	buf.stamp_type = LV2_EVENT_AUDIO_STAMP + 1;
+	if (lv2_event_bridge_to_buffer(&bridge, seq, &buf) ||
+	    buf.stamp_type != LV2_EVENT_AUDIO_STAMP || buf.event_count != 2) {
+		return test_fail("Incorrect buffer from frame-timed sequence\n");
+	}
+
+	// But not appending to a buffer with other stamps
+	buf.stamp_type = LV2_EVENT_AUDIO_STAMP + 1;
+	if (lv2_event_bridge_to_buffer(&bridge, seq, &buf) != 2 ||
+	    buf.event_count != 2) {
+		return test_fail("Appended to buffer with non-audio stamps\n");
+	}
+
+	// A beat-timed sequence is not converted
+	seq->body.unit = atom_beatTime;
+	reset_buffer(CAPACITY);
+	if (lv2_event_bridge_to_buffer(&bridge, seq, &buf) != 2 ||
+	    buf.event_count || buf.size) {
+		return test_fail("Beat-timed sequence converted\n");
+	}
+
+	return 0;
+}
+
+int
+main(void)
+{
+	midi_MidiEvent = map.map(map.handle, LV2_MIDI__MidiEvent);
+	atom_Chunk     = map.map(map.handle, LV2_ATOM__Chunk);
+	atom_frameTime = map.map(map.handle, LV2_ATOM__frameTime);
+	atom_beatTime  = map.map(map.handle, LV2_ATOM__beatTime);
+
+	lv2_event_bridge_init(&bridge, &map);
+	lv2_event_bridge_add_type(&bridge, EVENT_MIDI, midi_MidiEvent);
+	lv2_event_bridge_add_type(&bridge, EVENT_OTHER, atom_Chunk);
+
+	const int ret = (test_types() || test_to_sequence() ||
+	                 test_round_trip() || test_overflow() ||
+	                 test_time_stamps());
+
+	free_urid_map();
+	return ret;
+}
+
+LV2_RESTORE_WARNINGS
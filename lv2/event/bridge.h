@@ -0,0 +1,370 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @defgroup bridge Atom Bridge
+   @ingroup event
+
+   Conversion between event buffers and atom sequences.
+
+   A host that supports plugins with old event ports alongside plugins with
+   atom ports must convert between the two formats every cycle.  The bridge
+   converts a whole buffer in a single pass, writing each event directly to
+   the output, and maps event types with a small table that is set up once
+   in advance.  Since the mapping is only looked up when the type changes, a
+   run of events with the same type, like a stream of MIDI, is copied with no
+   lookups at all.
+
+   Only buffers with audio frame time stamps (LV2_EVENT_AUDIO_STAMP), and
+   sequences with frame time stamps (no unit, or atom:frameTime), can be
+   converted.  Anything else, such as a sequence with atom:beatTime stamps,
+   is refused and all of its events are counted as dropped.  Sequences have
+   no subframes, so subframes are discarded when converting to a sequence and
+   are zero when converting to a buffer.
+   Non-POD events (with type 0) can not be copied, so they are never
+   converted, and remain the responsibility of the host.
+
+   For example, a host can convert the output of an event plugin to a
+   sequence for an atom plugin with:
+
+   @code
+   lv2_event_bridge_init(&bridge, map);
+   lv2_event_bridge_add_type(&bridge, midi_event_type, midi_MidiEvent);
+
+   LV2_Atom_Sequence_Writer writer;
+   lv2_atom_sequence_clear(seq);
+   lv2_atom_sequence_writer_init(&writer, seq, capacity);
+   lv2_event_bridge_to_sequence(&bridge, event_buffer, &writer);
+   @endcode
+
+   @{
+*/
+
+#ifndef LV2_EVENT_BRIDGE_H
+#define LV2_EVENT_BRIDGE_H
+
+#include "lv2/atom/atom.h"
+#include "lv2/atom/util.h"
+#include "lv2/core/attributes.h"
+#include "lv2/event/event.h"
+#include "lv2/urid/urid.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+LV2_DISABLE_DEPRECATION_WARNINGS
+
+/** The maximum number of types that can be mapped by a bridge. */
+#define LV2_EVENT_BRIDGE_MAX_TYPES 16u
+
+/** A mapping between an event type and an atom type. */
+typedef struct {
+	uint16_t event_type;  /**< Event type, as mapped by the URI map */
+	LV2_URID atom_type;   /**< Atom type, as mapped by the URID map */
+} LV2_Event_Bridge_Type;
+
+/**
+   A bridge between event buffers and atom sequences.
+
+   This is a plain struct that can be allocated anywhere, it must be
+   initialised with lv2_event_bridge_init() before use.
+*/
+typedef struct {
+	LV2_Event_Bridge_Type types[LV2_EVENT_BRIDGE_MAX_TYPES];  /**< Types */
+	uint32_t              n_types;         /**< Number of types */
+	LV2_URID              atom_frameTime;  /**< Sequence unit for frames */
+	LV2_URID              atom_beatTime;   /**< Sequence unit for beats */
+} LV2_Event_Bridge;
+
+/**
+   Initialise `bridge` with no types, so every event is dropped.
+
+   The URID map is used to map the time units of sequences, a reference to
+   it is not held.
+*/
+static inline void
+lv2_event_bridge_init(LV2_Event_Bridge* bridge, LV2_URID_Map* map)
+{
+	bridge->n_types        = 0;
+	bridge->atom_frameTime = map->map(map->handle, LV2_ATOM__frameTime);
+	bridge->atom_beatTime  = map->map(map->handle, LV2_ATOM__beatTime);
+}
+
+/**
+   Map events of type `event_type` to atoms of type `atom_type`.
+
+   Both types must be non-zero, and neither may already be mapped, so that
+   events are converted back to their original type.  Typically, the host
+   adds midi:MidiEvent here, with the event type that the URI map returns
+   for the same URI.
+
+   @return True on success, or false if the types are invalid, already
+   mapped, or the bridge is full.
+*/
+static inline bool
+lv2_event_bridge_add_type(LV2_Event_Bridge* bridge,
+                          uint16_t          event_type,
+                          LV2_URID          atom_type)
+{
+	if (!event_type || !atom_type ||
+	    bridge->n_types == LV2_EVENT_BRIDGE_MAX_TYPES) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < bridge->n_types; ++i) {
+		if (bridge->types[i].event_type == event_type ||
+		    bridge->types[i].atom_type == atom_type) {
+			return false;
+		}
+	}
+
+	bridge->types[bridge->n_types].event_type = event_type;
+	bridge->types[bridge->n_types].atom_type  = atom_type;
+	++bridge->n_types;
+	return true;
+}
+
+/** Return the atom type for `event_type`, or 0 if it is not mapped. */
+static inline LV2_URID
+lv2_event_bridge_atom_type(const LV2_Event_Bridge* bridge, uint16_t event_type)
+{
+	for (uint32_t i = 0; i < bridge->n_types; ++i) {
+		if (bridge->types[i].event_type == event_type) {
+			return bridge->types[i].atom_type;
+		}
+	}
+
+	return 0;
+}
+
+/** Return the event type for `atom_type`, or 0 if it is not mapped. */
+static inline uint16_t
+lv2_event_bridge_event_type(const LV2_Event_Bridge* bridge, LV2_URID atom_type)
+{
+	for (uint32_t i = 0; i < bridge->n_types; ++i) {
+		if (bridge->types[i].atom_type == atom_type) {
+			return bridge->types[i].event_type;
+		}
+	}
+
+	return 0;
+}
+
+/**
+   Return true if a sequence with time `unit` is stamped with audio frames.
+
+   The unit of a sequence is zero or atom:frameTime for frames, anything
+   else, like atom:beatTime, can not be converted to an event time stamp.
+*/
+static inline bool
+lv2_event_bridge_is_frame_time(const LV2_Event_Bridge* bridge, LV2_URID unit)
+{
+	return unit != bridge->atom_beatTime &&
+	       (!unit || unit == bridge->atom_frameTime);
+}
+
+/** Return the number of events in `seq`. */
+static inline uint32_t
+lv2_event_bridge_count(const LV2_Atom_Sequence* seq)
+{
+	uint32_t n_events = 0;
+	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+		++n_events;
+	}
+	return n_events;
+}
+
+/**
+   Return the padded size of an event with a body of `size` bytes.
+
+   Unlike lv2_event_pad_size(), this can not overflow for large events.
+*/
+static inline uint32_t
+lv2_event_bridge_padded_size(uint32_t size)
+{
+	return ((uint32_t)sizeof(LV2_Event) + size + 7u) & ~7u;
+}
+
+/**
+   Copy a small event body.
+
+   Most events are short MIDI messages, which are faster to copy a byte at a
+   time than with a call to memcpy() for a variable size.
+*/
+static inline void
+lv2_event_bridge_copy(void* dst, const void* src, uint32_t size)
+{
+	if (size <= 4) {
+		uint8_t* const       d = (uint8_t*)dst;
+		const uint8_t* const s = (const uint8_t*)src;
+		for (uint32_t i = 0; i < size; ++i) {
+			d[i] = s[i];
+		}
+	} else {
+		memcpy(dst, src, size);
+	}
+}
+
+/**
+   Append the events in an event buffer to a sequence.
+
+   @param bridge The bridge with the types to convert.
+   @param in Input event buffer, stamped with audio frames.
+   @param out Writer for the output sequence, which must have frame time.
+   @return The number of events that were dropped, because their type is not
+   mapped or the output was full, which is 0 on success.  If either time
+   stamp type can not be converted, every event is dropped.
+*/
+static inline uint32_t
+lv2_event_bridge_to_sequence(const LV2_Event_Bridge*   bridge,
+                             const LV2_Event_Buffer*   in,
+                             LV2_Atom_Sequence_Writer* out)
+{
+	const uint8_t* const end       = in->data + in->size;
+	const uint8_t*       ptr       = in->data;
+	uint8_t*             head      = out->head;
+	uint16_t             last_type = 0;
+	LV2_URID             atom_type = 0;
+	uint32_t             n_dropped = 0;
+
+	if (in->stamp_type != LV2_EVENT_AUDIO_STAMP ||
+	    !lv2_event_bridge_is_frame_time(bridge, out->seq->body.unit)) {
+		return in->event_count;
+	}
+
+	while (ptr < end && (uint32_t)(end - ptr) >= sizeof(LV2_Event)) {
+		const LV2_Event* const ev   = (const LV2_Event*)ptr;
+		const uint32_t         size = ev->size;
+		if ((uint32_t)(end - ptr) - sizeof(LV2_Event) < size) {
+			++n_dropped;  // Truncated event at the end of the buffer
+			break;
+		}
+
+		ptr += lv2_event_bridge_padded_size(size);
+		if (ev->type != last_type) {
+			last_type = ev->type;
+			atom_type = lv2_event_bridge_atom_type(bridge, ev->type);
+		}
+
+		const uint32_t total = (uint32_t)sizeof(LV2_Atom_Event) + size;
+		if (!atom_type || head >= out->limit ||
+		    (uint32_t)(out->limit - head) < total) {
+			++n_dropped;
+			continue;
+		}
+
+		LV2_Atom_Event* const out_ev = (LV2_Atom_Event*)head;
+		out_ev->time.frames = ev->frames;
+		out_ev->body.size   = size;
+		out_ev->body.type   = atom_type;
+		lv2_event_bridge_copy(out_ev + 1, ev + 1, size);
+		head += lv2_atom_pad_size(total);
+	}
+
+	out->head           = head;
+	out->seq->atom.size = (uint32_t)(head - (uint8_t*)&out->seq->body);
+	return n_dropped;
+}
+
+/**
+   Append the events in a sequence to an event buffer.
+
+   The event count and size of `out` are updated, its stamp type is set to
+   LV2_EVENT_AUDIO_STAMP, and its capacity and data are used as they are, so
+   the same buffer can be reused every cycle after resetting it with
+   lv2_event_buffer_reset().
+
+   @param bridge The bridge with the types to convert.
+   @param in Input sequence, stamped with audio frames.
+   @param out Output event buffer, which must be empty or have audio stamps.
+   @return The number of events that were dropped, because their type is not
+   mapped, they are too large for an event, or the output was full, which is
+   0 on success.  If either time stamp type can not be converted, every
+   event is dropped.
+*/
+static inline uint32_t
+lv2_event_bridge_to_buffer(const LV2_Event_Bridge*  bridge,
+                           const LV2_Atom_Sequence* in,
+                           LV2_Event_Buffer*        out)
+{
+	const uint8_t* const end        = (const uint8_t*)&in->body + in->atom.size;
+	const uint8_t*       ptr        = (const uint8_t*)(&in->body + 1);
+	uint8_t* const       data       = out->data;
+	const uint32_t       capacity   = out->capacity;
+	uint32_t             offset     = out->size;
+	uint32_t             n_events   = out->event_count;
+	LV2_URID             last_type  = 0;
+	uint16_t             event_type = 0;
+	uint32_t             n_dropped  = 0;
+
+	if (!lv2_event_bridge_is_frame_time(bridge, in->body.unit) ||
+	    (n_events && out->stamp_type != LV2_EVENT_AUDIO_STAMP)) {
+		return lv2_event_bridge_count(in);
+	}
+
+	out->stamp_type = LV2_EVENT_AUDIO_STAMP;
+	while (ptr < end && (uint32_t)(end - ptr) >= sizeof(LV2_Atom_Event)) {
+		const LV2_Atom_Event* const ev   = (const LV2_Atom_Event*)ptr;
+		const uint32_t              size = ev->body.size;
+		if ((uint32_t)(end - ptr) - sizeof(LV2_Atom_Event) < size) {
+			++n_dropped;  // Truncated event at the end of the sequence
+			break;
+		}
+
+		ptr += lv2_atom_pad_size((uint32_t)sizeof(LV2_Atom_Event) + size);
+		if (ev->body.type != last_type) {
+			last_type  = ev->body.type;
+			event_type = lv2_event_bridge_event_type(bridge, ev->body.type);
+		}
+
+		const uint32_t padded = lv2_event_bridge_padded_size(size);
+		if (!event_type || size > UINT16_MAX || offset > capacity ||
+		    capacity - offset < padded) {
+			++n_dropped;
+			continue;
+		}
+
+		LV2_Event* const out_ev = (LV2_Event*)(data + offset);
+		out_ev->frames    = (uint32_t)ev->time.frames;
+		out_ev->subframes = 0;
+		out_ev->type      = event_type;
+		out_ev->size      = (uint16_t)size;
+		lv2_event_bridge_copy(out_ev + 1, ev + 1, size);
+		offset += padded;
+		++n_events;
+	}
+
+	out->size        = offset;
+	out->event_count = n_events;
+	return n_dropped;
+}
+
+LV2_RESTORE_WARNINGS
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif  /* LV2_EVENT_BRIDGE_H */
+
+/**
+   @}
+*/
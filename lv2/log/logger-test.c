@@ -0,0 +1,314 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "lv2/log/log.h"
+#include "lv2/log/logger.h"
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define ERROR_TYPE 1
+#define NOTE_TYPE  2
+
+/** Log output, one message after another. */
+static char     output[4096];
+static size_t   output_len = 0;
+static LV2_URID last_type  = 0;
+
+static int
+test_fail(const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	fprintf(stderr, "error: ");
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	return 1;
+}
+
+LV2_LOG_FUNC(3, 0)
+static int
+log_vprintf(LV2_Log_Handle handle, LV2_URID type, const char* fmt, va_list ap)
+{
+	const int r = vsnprintf(
+		output + output_len, sizeof(output) - output_len, fmt, ap);
+
+	output_len += (size_t)r;
+	last_type = type;
+	return r;
+}
+
+LV2_LOG_FUNC(3, 4)
+static int
+log_printf(LV2_Log_Handle handle, LV2_URID type, const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	const int r = log_vprintf(handle, type, fmt, args);
+	va_end(args);
+	return r;
+}
+
+static LV2_Log_Log test_log = { NULL, log_printf, log_vprintf };
+
+static void
+clear_output(void)
+{
+	output[0]  = '\0';
+	output_len = 0;
+}
+
+typedef struct {
+	LV2_Log_Logger           logger;    ///< Host logger for flushing
+	LV2_Log_Deferred         deferred;  ///< Deferred logger
+	LV2_Log_Deferred_Message messages[4];
+} Loggers;
+
+static void
+init_loggers(Loggers* loggers)
+{
+	memset(loggers, 0, sizeof(*loggers));
+	loggers->logger.log   = &test_log;
+	loggers->logger.Error = ERROR_TYPE;
+	loggers->logger.Note  = NOTE_TYPE;
+	lv2_log_deferred_init(
+		&loggers->deferred, &loggers->logger, loggers->messages, 4);
+
+	clear_output();
+}
+
+/** Check that a deferred message is formatted like printf would. */
+LV2_LOG_FUNC(1, 2)
+static int
+check_format(const char* fmt, ...)
+{
+	Loggers loggers;
+	init_loggers(&loggers);
+
+	char    expected[LV2_LOG_DEFERRED_LINE_SIZE];
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(expected, sizeof(expected), fmt, args);
+	va_end(args);
+
+	va_start(args, fmt);
+	lv2_log_deferred_vprintf(&loggers.deferred, NOTE_TYPE, fmt, args);
+	va_end(args);
+
+	if (output_len) {
+		return test_fail("Deferred message was written immediately\n");
+	} else if (lv2_log_deferred_flush(&loggers.deferred, &loggers.logger) != 1) {
+		return test_fail("Failed to flush message\n");
+	} else if (last_type != NOTE_TYPE) {
+		return test_fail("Message has type %u\n", last_type);
+	} else if (strcmp(output, expected)) {
+		return test_fail("Formatted \"%s\" != \"%s\"\n", output, expected);
+	}
+
+	return 0;
+}
+
+static int
+test_format(void)
+{
+	const char  str[] = {'a', 'b', 'c', 'd'};  // Not terminated
+	const void* ptr   = &str;
+
+	return (check_format("Plain text\n") ||
+	        check_format("%d %i %+5d %-5d| %05d\n", -1, 2, 3, 4, 5) ||
+	        check_format("%u %x %X %#o %hhu %hd\n", 1u, 255u, 255u, 8u, 300, 70000) ||
+	        check_format("%ld %lu %lld %llu\n", -1L, 2UL, -3LL, 4ULL) ||
+	        check_format("%zu %td %jd\n", (size_t)1, (ptrdiff_t)-2, (intmax_t)3) ||
+	        check_format("%f %.2f %10.3e %g %Lf\n", 1.5, 2.25, 3e10, 0.1, 4.0L) ||
+	        check_format("%c%c %5c\n", 'o', 'k', '!') ||
+	        check_format("%s, %10s, %-4s|, %.2s\n", "one", "two", "x", "three") ||
+	        check_format("%.*s %*d %-*.*f\n", 4, str, 6, 7, 8, 2, 9.0) ||
+	        check_format("%p 100%%\n", ptr) ||
+	        check_format("%s %s\n", "", "end"));
+}
+
+static int
+test_truncation(void)
+{
+	Loggers loggers;
+	init_loggers(&loggers);
+
+	// Too many arguments, output stops at the first missing one
+	lv2_log_deferred_error(&loggers.deferred,
+	              "%d %d %d %d %d %d %d %d %d\n",
+	              1, 2, 3, 4, 5, 6, 7, 8, 9);
+
+	// Unsupported conversion, output stops there
+	int count = 0;
+	lv2_log_deferred_note(&loggers.deferred, "%d%n %d\n", 1, &count, 2);
+
+	// Long string, copy is truncated
+	char long_str[LV2_LOG_DEFERRED_STRINGS_SIZE * 2];
+	memset(long_str, 'x', sizeof(long_str) - 1);
+	long_str[sizeof(long_str) - 1] = '\0';
+	lv2_log_deferred_error(&loggers.deferred, "%s|%s|\n", long_str, "y");
+
+	lv2_log_deferred_flush(&loggers.deferred, &loggers.logger);
+
+	char expected[4096];
+	snprintf(expected, sizeof(expected),
+	         "1 2 3 4 5 6 7 8 ...\n"
+	         "1...\n"
+	         "%.*s||\n",
+	         LV2_LOG_DEFERRED_STRINGS_SIZE - 1, long_str);
+
+	if (strcmp(output, expected)) {
+		return test_fail("Truncated output \"%s\" != \"%s\"\n", output, expected);
+	} else if (count) {
+		return test_fail("Wrote to %%n argument\n");
+	}
+
+	return 0;
+}
+
+static int
+test_rate_limit(void)
+{
+	Loggers loggers;
+	init_loggers(&loggers);
+
+	// Repeat a message several times
+	for (int i = 0; i < 5; ++i) {
+		lv2_log_deferred_error(&loggers.deferred, "Error %d\n", 1);
+	}
+
+	// Poll reports the new message, then that its repeats stopped, then nothing
+	if (!lv2_log_deferred_poll(&loggers.deferred) ||
+	    !lv2_log_deferred_poll(&loggers.deferred) ||
+	    lv2_log_deferred_poll(&loggers.deferred)) {
+		return test_fail("Incorrect poll result\n");
+	}
+
+	// Repeats are reported with the next different message
+	lv2_log_deferred_note(&loggers.deferred, "Note\n");
+	lv2_log_deferred_flush(&loggers.deferred, &loggers.logger);
+	if (strcmp(output,
+	           "Error 1\n"
+	           "Previous message repeated 4 times\n"
+	           "Note\n")) {
+		return test_fail("Incorrect repeated output \"%s\"\n", output);
+	}
+
+	// The same format with different arguments is a different message
+	clear_output();
+	lv2_log_deferred_error(&loggers.deferred, "Type %d %s\n", 1, "a");
+	lv2_log_deferred_error(&loggers.deferred, "Type %d %s\n", 2, "a");
+	lv2_log_deferred_error(&loggers.deferred, "Type %d %s\n", 2, "b");
+	lv2_log_deferred_flush(&loggers.deferred, &loggers.logger);
+	if (strcmp(output, "Type 1 a\nType 2 a\nType 2 b\n")) {
+		return test_fail("Incorrect distinct output \"%s\"\n", output);
+	}
+
+	// Fill the ring (one slot holds the last flushed message), then drop
+	clear_output();
+	for (int i = 0; i < 5; ++i) {
+		lv2_log_deferred_error(
+			&loggers.deferred, i % 2 ? "Odd %d\n" : "Even %d\n", i);
+	}
+
+	// Drops are written after the last message, without a later message
+	if (lv2_log_deferred_flush(&loggers.deferred, &loggers.logger) != 4) {
+		return test_fail("Full ring did not contain 3 messages and a count\n");
+	} else if (strcmp(output,
+	                  "Even 0\n"
+	                  "Odd 1\n"
+	                  "Even 2\n"
+	                  "Dropped 2 messages\n")) {
+		return test_fail("Incorrect dropped output \"%s\"\n", output);
+	}
+
+	return 0;
+}
+
+static int
+test_pending_counts(void)
+{
+	Loggers loggers;
+	init_loggers(&loggers);
+
+	// Log the same message in several cycles, polling after each
+	lv2_log_deferred_error(&loggers.deferred, "Repeat\n");
+	if (!lv2_log_deferred_poll(&loggers.deferred)) {
+		return test_fail("Poll did not report a new message\n");
+	}
+
+	lv2_log_deferred_flush(&loggers.deferred, &loggers.logger);
+	for (int i = 0; i < 3; ++i) {
+		lv2_log_deferred_error(&loggers.deferred, "Repeat\n");
+		if (lv2_log_deferred_poll(&loggers.deferred)) {
+			return test_fail("Poll reported ongoing repeats\n");
+		}
+	}
+
+	// Once the repeats stop, poll reports them, and flush writes them
+	if (!lv2_log_deferred_poll(&loggers.deferred) ||
+	    lv2_log_deferred_poll(&loggers.deferred)) {
+		return test_fail("Poll did not report stopped repeats once\n");
+	} else if (lv2_log_deferred_flush(&loggers.deferred, &loggers.logger) != 1 ||
+	           strcmp(output, "Repeat\nPrevious message repeated 3 times\n")) {
+		return test_fail("Incorrect pending output \"%s\"\n", output);
+	}
+
+	// A final flush writes repeats without any poll
+	clear_output();
+	lv2_log_deferred_error(&loggers.deferred, "Repeat\n");
+	lv2_log_deferred_flush(&loggers.deferred, &loggers.logger);
+	if (strcmp(output, "Previous message repeated 1 times\n")) {
+		return test_fail("Incorrect final output \"%s\"\n", output);
+	} else if (lv2_log_deferred_flush(&loggers.deferred, &loggers.logger)) {
+		return test_fail("Counts were written twice\n");
+	}
+
+	return 0;
+}
+
+static int
+test_wrap(void)
+{
+	Loggers loggers;
+	init_loggers(&loggers);
+
+	// Write and flush many times so the indices wrap around the ring
+	for (int i = 0; i < 1000; ++i) {
+		clear_output();
+
+		lv2_log_deferred_error(&loggers.deferred, "A %d\n", i);
+		lv2_log_deferred_note(&loggers.deferred, "B %d\n", i);
+		lv2_log_deferred_flush(&loggers.deferred, &loggers.logger);
+
+		char expected[64];
+		snprintf(expected, sizeof(expected), "A %d\nB %d\n", i, i);
+		if (strcmp(output, expected) || last_type != NOTE_TYPE) {
+			return test_fail("Incorrect output \"%s\" after %d\n", output, i);
+		}
+	}
+
+	return 0;
+}
+
+int
+main(void)
+{
+	return (test_format() || test_truncation() || test_rate_limit() ||
+	        test_pending_counts() || test_wrap());
+}
@@ -22,6 +22,10 @@
    wrappers for logging from a plugin, which automatically fall back to
    printing to stderr if host support is unavailabe.
 
+   For logging in the audio thread, a separate deferred logger captures
+   messages in a lock-free ring to be written later from another thread.  See
+   @ref LV2_Log_Deferred.
+
    @{
 */
 
@@ -30,6 +34,10 @@
 
 #include "lv2/log/log.h"
 
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -147,6 +155,721 @@ lv2_log_warning(LV2_Log_Logger* logger, const char* fmt, ...)
 	return ret;
 }
 
+/**
+   @name Deferred Logging
+   @{
+*/
+
+/** Maximum number of arguments captured for a deferred message. */
+#define LV2_LOG_DEFERRED_MAX_ARGS 8
+
+/** Size of the storage for string arguments of a deferred message. */
+#define LV2_LOG_DEFERRED_STRINGS_SIZE 128
+
+/** Maximum length of a formatted deferred message. */
+#define LV2_LOG_DEFERRED_LINE_SIZE 512
+
+/** @cond */
+#ifdef __GNUC__
+#    define LV2_LOG_LOAD_ACQUIRE(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#    define LV2_LOG_STORE_RELEASE(ptr, val) \
+	__atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+#else
+/* MSVC gives volatile accesses acquire and release semantics by default */
+#    define LV2_LOG_LOAD_ACQUIRE(ptr) (*(const volatile uint32_t*)(ptr))
+#    define LV2_LOG_STORE_RELEASE(ptr, val) (*(volatile uint32_t*)(ptr) = (val))
+#endif
+/** @endcond */
+
+/**
+   A captured argument of a deferred message.
+*/
+typedef union {
+	intmax_t    i;  ///< Signed integer, or field width or precision
+	uintmax_t   u;  ///< Unsigned integer, or offset of string argument
+	double      f;  ///< Floating point number
+	const void* p;  ///< Pointer
+} LV2_Log_Deferred_Arg;
+
+/**
+   A message captured in the audio thread, to be formatted later.
+*/
+typedef struct {
+	LV2_URID             type;       ///< Message type (Error, Warning, etc)
+	uint32_t             n_args;     ///< Number of captured arguments
+	uint32_t             n_strings;  ///< Bytes used in strings
+	uint32_t             n_repeats;  ///< Number of repeats that followed
+	uint32_t             n_dropped;  ///< Number of drops that followed
+	const char*          fmt;        ///< Format string (not copied)
+	LV2_Log_Deferred_Arg args[LV2_LOG_DEFERRED_MAX_ARGS];
+	char                 strings[LV2_LOG_DEFERRED_STRINGS_SIZE];
+} LV2_Log_Deferred_Message;
+
+/**
+   A deferred logger, a single-producer single-consumer ring of messages.
+
+   This allows logging from the audio thread without formatting or calling
+   the host there.  Logging only copies the format string pointer and the
+   arguments into a preallocated message, and never blocks or allocates.
+   Messages are formatted and written later by lv2_log_deferred_flush() in
+   another thread, typically the worker.
+
+   Since only the format string pointer is stored, format strings must live
+   as long as the ring (string literals are fine).  String arguments are
+   copied, and truncated if they do not fit.  The `n` conversion and wide
+   characters are not supported, formatting stops at the first unsupported
+   conversion.
+
+   A message that is identical to the previous one, with the same type,
+   format, and arguments, is counted rather than stored, so an error in every
+   cycle does not flood the log.  Messages that do not fit in the ring are
+   dropped and also counted.  Counts are kept with the message they follow,
+   and written by the next flush after they change.  Since the last flushed
+   message may still be repeated, its slot is not reused until a later
+   message is flushed, so one slot of the ring is usually unavailable.
+*/
+typedef struct {
+	LV2_Log_Deferred_Message* messages;    ///< Message storage
+	uint32_t                  size;        ///< Size of messages, power of 2
+	uint32_t                  write_head;  ///< Next write index (producer)
+	uint32_t                  read_head;   ///< First index in use (consumer)
+
+	LV2_URID Error;    ///< Error message type, from the host logger
+	LV2_URID Note;     ///< Note message type, from the host logger
+	LV2_URID Trace;    ///< Trace message type, from the host logger
+	LV2_URID Warning;  ///< Warning message type, from the host logger
+
+	// Producer state
+	uint32_t n_counted;   ///< Repeats and drops after the last message
+	uint32_t poll_head;   ///< Write index at last poll
+	uint32_t poll_count;  ///< Value of n_counted at last poll
+	bool     poll_grew;   ///< True if n_counted grew before the last poll
+	bool     has_last;    ///< True if the last message may be repeated
+
+	// Consumer state
+	uint32_t flush_head;          ///< Next index to flush
+	uint32_t n_flushed_repeats;   ///< Repeats of last flushed message written
+	uint32_t n_flushed_dropped;   ///< Drops after last flushed message written
+} LV2_Log_Deferred;
+
+/**
+   Initialise a deferred logger with preallocated storage.
+
+   @param deferred The deferred logger to initialise.
+   @param logger Logger to copy message type URIDs from, or NULL.
+   @param messages Storage for messages.
+   @param n_messages The number of messages, which must be a power of 2.
+*/
+static inline void
+lv2_log_deferred_init(LV2_Log_Deferred*         deferred,
+                      const LV2_Log_Logger*     logger,
+                      LV2_Log_Deferred_Message* messages,
+                      uint32_t                  n_messages)
+{
+	memset(deferred, 0, sizeof(*deferred));
+	deferred->messages = messages;
+	deferred->size     = n_messages;
+	if (logger) {
+		deferred->Error   = logger->Error;
+		deferred->Note    = logger->Note;
+		deferred->Trace   = logger->Trace;
+		deferred->Warning = logger->Warning;
+	}
+}
+
+/** @cond */
+
+/** A parsed printf conversion specification. */
+typedef struct {
+	const char* flags;      ///< Start of flags
+	const char* width;      ///< Start of width, or "*"
+	const char* precision;  ///< Start of precision after ".", or "*", or NULL
+	const char* length;     ///< Start of length modifier
+	const char* end;        ///< End of specification (after conversion)
+	char        conv;       ///< Conversion character, or 0 if unsupported
+	char        arg;        ///< Argument kind: i, u, f, s, or p
+} LV2_Log_Deferred_Spec;
+
+static inline bool
+lv2_log_deferred_is_digit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+/**
+   Parse the conversion specification after the '%' at `fmt`.
+*/
+static inline LV2_Log_Deferred_Spec
+lv2_log_deferred_parse(const char* fmt)
+{
+	LV2_Log_Deferred_Spec spec = { NULL, NULL, NULL, NULL, NULL, 0, 0 };
+
+	const char* c = spec.flags = fmt + 1;
+	while (*c == '-' || *c == '+' || *c == ' ' || *c == '#' || *c == '0') {
+		++c;
+	}
+
+	spec.width = c;
+	if (*c == '*') {
+		++c;
+	} else {
+		while (lv2_log_deferred_is_digit(*c)) {
+			++c;
+		}
+	}
+
+	if (*c == '.') {
+		spec.precision = ++c;
+		if (*c == '*') {
+			++c;
+		} else {
+			while (lv2_log_deferred_is_digit(*c)) {
+				++c;
+			}
+		}
+	}
+
+	spec.length = c;
+	while (*c == 'h' || *c == 'l' || *c == 'j' || *c == 'z' || *c == 't' ||
+	       *c == 'L') {
+		++c;
+	}
+
+	const bool wide = (c - spec.length == 1 && *spec.length == 'l');
+	switch (*c) {
+	case 'd': case 'i':
+		spec.arg = 'i';
+		break;
+	case 'o': case 'u': case 'x': case 'X':
+		spec.arg = 'u';
+		break;
+	case 'c':
+		spec.arg = wide ? 0 : 'i';
+		break;
+	case 'a': case 'A': case 'e': case 'E': case 'f': case 'F': case 'g':
+	case 'G':
+		spec.arg = 'f';
+		break;
+	case 's':
+		spec.arg = wide ? 0 : 's';
+		break;
+	case 'p':
+		spec.arg = 'p';
+		break;
+	default:
+		break;
+	}
+
+	spec.conv = spec.arg ? *c : 0;
+	spec.end  = spec.arg ? c + 1 : c;
+	return spec;
+}
+
+/**
+   Read a signed integer argument with the length modifier of `spec`.
+*/
+static inline intmax_t
+lv2_log_deferred_signed_arg(const LV2_Log_Deferred_Spec* spec, va_list* args)
+{
+	const char*     len = spec->length;
+	const ptrdiff_t n   = spec->end - 1 - len;
+	if (n == 2 && *len == 'h') {
+		return (signed char)va_arg(*args, int);
+	} else if (n == 1 && *len == 'h') {
+		return (short)va_arg(*args, int);
+	} else if (n == 1 && *len == 'l') {
+		return va_arg(*args, long);
+	} else if (n == 2 && *len == 'l') {
+		return va_arg(*args, long long);
+	} else if (n == 1 && *len == 'j') {
+		return va_arg(*args, intmax_t);
+	} else if (n == 1 && *len == 'z') {
+		return (intmax_t)va_arg(*args, size_t);
+	} else if (n == 1 && *len == 't') {
+		return va_arg(*args, ptrdiff_t);
+	}
+	return va_arg(*args, int);
+}
+
+/**
+   Read an unsigned integer argument with the length modifier of `spec`.
+*/
+static inline uintmax_t
+lv2_log_deferred_unsigned_arg(const LV2_Log_Deferred_Spec* spec, va_list* args)
+{
+	const char*     len = spec->length;
+	const ptrdiff_t n   = spec->end - 1 - len;
+	if (n == 1 && *len == 'l') {
+		return va_arg(*args, unsigned long);
+	} else if (n == 2 && *len == 'l') {
+		return va_arg(*args, unsigned long long);
+	} else if (n == 1 && *len == 'j') {
+		return va_arg(*args, uintmax_t);
+	} else if (n == 1 && *len == 'z') {
+		return va_arg(*args, size_t);
+	} else if (n == 1 && *len == 't') {
+		return (uintmax_t)va_arg(*args, ptrdiff_t);
+	} else if (n == 2 && *len == 'h') {
+		return (unsigned char)va_arg(*args, unsigned);
+	} else if (n == 1 && *len == 'h') {
+		return (unsigned short)va_arg(*args, unsigned);
+	}
+	return va_arg(*args, unsigned);
+}
+
+/**
+   Capture the arguments for `fmt` into `msg` without formatting anything.
+*/
+static inline void
+lv2_log_deferred_capture(LV2_Log_Deferred_Message* msg,
+                         const char*               fmt,
+                         va_list*                  args)
+{
+	LV2_Log_Deferred_Arg* const out       = msg->args;
+	size_t                      n_strings = 0;
+
+	msg->n_args    = 0;
+	msg->n_strings = 0;
+	msg->strings[LV2_LOG_DEFERRED_STRINGS_SIZE - 1] = '\0';
+
+	for (const char* c = fmt; *c; ++c) {
+		if (*c != '%') {
+			continue;
+		} else if (c[1] == '%') {
+			++c;
+			continue;
+		}
+
+		const LV2_Log_Deferred_Spec spec = lv2_log_deferred_parse(c);
+		if (!spec.conv) {
+			break;  // Unsupported conversion
+		}
+
+		// Capture field width and precision arguments
+		intmax_t precision = -1;
+		if (*spec.width == '*') {
+			if (msg->n_args == LV2_LOG_DEFERRED_MAX_ARGS) {
+				break;
+			}
+			out[msg->n_args++].i = va_arg(*args, int);
+		}
+		if (spec.precision && *spec.precision == '*') {
+			if (msg->n_args == LV2_LOG_DEFERRED_MAX_ARGS) {
+				break;
+			}
+			precision = out[msg->n_args++].i = va_arg(*args, int);
+		} else if (spec.precision) {
+			precision = 0;
+			for (const char* p = spec.precision; lv2_log_deferred_is_digit(*p);
+			     ++p) {
+				precision = precision * 10 + (*p - '0');
+			}
+		}
+
+		if (msg->n_args == LV2_LOG_DEFERRED_MAX_ARGS) {
+			break;
+		}
+
+		// Capture value argument
+		LV2_Log_Deferred_Arg* const arg = &out[msg->n_args++];
+		switch (spec.arg) {
+		case 'i':
+			arg->i = lv2_log_deferred_signed_arg(&spec, args);
+			break;
+		case 'u':
+			arg->u = lv2_log_deferred_unsigned_arg(&spec, args);
+			break;
+		case 'f':
+			arg->f = (*spec.length == 'L') ? (double)va_arg(*args, long double)
+			                               : va_arg(*args, double);
+			break;
+		case 'p':
+			arg->u = 0;  // Clear any padding so messages can be compared
+			arg->p = va_arg(*args, const void*);
+			break;
+		case 's': {
+			// Copy string, up to the precision if given
+			const char* str = va_arg(*args, const char*);
+			str             = str ? str : "(null)";
+			arg->u          = (n_strings < LV2_LOG_DEFERRED_STRINGS_SIZE)
+			                      ? n_strings
+			                      : LV2_LOG_DEFERRED_STRINGS_SIZE - 1;
+			for (intmax_t i = 0; i != precision && str[i] &&
+			                     n_strings < LV2_LOG_DEFERRED_STRINGS_SIZE - 1;
+			     ++i) {
+				msg->strings[n_strings++] = str[i];
+			}
+			if (n_strings < LV2_LOG_DEFERRED_STRINGS_SIZE) {
+				msg->strings[n_strings++] = '\0';
+			}
+			break;
+		}
+		}
+
+		c = spec.end - 1;
+	}
+
+	msg->n_strings = (uint32_t)n_strings;
+}
+
+/**
+   Return true if two captured messages are identical.
+*/
+static inline bool
+lv2_log_deferred_equal(const LV2_Log_Deferred_Message* a,
+                       const LV2_Log_Deferred_Message* b)
+{
+	return (a->type == b->type && a->fmt == b->fmt &&
+	        a->n_args == b->n_args && a->n_strings == b->n_strings &&
+	        !memcmp(a->args, b->args, a->n_args * sizeof(LV2_Log_Deferred_Arg)) &&
+	        !memcmp(a->strings, b->strings, a->n_strings));
+}
+
+/**
+   Append text to a line being formatted, truncating if necessary.
+*/
+static inline void
+lv2_log_deferred_append(char*       line,
+                        size_t*     len,
+                        const char* str,
+                        size_t      n)
+{
+	const size_t space = LV2_LOG_DEFERRED_LINE_SIZE - 1 - *len;
+	n = (n < space) ? n : space;
+	memcpy(line + *len, str, n);
+	*len += n;
+	line[*len] = '\0';
+}
+
+/**
+   Format a captured message into `line`, which is truncated if necessary.
+*/
+static inline void
+lv2_log_deferred_format(const LV2_Log_Deferred_Message* msg,
+                        char*                           line)
+{
+	const LV2_Log_Deferred_Arg* in  = msg->args;
+	const LV2_Log_Deferred_Arg* end = msg->args + msg->n_args;
+	size_t                      len = 0;
+
+	line[0] = '\0';
+	for (const char* c = msg->fmt; *c;) {
+		// Copy literal text up to the next conversion
+		const char* next = strchr(c, '%');
+		if (!next) {
+			lv2_log_deferred_append(line, &len, c, strlen(c));
+			break;
+		}
+
+		lv2_log_deferred_append(line, &len, c, (size_t)(next - c));
+		if (next[1] == '%') {
+			lv2_log_deferred_append(line, &len, "%", 1);
+			c = next + 2;
+			continue;
+		}
+
+		// Check that all arguments for this conversion were captured
+		const LV2_Log_Deferred_Spec spec = lv2_log_deferred_parse(next);
+		const ptrdiff_t             n_args =
+			1 + (*spec.width == '*') +
+			(spec.precision && *spec.precision == '*');
+		if (!spec.conv || end - in < n_args || spec.end - next > 32) {
+			lv2_log_deferred_append(line, &len, "...\n", 4);
+			break;
+		}
+
+		// Build a specification with resolved width and a normalised length
+		char   spec_str[64];
+		size_t n = 0;
+		spec_str[n++] = '%';
+		for (const char* f = spec.flags; f < spec.width; ++f) {
+			spec_str[n++] = *f;
+		}
+		if (*spec.width == '*') {
+			n += (size_t)snprintf(spec_str + n, 16, "%d", (int)(in++)->i);
+		} else {
+			for (const char* w = spec.width; lv2_log_deferred_is_digit(*w);) {
+				spec_str[n++] = *w++;
+			}
+		}
+		if (spec.precision && *spec.precision == '*') {
+			n += (size_t)snprintf(spec_str + n, 16, ".%d", (int)(in++)->i);
+		} else if (spec.precision) {
+			spec_str[n++] = '.';
+			for (const char* p = spec.precision; lv2_log_deferred_is_digit(*p);) {
+				spec_str[n++] = *p++;
+			}
+		}
+		if (spec.arg == 'u' || (spec.arg == 'i' && spec.conv != 'c')) {
+			spec_str[n++] = 'j';
+		}
+		spec_str[n++] = spec.conv;
+		spec_str[n]   = '\0';
+
+		// Format argument directly into the line
+		char* const  out   = line + len;
+		const size_t space = LV2_LOG_DEFERRED_LINE_SIZE - len;
+		int          r     = 0;
+		switch (spec.arg) {
+		case 'i':
+			r = (spec.conv == 'c') ? snprintf(out, space, spec_str, (int)in->i)
+			                       : snprintf(out, space, spec_str, in->i);
+			break;
+		case 'u':
+			r = snprintf(out, space, spec_str, in->u);
+			break;
+		case 'f':
+			r = snprintf(out, space, spec_str, in->f);
+			break;
+		case 'p':
+			r = snprintf(out, space, spec_str, in->p);
+			break;
+		case 's':
+			r = snprintf(out, space, spec_str, msg->strings + in->u);
+			break;
+		}
+
+		if (r > 0) {
+			len += ((size_t)r < space) ? (size_t)r : space - 1;
+		}
+
+		++in;
+		c = spec.end;
+	}
+}
+
+LV2_LOG_FUNC(3, 4)
+static inline void
+lv2_log_deferred_print(LV2_Log_Logger* logger,
+                       LV2_URID        type,
+                       const char*     fmt,
+                       ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	lv2_log_vprintf(logger, type, fmt, args);
+	va_end(args);
+}
+
+/**
+   Write the counts that followed `msg` which have not been written yet.
+
+   @return The number of messages written.
+*/
+static inline uint32_t
+lv2_log_deferred_flush_counts(LV2_Log_Deferred*               deferred,
+                              const LV2_Log_Deferred_Message* msg,
+                              LV2_Log_Logger*                 logger)
+{
+	const uint32_t n_repeats = LV2_LOG_LOAD_ACQUIRE(&msg->n_repeats);
+	const uint32_t n_dropped = LV2_LOG_LOAD_ACQUIRE(&msg->n_dropped);
+	uint32_t       n         = 0;
+
+	if (n_repeats != deferred->n_flushed_repeats) {
+		lv2_log_deferred_print(logger,
+		                       msg->type,
+		                       "Previous message repeated %u times\n",
+		                       n_repeats - deferred->n_flushed_repeats);
+		deferred->n_flushed_repeats = n_repeats;
+		++n;
+	}
+
+	if (n_dropped != deferred->n_flushed_dropped) {
+		lv2_log_deferred_print(logger,
+		                       msg->type,
+		                       "Dropped %u messages\n",
+		                       n_dropped - deferred->n_flushed_dropped);
+		deferred->n_flushed_dropped = n_dropped;
+		++n;
+	}
+
+	return n;
+}
+
+/** Increment a count that is read by the consumer. */
+static inline void
+lv2_log_deferred_count(LV2_Log_Deferred* deferred, uint32_t* count)
+{
+	LV2_LOG_STORE_RELEASE(count, *count + 1u);
+	++deferred->n_counted;
+}
+
+/** @endcond */
+
+/**
+   Add a message to a deferred logger.
+
+   This is realtime safe, but may only be called from one thread at a time
+   (usually the audio thread).
+
+   @return 0 if the message was stored, counted as a repeat, or dropped.
+*/
+LV2_LOG_FUNC(3, 0)
+static inline int
+lv2_log_deferred_vprintf(LV2_Log_Deferred* deferred,
+                         LV2_URID          type,
+                         const char*       fmt,
+                         va_list           args)
+{
+	const uint32_t read_head  = LV2_LOG_LOAD_ACQUIRE(&deferred->read_head);
+	const uint32_t write_head = deferred->write_head;
+	const uint32_t mask       = deferred->size - 1u;
+
+	LV2_Log_Deferred_Message* const last =
+		&deferred->messages[(write_head - 1u) & mask];
+
+	if (write_head - read_head == deferred->size) {
+		// Ring is full, count a drop after the last message
+		lv2_log_deferred_count(deferred, &last->n_dropped);
+		deferred->has_last = false;  // Next message is not a repeat
+		return 0;
+	}
+
+	// Capture message into the next free slot
+	LV2_Log_Deferred_Message* const msg = &deferred->messages[write_head & mask];
+	va_list                         args_copy;
+	va_copy(args_copy, args);
+	msg->type = type;
+	msg->fmt  = fmt;
+	lv2_log_deferred_capture(msg, fmt, &args_copy);
+	va_end(args_copy);
+
+	if (deferred->has_last && lv2_log_deferred_equal(msg, last)) {
+		// Identical to the last message, count a repeat and leave slot free
+		lv2_log_deferred_count(deferred, &last->n_repeats);
+		return 0;
+	}
+
+	msg->n_repeats      = 0;
+	msg->n_dropped      = 0;
+	deferred->n_counted = 0;
+	deferred->has_last  = true;
+	LV2_LOG_STORE_RELEASE(&deferred->write_head, write_head + 1u);
+	return 0;
+}
+
+/** Log an error via lv2_log_deferred_vprintf(). */
+LV2_LOG_FUNC(2, 3)
+static inline int
+lv2_log_deferred_error(LV2_Log_Deferred* deferred, const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	const int ret = lv2_log_deferred_vprintf(deferred, deferred->Error, fmt, args);
+	va_end(args);
+	return ret;
+}
+
+/** Log a note via lv2_log_deferred_vprintf(). */
+LV2_LOG_FUNC(2, 3)
+static inline int
+lv2_log_deferred_note(LV2_Log_Deferred* deferred, const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	const int ret = lv2_log_deferred_vprintf(deferred, deferred->Note, fmt, args);
+	va_end(args);
+	return ret;
+}
+
+/** Log a trace via lv2_log_deferred_vprintf(). */
+LV2_LOG_FUNC(2, 3)
+static inline int
+lv2_log_deferred_trace(LV2_Log_Deferred* deferred, const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	const int ret = lv2_log_deferred_vprintf(deferred, deferred->Trace, fmt, args);
+	va_end(args);
+	return ret;
+}
+
+/** Log a warning via lv2_log_deferred_vprintf(). */
+LV2_LOG_FUNC(2, 3)
+static inline int
+lv2_log_deferred_warning(LV2_Log_Deferred* deferred, const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	const int ret =
+		lv2_log_deferred_vprintf(deferred, deferred->Warning, fmt, args);
+	va_end(args);
+	return ret;
+}
+
+/**
+   Return true if there is anything new to flush since the last call.
+
+   This is true if messages have been added, or if counted repeats or drops
+   have stopped, so a message repeated in every cycle is not reported every
+   cycle.  This may only be called from the thread that adds messages, and is
+   useful for deciding when to schedule a flush, for example with the worker.
+*/
+static inline bool
+lv2_log_deferred_poll(LV2_Log_Deferred* deferred)
+{
+	const uint32_t n_counted = deferred->n_counted;
+	const bool     added     = deferred->write_head != deferred->poll_head;
+	const bool     grew      = added ? n_counted > 0
+	                                 : n_counted != deferred->poll_count;
+	const bool     stopped   = !grew && deferred->poll_grew;
+
+	deferred->poll_head  = deferred->write_head;
+	deferred->poll_count = n_counted;
+	deferred->poll_grew  = grew;
+	return added || stopped;
+}
+
+/**
+   Format and write all messages in a deferred logger to `logger`.
+
+   Repeats and drops that followed the messages are written as well, as far
+   as they have been counted.  This is not realtime safe, and may only be
+   called from one thread at a time (but not necessarily the same one).
+   Messages are written to the host log of `logger`, or stderr.
+
+   @return The number of messages written, including counts.
+*/
+static inline uint32_t
+lv2_log_deferred_flush(LV2_Log_Deferred* deferred, LV2_Log_Logger* logger)
+{
+	const uint32_t write_head = LV2_LOG_LOAD_ACQUIRE(&deferred->write_head);
+	const uint32_t mask       = deferred->size - 1u;
+	uint32_t       flush_head = deferred->flush_head;
+	uint32_t       n          = 0;
+
+	if (flush_head != deferred->read_head) {
+		// Write new counts after the last message flushed previously
+		n += lv2_log_deferred_flush_counts(
+			deferred, &deferred->messages[(flush_head - 1u) & mask], logger);
+	}
+
+	char line[LV2_LOG_DEFERRED_LINE_SIZE];
+	for (; flush_head != write_head; ++flush_head, ++n) {
+		const LV2_Log_Deferred_Message* const msg =
+			&deferred->messages[flush_head & mask];
+
+		lv2_log_deferred_format(msg, line);
+		lv2_log_deferred_print(logger, msg->type, "%s", line);
+
+		deferred->n_flushed_repeats = 0;
+		deferred->n_flushed_dropped = 0;
+		n += lv2_log_deferred_flush_counts(deferred, msg, logger);
+	}
+
+	if (flush_head != deferred->flush_head) {
+		// Free every flushed message except the last, which may be repeated
+		deferred->flush_head = flush_head;
+		LV2_LOG_STORE_RELEASE(&deferred->read_head, flush_head - 1u);
+	}
+
+	return n;
+}
+
+/**
+   @}
+*/
+
 #ifdef __cplusplus
 }  /* extern "C" */
 #endif
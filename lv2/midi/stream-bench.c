@@ -0,0 +1,235 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   Benchmark of decoding and encoding MIDI streams.
+
+   Every operation is one message, so the rate in messages per second is
+   1e9 / ns_per_op.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "lv2/atom/atom-bench-utils.c"
+#include "lv2/atom/atom.h"
+#include "lv2/atom/util.h"
+#include "lv2/midi/midi.h"
+#include "lv2/midi/stream.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CAPACITY   (1u << 16u)
+#define N_MESSAGES 1024u
+#define MIDI_EVENT 1u
+
+typedef struct {
+	LV2_Midi_Decoder   decoder;
+	LV2_Midi_Encoder   encoder;
+	uint8_t            sysex[64];
+	uint8_t            stream[CAPACITY];  ///< Input stream
+	uint32_t           stream_size;       ///< Size of input stream in bytes
+	uint32_t           chunk;             ///< Bytes per read
+	uint32_t           n_messages;        ///< Messages in input stream
+	uint32_t           n_bad;             ///< Number of incorrect results
+	bool               use_running;       ///< Encode with running status
+	uint64_t           seq_buf[CAPACITY / sizeof(uint64_t)];
+	LV2_Atom_Sequence* seq;               ///< Decoded sequence in seq_buf
+	uint8_t            out[CAPACITY];     ///< Encoded output stream
+} Context;
+
+typedef enum {
+	STREAM_RUNNING,  ///< Notes with running status
+	STREAM_STATUS,   ///< Notes and controllers with every status byte
+	STREAM_MIXED     ///< Notes with running status, clock, and SysEx
+} StreamType;
+
+/** Write a stream of about `N_MESSAGES` messages to `ctx`. */
+static void
+write_stream(Context* ctx, StreamType type)
+{
+	uint8_t* const s = ctx->stream;
+	uint32_t       n = 0;
+	uint32_t       i = 0;
+
+	for (; i < N_MESSAGES; ++i) {
+		const uint8_t note = (uint8_t)(36 + i % 48);
+		if (type == STREAM_MIXED && i % 16 == 15) {
+			// A short SysEx message, interrupted by a clock
+			static const uint8_t sysex[] = {
+				0xF0, 0x7E, 0x7F, 0x06, 0xF8, 0x01, 0xF7
+			};
+			memcpy(s + n, sysex, sizeof(sysex));
+			n += (uint32_t)sizeof(sysex);
+			++i;  // Decoded as two messages
+		} else if (type == STREAM_MIXED && i % 16 == 7) {
+			s[n++] = LV2_MIDI_MSG_CLOCK;
+		} else if (type == STREAM_STATUS && i % 4 == 3) {
+			s[n++] = LV2_MIDI_MSG_CONTROLLER;
+			s[n++] = LV2_MIDI_CTL_MSB_MODWHEEL;
+			s[n++] = (uint8_t)(i % 128);
+		} else {
+			if (type == STREAM_STATUS || i == 0 || s[n - 1] == 0xF7) {
+				s[n++] = LV2_MIDI_MSG_NOTE_ON;
+			}
+			s[n++] = note;
+			s[n++] = (uint8_t)(1 + i % 127);
+		}
+	}
+
+	ctx->stream_size = n;
+	ctx->n_messages  = i;
+	ctx->use_running = type != STREAM_STATUS;
+}
+
+static LV2_Atom_Sequence*
+begin_output(Context* ctx, LV2_Atom_Sequence_Writer* writer)
+{
+	lv2_atom_sequence_clear(ctx->seq);
+	lv2_atom_sequence_writer_init(
+		writer, ctx->seq, CAPACITY - sizeof(LV2_Atom));
+	return ctx->seq;
+}
+
+/** Return the number of events in the decoded sequence. */
+static uint32_t
+count_events(const Context* ctx)
+{
+	uint32_t n_events = 0;
+	LV2_ATOM_SEQUENCE_FOREACH(ctx->seq, ev) {
+		++n_events;
+	}
+	return n_events;
+}
+
+/** Decode the stream in chunks with lv2_midi_decoder_read(). */
+static void
+decode_read(void* data)
+{
+	Context* const           ctx = (Context*)data;
+	LV2_Atom_Sequence_Writer writer;
+	begin_output(ctx, &writer);
+
+	lv2_midi_decoder_reset(&ctx->decoder);
+	for (uint32_t i = 0; i < ctx->stream_size; i += ctx->chunk) {
+		const uint32_t left = ctx->stream_size - i;
+		ctx->n_bad += lv2_midi_decoder_read(&ctx->decoder,
+		                                    &writer,
+		                                    i,
+		                                    MIDI_EVENT,
+		                                    ctx->stream + i,
+		                                    left < ctx->chunk ? left
+		                                                      : ctx->chunk);
+	}
+}
+
+/** Decode the stream one byte at a time with lv2_midi_decoder_push(). */
+static void
+decode_push(void* data)
+{
+	Context* const           ctx = (Context*)data;
+	LV2_Atom_Sequence_Writer writer;
+	begin_output(ctx, &writer);
+
+	lv2_midi_decoder_reset(&ctx->decoder);
+	for (uint32_t i = 0; i < ctx->stream_size; ++i) {
+		const uint8_t* msg  = NULL;
+		const uint32_t size = lv2_midi_decoder_push(
+			&ctx->decoder, ctx->stream[i], &msg);
+		if (size) {
+			uint8_t* const body = (uint8_t*)lv2_atom_sequence_writer_reserve(
+				&writer, i, MIDI_EVENT, size);
+			if (body) {
+				memcpy(body, msg, size);
+			} else {
+				++ctx->n_bad;
+			}
+		}
+	}
+}
+
+/** Encode the decoded sequence back to a stream. */
+static void
+encode(void* data)
+{
+	Context* const ctx      = (Context*)data;
+	uint32_t       n_events = 0;
+
+	lv2_midi_encoder_init(&ctx->encoder, ctx->use_running);
+	const uint32_t size = lv2_midi_encoder_write_sequence(
+		&ctx->encoder,
+		ctx->seq,
+		MIDI_EVENT,
+		ctx->out,
+		CAPACITY,
+		&n_events);
+
+	ctx->n_bad += n_events != ctx->n_messages || size != ctx->stream_size;
+}
+
+int
+main(void)
+{
+	static Context ctx;
+	ctx.seq = (LV2_Atom_Sequence*)ctx.seq_buf;
+	lv2_midi_decoder_init(&ctx.decoder, ctx.sysex, sizeof(ctx.sysex));
+
+	static const char* const names[] = { "running", "status", "mixed" };
+	static const uint32_t    chunks[] = { 1, 3, 64, CAPACITY };
+
+	bench_begin();
+
+	for (uint32_t t = 0; t < 3; ++t) {
+		write_stream(&ctx, (StreamType)t);
+
+		char name[48];
+		for (uint32_t c = 0; c < sizeof(chunks) / sizeof(uint32_t); ++c) {
+			ctx.chunk = chunks[c];
+			if (chunks[c] == CAPACITY) {
+				snprintf(name, sizeof(name), "decode_%s", names[t]);
+			} else {
+				snprintf(name, sizeof(name), "decode_%s_%u",
+				         names[t], chunks[c]);
+			}
+			bench_run(name, decode_read, &ctx, ctx.n_messages);
+			ctx.n_bad += count_events(&ctx) != ctx.n_messages;
+		}
+
+		snprintf(name, sizeof(name), "decode_%s_push", names[t]);
+		bench_run(name, decode_push, &ctx, ctx.n_messages);
+		ctx.n_bad += count_events(&ctx) != ctx.n_messages;
+
+		/* Encode the decoded stream, which gives the original stream, except
+		   that the clock inside SysEx in the mixed stream is moved before it. */
+		snprintf(name, sizeof(name), "encode_%s", names[t]);
+		bench_run(name, encode, &ctx, ctx.n_messages);
+		if (t != STREAM_MIXED &&
+		    memcmp(ctx.out, ctx.stream, ctx.stream_size)) {
+			++ctx.n_bad;
+		}
+	}
+
+	bench_end();
+
+	if (ctx.n_bad) {
+		fprintf(stderr, "error: %u incorrect results\n", ctx.n_bad);
+		return 1;
+	}
+
+	return 0;
+}
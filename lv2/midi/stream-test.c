@@ -0,0 +1,364 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "lv2/atom/atom-test-utils.c"
+#include "lv2/atom/atom.h"
+#include "lv2/atom/util.h"
+#include "lv2/midi/midi.h"
+#include "lv2/midi/stream.h"
+#include "lv2/urid/urid.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CAPACITY       1024u
+#define SYSEX_CAPACITY 8u
+
+typedef struct {
+	uint32_t size;
+	uint8_t  bytes[SYSEX_CAPACITY];
+} Message;
+
+static LV2_URID           midi_MidiEvent;
+static LV2_Midi_Decoder   decoder;
+static uint8_t            sysex[SYSEX_CAPACITY];
+static uint64_t           seq_buf[CAPACITY / sizeof(uint64_t)];
+static LV2_Atom_Sequence* seq = (LV2_Atom_Sequence*)seq_buf;
+
+/** Clear the output sequence and set up `writer` to append to it. */
+static void
+begin_output(LV2_Atom_Sequence_Writer* writer, uint32_t capacity)
+{
+	lv2_atom_sequence_clear(seq);
+	lv2_atom_sequence_writer_init(writer, seq, capacity);
+}
+
+/** Decode `bytes` in chunks of `chunk` bytes into the output sequence. */
+static uint32_t
+decode(const uint8_t* bytes, uint32_t n_bytes, uint32_t chunk)
+{
+	LV2_Atom_Sequence_Writer writer;
+	begin_output(&writer, CAPACITY - sizeof(LV2_Atom));
+
+	uint32_t n_dropped = 0;
+	for (uint32_t i = 0; i < n_bytes; i += chunk) {
+		const uint32_t n = n_bytes - i < chunk ? n_bytes - i : chunk;
+		n_dropped += lv2_midi_decoder_read(
+			&decoder, &writer, i, midi_MidiEvent, bytes + i, n);
+	}
+
+	return n_dropped;
+}
+
+/** Return true if the output sequence contains exactly `expected`. */
+static bool
+check_output(const Message* expected, uint32_t n_expected)
+{
+	uint32_t i = 0;
+	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+		if (i == n_expected ||
+		    ev->body.type != midi_MidiEvent ||
+		    ev->body.size != expected[i].size ||
+		    memcmp(ev + 1, expected[i].bytes, expected[i].size)) {
+			return false;
+		}
+		++i;
+	}
+
+	return i == n_expected;
+}
+
+/** Decode `bytes` in every chunk size and check the output is `expected`. */
+static bool
+check_decode(const uint8_t* bytes,
+             uint32_t       n_bytes,
+             const Message* expected,
+             uint32_t       n_expected)
+{
+	for (uint32_t chunk = 1; chunk <= n_bytes; ++chunk) {
+		lv2_midi_decoder_init(&decoder, sysex, SYSEX_CAPACITY);
+		if (decode(bytes, n_bytes, chunk) ||
+		    !check_output(expected, n_expected)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/** Write `messages` to the output sequence, one per frame. */
+static void
+write_messages(const Message* messages, uint32_t n_messages)
+{
+	LV2_Atom_Sequence_Writer writer;
+	begin_output(&writer, CAPACITY - sizeof(LV2_Atom));
+	for (uint32_t i = 0; i < n_messages; ++i) {
+		uint8_t* const body = (uint8_t*)lv2_atom_sequence_writer_reserve(
+			&writer, i, midi_MidiEvent, messages[i].size);
+		memcpy(body, messages[i].bytes, messages[i].size);
+	}
+}
+
+static int
+test_sizes(void)
+{
+	if (lv2_midi_status_size(0x00) != 0 ||
+	    lv2_midi_status_size(0x7F) != 0 ||
+	    lv2_midi_status_size(0x80) != 3 ||
+	    lv2_midi_status_size(0xC5) != 2 ||
+	    lv2_midi_status_size(0xDF) != 2 ||
+	    lv2_midi_status_size(0xEF) != 3 ||
+	    lv2_midi_status_size(0xF0) != 0 ||
+	    lv2_midi_status_size(0xF1) != 2 ||
+	    lv2_midi_status_size(0xF2) != 3 ||
+	    lv2_midi_status_size(0xF4) != 0 ||
+	    lv2_midi_status_size(0xF6) != 1 ||
+	    lv2_midi_status_size(0xF7) != 0 ||
+	    lv2_midi_status_size(0xF8) != 1 ||
+	    lv2_midi_status_size(0xFD) != 0 ||
+	    lv2_midi_status_size(0xFF) != 1) {
+		return test_fail("Incorrect message size\n");
+	}
+
+	return 0;
+}
+
+static int
+test_running_status(void)
+{
+	// Notes with running status, then a program change, then a bend
+	static const uint8_t bytes[] = {
+		0x90, 60, 100, 62, 100, 60, 0,
+		0xC1, 5, 6,
+		0xE2, 0, 64, 1, 64
+	};
+
+	static const Message expected[] = {
+		{ 3, { 0x90, 60, 100 } },
+		{ 3, { 0x90, 62, 100 } },
+		{ 3, { 0x80, 60, 64 } },  // Note On with velocity 0 is a Note Off
+		{ 2, { 0xC1, 5 } },
+		{ 2, { 0xC1, 6 } },
+		{ 3, { 0xE2, 0, 64 } },
+		{ 3, { 0xE2, 1, 64 } },
+	};
+
+	if (!check_decode(bytes, sizeof(bytes), expected, 7)) {
+		return test_fail("Running status incorrectly expanded\n");
+	}
+
+	// Data without a status is ignored
+	static const uint8_t orphans[]          = { 1, 2, 3, 0x91, 60, 0 };
+	static const Message orphans_expected[] = { { 3, { 0x81, 60, 64 } } };
+	if (!check_decode(orphans, sizeof(orphans), orphans_expected, 1)) {
+		return test_fail("Orphan data bytes not ignored\n");
+	}
+
+	// System common messages cancel running status
+	static const uint8_t common[] = { 0x90, 60, 100, 0xF3, 7, 62, 100, 0xF6 };
+	static const Message common_expected[] = {
+		{ 3, { 0x90, 60, 100 } },
+		{ 2, { 0xF3, 7 } },
+		{ 1, { 0xF6 } },
+	};
+	if (!check_decode(common, sizeof(common), common_expected, 3)) {
+		return test_fail("System common message did not cancel status\n");
+	}
+
+	return 0;
+}
+
+static int
+test_realtime(void)
+{
+	// Real-time messages interrupt other messages without affecting them
+	static const uint8_t bytes[] = {
+		0xF8, 0x90, 0xF8, 60, 0xFA, 100, 62, 0xFE, 100,
+		0xF9, 0xFD,  // Undefined, ignored
+		0xF0, 1, 0xF8, 2, 0xF7
+	};
+
+	static const Message expected[] = {
+		{ 1, { 0xF8 } },
+		{ 1, { 0xF8 } },
+		{ 1, { 0xFA } },
+		{ 3, { 0x90, 60, 100 } },
+		{ 1, { 0xFE } },
+		{ 3, { 0x90, 62, 100 } },
+		{ 1, { 0xF8 } },
+		{ 4, { 0xF0, 1, 2, 0xF7 } },
+	};
+
+	if (!check_decode(bytes, sizeof(bytes), expected, 8)) {
+		return test_fail("Real-time messages incorrectly decoded\n");
+	}
+
+	return 0;
+}
+
+static int
+test_sysex(void)
+{
+	// SysEx is reassembled from any number of chunks
+	static const uint8_t bytes[] = {
+		0x90, 60, 100,
+		0xF0, 0x7E, 1, 2, 3, 4, 5, 0xF7,
+		61, 100,  // Running status was cancelled by SysEx
+		0xF0, 1, 2, 3, 4, 5, 6, 7, 8, 0xF7,  // Too large, dropped
+		0xF0, 1, 2, 0x91, 60, 100,  // Interrupted, dropped
+		0xF7,  // Stray EOX, ignored
+		0xF0, 0xF7
+	};
+
+	static const Message expected[] = {
+		{ 3, { 0x90, 60, 100 } },
+		{ 8, { 0xF0, 0x7E, 1, 2, 3, 4, 5, 0xF7 } },
+		{ 3, { 0x91, 60, 100 } },
+		{ 2, { 0xF0, 0xF7 } },
+	};
+
+	if (!check_decode(bytes, sizeof(bytes), expected, 4)) {
+		return test_fail("SysEx incorrectly reassembled\n");
+	}
+
+	// Without a buffer, SysEx is always dropped
+	static const Message notes[] = {
+		{ 3, { 0x90, 60, 100 } },
+		{ 3, { 0x91, 60, 100 } },
+	};
+	lv2_midi_decoder_init(&decoder, NULL, 0);
+	if (decode(bytes, sizeof(bytes), 4) || !check_output(notes, 2)) {
+		return test_fail("SysEx decoded without a buffer\n");
+	}
+
+	return 0;
+}
+
+static int
+test_overflow(void)
+{
+	static const uint8_t bytes[]   = { 0x90, 60, 100, 61, 100, 0xF8, 62, 100 };
+	static const Message first[]   = { { 3, { 0x90, 60, 100 } } };
+	static const Message resumed[] = { { 3, { 0x90, 63, 100 } } };
+
+	// Only the first event fits, and the rest are counted as dropped
+	LV2_Atom_Sequence_Writer writer;
+	begin_output(&writer, sizeof(LV2_Atom_Sequence_Body) + 24);
+	lv2_midi_decoder_init(&decoder, sysex, SYSEX_CAPACITY);
+	if (lv2_midi_decoder_read(&decoder, &writer, 0, midi_MidiEvent,
+	                          bytes, sizeof(bytes)) != 3 ||
+	    !check_output(first, 1)) {
+		return test_fail("Incorrect output on overflow\n");
+	}
+
+	// Decoding continues correctly after the output is full
+	begin_output(&writer, CAPACITY - sizeof(LV2_Atom));
+	static const uint8_t more[] = { 63, 100 };
+	if (lv2_midi_decoder_read(&decoder, &writer, 0, midi_MidiEvent,
+	                          more, sizeof(more)) ||
+	    !check_output(resumed, 1)) {
+		return test_fail("Incorrect output after overflow\n");
+	}
+
+	return 0;
+}
+
+static int
+test_encode(void)
+{
+	static const Message messages[] = {
+		{ 3, { 0x90, 60, 100 } },
+		{ 3, { 0x90, 62, 100 } },
+		{ 1, { 0xF8 } },
+		{ 3, { 0x90, 61, 100 } },
+		{ 2, { 0xC1, 5 } },
+		{ 5, { 0xF0, 1, 2, 3, 0xF7 } },
+		{ 2, { 0xC1, 6 } },
+		{ 2, { 0xF3, 1 } },
+		{ 2, { 0xC1, 7 } },
+	};
+
+	static const uint8_t running[] = {
+		0x90, 60, 100, 62, 100, 0xF8, 61, 100,
+		0xC1, 5,
+		0xF0, 1, 2, 3, 0xF7,
+		0xC1, 6,
+		0xF3, 1,
+		0xC1, 7
+	};
+
+	// Encode with running status
+	LV2_Midi_Encoder encoder;
+	uint8_t          buf[64];
+	uint32_t         n_events = 0;
+	write_messages(messages, 9);
+	lv2_midi_encoder_init(&encoder, true);
+	uint32_t size = lv2_midi_encoder_write_sequence(
+		&encoder, seq, midi_MidiEvent, buf, sizeof(buf), &n_events);
+	if (size != sizeof(running) || n_events != 9 ||
+	    memcmp(buf, running, size)) {
+		return test_fail("Incorrect encoding with running status\n");
+	}
+
+	// Decoding the encoded stream gives the original messages
+	if (!check_decode(buf, size, messages, 9)) {
+		return test_fail("Encoded stream decoded incorrectly\n");
+	}
+
+	// Encode without running status, into a buffer that is too small
+	write_messages(messages, 9);
+	lv2_midi_encoder_init(&encoder, false);
+	size = lv2_midi_encoder_write_sequence(
+		&encoder, seq, midi_MidiEvent, buf, 9, &n_events);
+	if (size != 7 || n_events != 3 || buf[3] != 0x90) {
+		return test_fail("Incorrect encoding without running status\n");
+	}
+
+	// Invalid messages are not written
+	static const uint8_t data[] = { 60, 100 };
+	if (lv2_midi_encoder_write(&encoder, data, 2, buf, sizeof(buf)) ||
+	    lv2_midi_encoder_write(&encoder, data, 0, buf, sizeof(buf)) ||
+	    lv2_midi_encoder_write(&encoder, messages[2].bytes, 1, buf, 0)) {
+		return test_fail("Invalid message encoded\n");
+	}
+
+	// Long messages with running status do not write the omitted status
+	static const uint8_t long_note[] = { 0x90, 60, 100, 0 };
+	uint8_t              out[4]      = { 0, 0, 0, 0xAA };
+	lv2_midi_encoder_init(&encoder, true);
+	if (lv2_midi_encoder_write(&encoder, long_note, 4, buf, 4) != 4 ||
+	    lv2_midi_encoder_write(&encoder, long_note, 4, out, 3) != 3 ||
+	    memcmp(out, long_note + 1, 3) || out[3] != 0xAA) {
+		return test_fail("Incorrect long message with running status\n");
+	}
+
+	return 0;
+}
+
+int
+main(void)
+{
+	LV2_URID_Map map = { NULL, urid_map };
+	midi_MidiEvent = map.map(map.handle, LV2_MIDI__MidiEvent);
+
+	const int ret = (test_sizes() || test_running_status() ||
+	                 test_realtime() || test_sysex() || test_overflow() ||
+	                 test_encode());
+
+	free_urid_map();
+	return ret;
+}
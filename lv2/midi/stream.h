@@ -0,0 +1,468 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @defgroup stream Stream
+   @ingroup midi
+
+   Conversion between raw MIDI byte streams and MIDI event atoms.
+
+   A raw stream, as read from or written to a hardware port, is not a sequence
+   of complete messages: status bytes may be omitted (running status),
+   real-time messages may appear between any two bytes, even within another
+   message, and a System Exclusive message may arrive in several chunks.  The
+   decoder reassembles the stream into complete, normalised messages suitable
+   for midi:MidiEvent atoms, and the encoder does the reverse.
+
+   Neither allocates any memory.  SysEx messages are reassembled in a buffer
+   provided by the caller, and messages that do not fit in it are dropped.
+
+   For example, a host can write the bytes read from a port during a cycle to
+   a plugin's input sequence with:
+
+   @code
+   LV2_Atom_Sequence_Writer writer;
+   lv2_atom_sequence_writer_init(&writer, seq, capacity);
+   for (uint32_t i = 0; i < n_reads; ++i) {
+       lv2_midi_decoder_read(&decoder, &writer, reads[i].frames,
+                             uris.midi_MidiEvent, reads[i].data,
+                             reads[i].size);
+   }
+   @endcode
+
+   @{
+*/
+
+#ifndef LV2_MIDI_STREAM_H
+#define LV2_MIDI_STREAM_H
+
+#include "lv2/atom/atom.h"
+#include "lv2/atom/util.h"
+#include "lv2/midi/midi.h"
+#include "lv2/urid/urid.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+   Incremental MIDI stream decoder.
+
+   This is a plain struct that can be allocated anywhere, it must be
+   initialised with lv2_midi_decoder_init() before use.
+*/
+typedef struct {
+	uint8_t* sysex;           /**< SysEx buffer (provided by the caller) */
+	uint32_t sysex_capacity;  /**< Size of sysex buffer in bytes */
+	uint32_t sysex_size;      /**< Size of SysEx message so far */
+	uint8_t  msg[3];          /**< Current message, status first */
+	uint8_t  size;            /**< Expected size of msg, or 0 if none */
+	uint8_t  pos;             /**< Number of bytes in msg */
+	uint8_t  running;         /**< Running status, or 0 */
+	uint8_t  realtime;        /**< Last real-time message */
+	bool     in_sysex;        /**< True while reading a SysEx message */
+	bool     overflow;        /**< True if the SysEx message did not fit */
+} LV2_Midi_Decoder;
+
+/**
+   Incremental MIDI stream encoder.
+
+   This is a plain struct that can be allocated anywhere, it must be
+   initialised with lv2_midi_encoder_init() before use.
+*/
+typedef struct {
+	uint8_t running;          /**< Running status, or 0 */
+	bool    use_running;      /**< True to omit repeated status bytes */
+} LV2_Midi_Encoder;
+
+/**
+   Return the size of a message with the given status byte.
+
+   This is 0 for SysEx (which has a variable size) and for undefined or
+   invalid status bytes, and 1 for every real-time message.
+*/
+static inline uint32_t
+lv2_midi_status_size(uint8_t status)
+{
+	static const uint8_t sizes[32] = {
+		0, 0, 0, 0, 0, 0, 0, 0,  // 0x00-0x70: Data bytes
+		3, 3, 3, 3, 2, 2, 3, 0,  // 0x80-0xE0: Voice messages
+		0, 2, 3, 2, 0, 0, 1, 0,  // 0xF0-0xF7: System common messages
+		1, 0, 1, 1, 1, 0, 1, 1   // 0xF8-0xFF: System real-time messages
+	};
+
+	return status < 0xF0 ? sizes[status >> 4] : sizes[status - 0xE0];
+}
+
+/**
+   Initialise `decoder` to decode a new stream.
+
+   @param decoder The decoder to initialise.
+   @param sysex Buffer for reassembling SysEx messages, or NULL to drop them.
+   @param sysex_capacity The size of `sysex` in bytes.
+*/
+static inline void
+lv2_midi_decoder_init(LV2_Midi_Decoder* decoder,
+                      uint8_t*          sysex,
+                      uint32_t          sysex_capacity)
+{
+	memset(decoder, 0, sizeof(LV2_Midi_Decoder));
+	decoder->sysex          = sysex;
+	decoder->sysex_capacity = sysex ? sysex_capacity : 0;
+}
+
+/**
+   Reset `decoder` to the initial state, for example after the input was
+   interrupted.  Running status and any partial message are discarded.
+*/
+static inline void
+lv2_midi_decoder_reset(LV2_Midi_Decoder* decoder)
+{
+	lv2_midi_decoder_init(decoder, decoder->sysex, decoder->sysex_capacity);
+}
+
+/** Add a byte to the SysEx message being read by `decoder`. */
+static inline void
+lv2_midi_decoder_sysex_push(LV2_Midi_Decoder* decoder, uint8_t byte)
+{
+	if (decoder->sysex_size < decoder->sysex_capacity) {
+		decoder->sysex[decoder->sysex_size++] = byte;
+	} else {
+		decoder->overflow = true;
+	}
+}
+
+/**
+   Convert a Note On with velocity 0 in `msg` to a Note Off.
+
+   The Note Off has the default release velocity of 64, since a stream
+   does not say what the release velocity was.
+*/
+static inline void
+lv2_midi_decoder_normalise(uint8_t* msg)
+{
+	if ((msg[0] & 0xF0) == LV2_MIDI_MSG_NOTE_ON && msg[2] == 0) {
+		msg[0] = (uint8_t)(LV2_MIDI_MSG_NOTE_OFF | (msg[0] & 0x0F));
+		msg[2] = 0x40;
+	}
+}
+
+/**
+   Decode a single byte.
+
+   A real-time message is returned immediately, without affecting any message
+   that it interrupts.  A Note On with velocity 0, which is not allowed in a
+   midi:MidiEvent, is returned as a Note Off.  A SysEx message is only returned when its final (EOX)
+   byte is read, and is discarded if it does not fit in the SysEx buffer, or
+   if it is ended by any other status byte.  Data bytes without a status are
+   ignored.
+
+   @param decoder The decoder.
+   @param byte The next byte in the stream.
+   @param[out] msg Set to point to the message if one is complete.  This is
+   only valid until the next call that modifies `decoder`.
+   @return The size of the complete message, or 0 if there is none.
+*/
+static inline uint32_t
+lv2_midi_decoder_push(LV2_Midi_Decoder* decoder,
+                      uint8_t           byte,
+                      const uint8_t**   msg)
+{
+	if (byte < 0x80) {
+		// Data byte
+		if (decoder->in_sysex) {
+			lv2_midi_decoder_sysex_push(decoder, byte);
+			return 0;
+		} else if (decoder->pos == 0) {
+			if (!decoder->running) {
+				return 0;  // No status, ignore
+			}
+
+			// Expand running status
+			decoder->msg[0] = decoder->running;
+			decoder->size   = (uint8_t)lv2_midi_status_size(decoder->running);
+			decoder->pos    = 1;
+		}
+
+		decoder->msg[decoder->pos++] = byte;
+		if (decoder->pos < decoder->size) {
+			return 0;
+		}
+
+		decoder->pos = 0;
+		lv2_midi_decoder_normalise(decoder->msg);
+		*msg = decoder->msg;
+		return decoder->size;
+	}
+
+	const uint32_t size = lv2_midi_status_size(byte);
+	if (byte >= 0xF8) {
+		// Real-time message, which may appear anywhere
+		if (!size) {
+			return 0;  // Undefined, ignore
+		}
+
+		decoder->realtime = byte;
+		*msg              = &decoder->realtime;
+		return 1;
+	} else if (byte == LV2_MIDI_MSG_SYSTEM_EXCLUSIVE + 7) {
+		// End of SysEx
+		const bool complete = decoder->in_sysex && !decoder->overflow;
+		decoder->in_sysex = false;
+		if (complete) {
+			lv2_midi_decoder_sysex_push(decoder, byte);
+			if (!decoder->overflow) {
+				*msg = decoder->sysex;
+				return decoder->sysex_size;
+			}
+		}
+
+		return 0;
+	}
+
+	// Any other status byte ends (and discards) a SysEx message
+	decoder->in_sysex = false;
+	decoder->pos      = 0;
+	if (byte == LV2_MIDI_MSG_SYSTEM_EXCLUSIVE) {
+		decoder->running    = 0;
+		decoder->in_sysex   = true;
+		decoder->overflow   = false;
+		decoder->sysex_size = 0;
+		lv2_midi_decoder_sysex_push(decoder, byte);
+	} else if (byte >= 0xF0) {
+		// System common message, which cancels running status
+		decoder->running = 0;
+		if (size == 1) {
+			decoder->msg[0] = byte;
+			*msg            = decoder->msg;
+			return 1;
+		} else if (size) {
+			decoder->msg[0] = byte;
+			decoder->size   = (uint8_t)size;
+			decoder->pos    = 1;
+		}
+	} else {
+		// Voice message, which sets running status
+		decoder->running = byte;
+		decoder->msg[0]  = byte;
+		decoder->size    = (uint8_t)size;
+		decoder->pos     = 1;
+	}
+
+	return 0;
+}
+
+/**
+   Decode bytes and append the complete messages to a sequence.
+
+   Every message is written as a midi:MidiEvent at the same time, so this
+   should be called for every separately timed chunk of input.  Complete voice
+   messages, with or without a status byte, are copied directly from the input
+   without going through the decoder one byte at a time.
+
+   @param decoder The decoder.
+   @param writer Writer for the output sequence.
+   @param frames Time stamp for the decoded events.
+   @param midi_MidiEvent The URID of midi:MidiEvent.
+   @param bytes Input bytes.
+   @param n_bytes The number of input bytes.
+   @return The number of complete messages that were dropped because the
+   output was full, which is 0 on success.
+*/
+static inline uint32_t
+lv2_midi_decoder_read(LV2_Midi_Decoder*         decoder,
+                      LV2_Atom_Sequence_Writer* writer,
+                      int64_t                   frames,
+                      LV2_URID                  midi_MidiEvent,
+                      const uint8_t*            bytes,
+                      uint32_t                  n_bytes)
+{
+	uint32_t n_dropped = 0;
+	uint32_t i         = 0;
+	while (i < n_bytes) {
+		if (decoder->pos == 0 && !decoder->in_sysex) {
+			// Between messages, copy complete voice messages directly
+			uint8_t running = decoder->running;
+			while (i < n_bytes) {
+				const uint8_t  byte   = bytes[i];
+				const uint8_t  status = byte < 0x80 ? running : byte;
+				const uint32_t first  = byte < 0x80 ? i : i + 1;
+				if (status < 0x80 || status >= 0xF0) {
+					break;  // No status, or a system message
+				}
+
+				const uint32_t size = lv2_midi_status_size(status);
+				if (first + size - 1 > n_bytes || bytes[first] >= 0x80 ||
+				    (size == 3 && bytes[first + 1] >= 0x80)) {
+					break;  // Incomplete or interrupted message
+				}
+
+				uint8_t* const body = (uint8_t*)lv2_atom_sequence_writer_reserve(
+					writer, frames, midi_MidiEvent, size);
+				if (body) {
+					body[0] = status;
+					body[1] = bytes[first];
+					if (size == 3) {
+						body[2] = bytes[first + 1];
+						lv2_midi_decoder_normalise(body);
+					}
+				} else {
+					++n_dropped;
+				}
+
+				running = status;
+				i       = first + size - 1;
+			}
+
+			decoder->running = running;
+			if (i == n_bytes) {
+				break;
+			}
+		}
+
+		// Decode anything else a byte at a time
+		const uint8_t* msg  = NULL;
+		const uint32_t size = lv2_midi_decoder_push(decoder, bytes[i++], &msg);
+		if (size) {
+			uint8_t* const body = (uint8_t*)lv2_atom_sequence_writer_reserve(
+				writer, frames, midi_MidiEvent, size);
+			if (body) {
+				memcpy(body, msg, size);
+			} else {
+				++n_dropped;
+			}
+		}
+	}
+
+	return n_dropped;
+}
+
+/**
+   Initialise `encoder` to encode a new stream.
+
+   @param encoder The encoder to initialise.
+   @param use_running If true, status bytes are omitted where running status
+   allows, which reduces the bandwidth used by dense streams of voice messages
+   on a slow link, but makes the stream depend on everything before it.
+*/
+static inline void
+lv2_midi_encoder_init(LV2_Midi_Encoder* encoder, bool use_running)
+{
+	encoder->running     = 0;
+	encoder->use_running = use_running;
+}
+
+/**
+   Encode a single complete message.
+
+   @return The number of bytes written to `buf`, or 0 if the message is
+   invalid or does not fit, in which case nothing is written.
+*/
+static inline uint32_t
+lv2_midi_encoder_write(LV2_Midi_Encoder* encoder,
+                       const uint8_t*    msg,
+                       uint32_t          size,
+                       uint8_t*          buf,
+                       uint32_t          capacity)
+{
+	if (!size || msg[0] < 0x80) {
+		return 0;
+	}
+
+	const uint8_t status = msg[0];
+	if (status >= 0xF8) {
+		// Real-time messages do not affect running status
+		if (!capacity) {
+			return 0;
+		}
+
+		buf[0] = status;
+		return 1;
+	}
+
+	const uint32_t skip = (encoder->use_running && status < 0xF0 &&
+	                       status == encoder->running);
+	if (size - skip > capacity) {
+		return 0;
+	}
+
+	if (size <= 3) {
+		// Copy short messages directly, which is much faster than memcpy()
+		for (uint32_t i = skip; i < size; ++i) {
+			buf[i - skip] = msg[i];
+		}
+	} else {
+		memcpy(buf, msg + skip, size - skip);
+	}
+
+	encoder->running = status < 0xF0 ? status : 0;
+	return size - skip;
+}
+
+/**
+   Encode every MIDI event in `seq` to `buf`.
+
+   Encoding stops at the first event that does not fit, which is a slightly
+   more useful failure than dropping events from the middle of the stream.
+
+   @param encoder The encoder.
+   @param seq The sequence to encode.
+   @param midi_MidiEvent The URID of midi:MidiEvent.
+   @param buf Output buffer.
+   @param capacity The size of `buf` in bytes.
+   @param[out] n_events Set to the number of MIDI events that were written.
+   @return The number of bytes written to `buf`.
+*/
+static inline uint32_t
+lv2_midi_encoder_write_sequence(LV2_Midi_Encoder*        encoder,
+                                const LV2_Atom_Sequence* seq,
+                                LV2_URID                 midi_MidiEvent,
+                                uint8_t*                 buf,
+                                uint32_t                 capacity,
+                                uint32_t*                n_events)
+{
+	uint32_t offset = 0;
+	*n_events = 0;
+	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+		if (ev->body.type == midi_MidiEvent && ev->body.size) {
+			const uint8_t* const msg  = (const uint8_t*)(ev + 1);
+			const uint32_t       size = lv2_midi_encoder_write(
+				encoder, msg, ev->body.size, buf + offset, capacity - offset);
+			if (!size && msg[0] >= 0x80) {
+				break;
+			}
+
+			offset += size;
+			*n_events += size ? 1u : 0u;
+		}
+	}
+
+	return offset;
+}
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif  /* LV2_MIDI_STREAM_H */
+
+/**
+   @}
+*/
@@ -0,0 +1,417 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "lv2/atom/atom-test-utils.c"
+#include "lv2/atom/atom.h"
+#include "lv2/atom/forge.h"
+#include "lv2/time/time.h"
+#include "lv2/time/transport.h"
+#include "lv2/urid/urid.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RATE     48000.0
+#define CAPACITY 8192u
+
+typedef struct {
+	LV2_URID_Map       map;
+	LV2_Atom_Forge     forge;
+	LV2_Time_Transport transport;
+	uint8_t            buf[CAPACITY];
+} Test;
+
+/** Fields of a time:Position to write, where negative means absent. */
+typedef struct {
+	double  bar_beat;
+	double  bpm;
+	double  speed;
+	int64_t bar;
+} Position;
+
+static void
+begin_sequence(Test* test, LV2_Atom_Forge_Frame* frame, LV2_URID unit)
+{
+	lv2_atom_forge_set_buffer(&test->forge, test->buf, CAPACITY);
+	lv2_atom_forge_sequence_head(&test->forge, frame, unit);
+}
+
+static void
+write_position(Test* test, const Position* pos)
+{
+	LV2_Atom_Forge* const                 forge = &test->forge;
+	const LV2_Time_Transport_URIDs* const ids   = &test->transport.uris;
+
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_object(forge, &frame, 0, ids->time_Position);
+	if (pos->bar >= 0) {
+		lv2_atom_forge_key(forge, ids->time_bar);
+		lv2_atom_forge_long(forge, pos->bar);
+	}
+	if (pos->bar_beat >= 0.0) {
+		lv2_atom_forge_key(forge, ids->time_barBeat);
+		lv2_atom_forge_float(forge, (float)pos->bar_beat);
+	}
+	if (pos->bpm >= 0.0) {
+		lv2_atom_forge_key(forge, ids->time_beatsPerMinute);
+		lv2_atom_forge_double(forge, pos->bpm);
+	}
+	if (pos->speed >= 0.0) {
+		lv2_atom_forge_key(forge, ids->time_speed);
+		lv2_atom_forge_float(forge, (float)pos->speed);
+	}
+	lv2_atom_forge_pop(forge, &frame);
+}
+
+/** Read a sequence with a position at each frame in `frames`. */
+static uint32_t
+read_positions(Test*           test,
+               uint32_t        n_frames,
+               uint32_t        n_positions,
+               const int64_t*  frames,
+               const Position* positions)
+{
+	LV2_Atom_Forge_Frame frame;
+	begin_sequence(test, &frame, 0);
+	for (uint32_t i = 0; i < n_positions; ++i) {
+		lv2_atom_forge_frame_time(&test->forge, frames[i]);
+		write_position(test, &positions[i]);
+	}
+	lv2_atom_forge_pop(&test->forge, &frame);
+
+	return lv2_time_transport_read(
+		&test->transport, (const LV2_Atom_Sequence*)test->buf, n_frames);
+}
+
+/** Return true if a beat starts at `frame`, checked against beat_at(). */
+static bool
+starts_beat(Test* test, uint32_t frame, double beat)
+{
+	LV2_Time_Transport* const transport = &test->transport;
+
+	return (lv2_time_transport_beat_at(transport, frame) >= beat - 1.0e-9 &&
+	        (frame == 0 ||
+	         lv2_time_transport_beat_at(transport, frame - 1.0) < beat));
+}
+
+static int
+test_decode(Test* test)
+{
+	LV2_Atom_Forge* const                 forge = &test->forge;
+	const LV2_Time_Transport_URIDs* const ids   = &test->transport.uris;
+
+	// Write a position with every field, with a variety of number types
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_set_buffer(forge, test->buf, CAPACITY);
+	lv2_atom_forge_object(forge, &frame, 0, ids->time_Position);
+	lv2_atom_forge_key(forge, ids->time_bar);
+	lv2_atom_forge_long(forge, 7);
+	lv2_atom_forge_key(forge, ids->time_barBeat);
+	lv2_atom_forge_float(forge, 1.5f);
+	lv2_atom_forge_key(forge, ids->time_beatUnit);
+	lv2_atom_forge_int(forge, 8);
+	lv2_atom_forge_key(forge, ids->time_beatsPerBar);
+	lv2_atom_forge_float(forge, 6.0f);
+	lv2_atom_forge_key(forge, ids->time_beatsPerMinute);
+	lv2_atom_forge_double(forge, 90.0);
+	lv2_atom_forge_key(forge, ids->time_frame);
+	lv2_atom_forge_long(forge, 123456);
+	lv2_atom_forge_key(forge, ids->time_speed);
+	lv2_atom_forge_int(forge, 1);
+	lv2_atom_forge_pop(forge, &frame);
+
+	LV2_Time_Position        pos;
+	const LV2_Atom_Object*   obj   = (const LV2_Atom_Object*)test->buf;
+	static const uint32_t    all   = (LV2_TIME_HAS_BAR |
+	                                  LV2_TIME_HAS_BAR_BEAT |
+	                                  LV2_TIME_HAS_BEAT_UNIT |
+	                                  LV2_TIME_HAS_BEATS_PER_BAR |
+	                                  LV2_TIME_HAS_BEATS_PER_MINUTE |
+	                                  LV2_TIME_HAS_FRAME |
+	                                  LV2_TIME_HAS_SPEED);
+	if (!lv2_time_transport_decode(&test->transport, obj, &pos) ||
+	    pos.flags != all || pos.bar != 7 || pos.bar_beat != 1.5 ||
+	    pos.beat_unit != 8 || pos.beats_per_bar != 6.0 ||
+	    pos.beats_per_minute != 90.0 || pos.frame != 123456 ||
+	    pos.speed != 1.0) {
+		return test_fail("Failed to decode position\n");
+	}
+
+	// An invalid tempo is ignored
+	const Position invalid = { 0.0, 0.0, -1.0, -1 };
+	write_position(test, &invalid);
+	obj = (const LV2_Atom_Object*)(test->buf + lv2_atom_total_size(&obj->atom));
+	if (!lv2_time_transport_decode(&test->transport, obj, &pos) ||
+	    pos.flags != LV2_TIME_HAS_BAR_BEAT) {
+		return test_fail("Decoded invalid tempo\n");
+	}
+
+	// Other objects are not positions
+	lv2_atom_forge_set_buffer(forge, test->buf, CAPACITY);
+	lv2_atom_forge_object(forge, &frame, 0, ids->time_bar);
+	lv2_atom_forge_pop(forge, &frame);
+	if (lv2_time_transport_decode(
+		    &test->transport, (const LV2_Atom_Object*)test->buf, &pos)) {
+		return test_fail("Decoded object that is not a position\n");
+	}
+
+	return 0;
+}
+
+static int
+test_constant(Test* test)
+{
+	LV2_Time_Transport* const transport = &test->transport;
+	lv2_time_transport_init(transport, &test->map, RATE);
+
+	// Start at 120 BPM, so a beat is 24000 frames and a bar is 96000
+	const int64_t  frames[]    = { 0 };
+	const Position positions[] = { { 0.0, 120.0, 1.0, 0 } };
+	if (read_positions(test, 96000, 1, frames, positions) != 1) {
+		return test_fail("Failed to read position\n");
+	}
+
+	if (lv2_time_transport_beat_at(transport, 12000.0) != 0.5 ||
+	    lv2_time_transport_bpm_at(transport, 12000.0) != 120.0 ||
+	    lv2_time_transport_frame_at(transport, 0.0, 1.0) != 24000.0 ||
+	    lv2_time_transport_frame_at(transport, 0.0, 6.0) != 144000.0) {
+		return test_fail("Incorrect conversion at constant tempo\n");
+	}
+
+	double   beat = -1.0;
+	uint32_t f    = 0;
+	for (uint32_t i = 0; i < 4; ++i) {
+		f = lv2_time_transport_next_beat(transport, f, 96000, &beat);
+		if (f != i * 24000 || beat != (double)i) {
+			return test_fail("Beat %u at %u, not %u\n", i, f, i * 24000);
+		}
+		++f;
+	}
+
+	if (lv2_time_transport_next_beat(transport, f, 96000, NULL) != 96000) {
+		return test_fail("Found beat past the end of the block\n");
+	}
+
+	int64_t bar = -1;
+	if (lv2_time_transport_next_bar(transport, 0, 96000, &bar) != 0 ||
+	    bar != 0 || lv2_time_transport_next_bar(transport, 1, 96000, &bar) !=
+	                    96000) {
+		return test_fail("Incorrect bar boundaries\n");
+	}
+
+	// The next block continues from the end of this one
+	lv2_time_transport_begin(transport, 96000);
+	if (lv2_time_transport_beat_at(transport, 0.0) != 4.0 ||
+	    lv2_time_transport_next_bar(transport, 0, 96000, &bar) != 0 ||
+	    bar != 1) {
+		return test_fail("Position not continued in next block\n");
+	}
+
+	return 0;
+}
+
+static int
+test_ramp(Test* test)
+{
+	LV2_Time_Transport* const transport = &test->transport;
+	lv2_time_transport_init(transport, &test->map, RATE);
+
+	// Ramp from 60 to 180 BPM over one second, which is 2 beats
+	const int64_t  frames[]    = { 0, 48000 };
+	const Position positions[] = { { 0.0, 60.0, 1.0, -1 },
+	                               { -1.0, 180.0, -1.0, -1 } };
+	read_positions(test, 96000, 2, frames, positions);
+
+	if (fabs(lv2_time_transport_bpm_at(transport, 24000.0) - 120.0) > 1.0e-9 ||
+	    fabs(lv2_time_transport_beat_at(transport, 48000.0) - 2.0) > 1.0e-9) {
+		return test_fail("Incorrect tempo ramp\n");
+	}
+
+	// After the ramp, beats are 16000 frames apart
+	static const uint32_t expected[] = { 0, 29666, 48000, 64000, 80000 };
+	uint32_t              f          = 0;
+	double                beat       = 0.0;
+	for (uint32_t i = 0; i < 5; ++i) {
+		f = lv2_time_transport_next_beat(transport, f, 96000, &beat);
+		if (f != expected[i] || beat != (double)i ||
+		    !starts_beat(test, f, beat)) {
+			return test_fail("Beat %u at %u, not %u\n", i, f, expected[i]);
+		}
+
+		const double exact = lv2_time_transport_frame_at(transport, 0.0, beat);
+		if (exact > (double)f || exact <= (double)f - 1.0) {
+			return test_fail("Beat %u exactly at %f, not %u\n", i, exact, f);
+		}
+		++f;
+	}
+
+	return 0;
+}
+
+static int
+test_beat_time(Test* test)
+{
+	LV2_Time_Transport* const transport = &test->transport;
+	lv2_time_transport_init(transport, &test->map, RATE);
+
+	// Start rolling at 120 BPM, then change to 60 BPM a beat later
+	const LV2_URID       beat_time = transport->uris.atom_beatTime;
+	LV2_Atom_Forge_Frame frame;
+	begin_sequence(test, &frame, beat_time);
+	const Position start  = { 0.0, 120.0, 1.0, 0 };
+	const Position slower = { -1.0, 60.0, -1.0, -1 };
+	lv2_atom_forge_beat_time(&test->forge, 0.0);
+	write_position(test, &start);
+	lv2_atom_forge_beat_time(&test->forge, 1.0);
+	write_position(test, &slower);
+	lv2_atom_forge_pop(&test->forge, &frame);
+
+	/* The tempo ramps from 120 to 60 BPM over the first beat, an average of
+	   90 BPM, so the update is at 32000 frames. */
+	lv2_time_transport_read(
+		transport, (const LV2_Atom_Sequence*)test->buf, 48000);
+	if (transport->n_segments != 2 || transport->segments[1].offset != 32000 ||
+	    fabs(transport->segments[1].beat - 1.0) > 1.0e-9 ||
+	    lv2_time_transport_next_beat(transport, 1, 48000, NULL) != 32000) {
+		return test_fail("Incorrect beat time conversion\n");
+	}
+
+	return 0;
+}
+
+static int
+test_jumps(Test* test)
+{
+	LV2_Time_Transport* const transport = &test->transport;
+	lv2_time_transport_init(transport, &test->map, RATE);
+
+	// Roll at 120 BPM so beat 1 is half a frame before the end of the block
+	LV2_Time_Position pos;
+	memset(&pos, 0, sizeof(pos));
+	pos.flags = (LV2_TIME_HAS_BAR | LV2_TIME_HAS_BAR_BEAT |
+	             LV2_TIME_HAS_BEATS_PER_MINUTE | LV2_TIME_HAS_SPEED);
+	pos.bar_beat         = 1.0 - 999.5 / 24000.0;
+	pos.beats_per_minute = 120.0;
+	pos.speed            = 1.0;
+	lv2_time_transport_begin(transport, 1000);
+	lv2_time_transport_apply(transport, 0, &pos);
+	if (lv2_time_transport_next_beat(transport, 0, 1000, NULL) != 1000) {
+		return test_fail("Found beat before the end of the block\n");
+	}
+
+	// The beat starts at the first frame of the next block
+	double beat = 0.0;
+	lv2_time_transport_begin(transport, 1000);
+	if (lv2_time_transport_next_beat(transport, 0, 1000, &beat) != 0 ||
+	    beat != 1.0) {
+		return test_fail("Missed beat at the start of the block\n");
+	}
+
+	// Moving forwards past a beat starts it at the time of the update
+	pos.flags    = LV2_TIME_HAS_BAR_BEAT;
+	pos.bar_beat = 2.25;
+	lv2_time_transport_apply(transport, 100, &pos);
+	if (lv2_time_transport_next_beat(transport, 1, 1000, &beat) != 100 ||
+	    beat != 2.0) {
+		return test_fail("Missed beat skipped by an update\n");
+	}
+
+	// Moving backwards exactly to a beat starts it again
+	pos.bar_beat = 2.0;
+	lv2_time_transport_apply(transport, 200, &pos);
+	if (lv2_time_transport_next_beat(transport, 101, 1000, &beat) != 200 ||
+	    beat != 2.0 ||
+	    lv2_time_transport_next_beat(transport, 201, 1000, NULL) != 1000) {
+		return test_fail("Incorrect beat after moving backwards\n");
+	}
+
+	return 0;
+}
+
+static int
+test_sync(Test* test)
+{
+	LV2_Time_Transport* const transport = &test->transport;
+	lv2_time_transport_init(transport, &test->map, RATE);
+
+	// Start rolling near the end of bar 2
+	const int64_t  start_frames[] = { 0 };
+	const Position start[]        = { { 3.5, 120.0, 1.0, 2 } };
+	read_positions(test, 24000, 1, start_frames, start);
+
+	int64_t bar = 0;
+	if (lv2_time_transport_next_bar(transport, 0, 24000, &bar) != 12000 ||
+	    bar != 3) {
+		return test_fail("Incorrect bar after start\n");
+	}
+
+	// An update with only barBeat after the bar line stays in bar 3
+	const int64_t  frames[]    = { 0 };
+	const Position positions[] = { { 0.5, -1.0, -1.0, -1 } };
+	read_positions(test, 24000, 1, frames, positions);
+	if (lv2_time_transport_beat_at(transport, 0.0) != 12.5) {
+		return test_fail("Inferred wrong bar from barBeat\n");
+	}
+
+	// Stopping freezes the position, so there are no boundaries
+	const Position stop[] = { { 2.0, -1.0, 0.0, -1 } };
+	read_positions(test, 24000, 1, frames, stop);
+	if (lv2_time_transport_next_beat(transport, 0, 24000, NULL) != 24000 ||
+	    lv2_time_transport_beat_at(transport, 20000.0) != 14.0 ||
+	    lv2_time_transport_frame_at(transport, 0.0, 15.0) >= 0.0) {
+		return test_fail("Position changed while stopped\n");
+	}
+
+	// Updates past the maximum number of segments are ignored
+	int64_t  many_frames[LV2_TIME_TRANSPORT_MAX_SEGMENTS + 4];
+	Position many[LV2_TIME_TRANSPORT_MAX_SEGMENTS + 4];
+	for (uint32_t i = 0; i < LV2_TIME_TRANSPORT_MAX_SEGMENTS + 4; ++i) {
+		const Position pos = { -1.0, 120.0 + i, 1.0, -1 };
+		many_frames[i]     = i + 1;
+		many[i]            = pos;
+	}
+	if (read_positions(test,
+	                   256,
+	                   LV2_TIME_TRANSPORT_MAX_SEGMENTS + 4,
+	                   many_frames,
+	                   many) != LV2_TIME_TRANSPORT_MAX_SEGMENTS - 1 ||
+	    transport->n_segments != LV2_TIME_TRANSPORT_MAX_SEGMENTS) {
+		return test_fail("Incorrect number of segments\n");
+	}
+
+	return 0;
+}
+
+int
+main(void)
+{
+	Test* test = (Test*)calloc(1, sizeof(Test));
+	test->map.handle = NULL;
+	test->map.map    = urid_map;
+	lv2_atom_forge_init(&test->forge, &test->map);
+	lv2_time_transport_init(&test->transport, &test->map, RATE);
+
+	const int ret = (test_decode(test) || test_constant(test) ||
+	                 test_ramp(test) || test_beat_time(test) ||
+	                 test_jumps(test) || test_sync(test));
+
+	free(test);
+	free_urid_map();
+	return ret;
+}
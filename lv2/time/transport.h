@@ -0,0 +1,774 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @defgroup transport Transport
+   @ingroup time
+
+   A transport tracker for plugins that follow the host's musical time.
+
+   The tracker reads time:Position objects from an input sequence, and builds
+   a map of the position and tempo for the current block.  The block is
+   divided into segments at every position update, and the tempo ramps
+   linearly from each update to the next, so the position can be converted
+   between frames and beats exactly with a closed-form expression.
+
+   For example, a metronome can start a click on every beat in run() with:
+
+   @code
+   lv2_time_transport_read(&self->transport, self->ports.control, n_frames);
+
+   uint32_t offset = 0;
+   double   beat   = 0.0;
+   for (uint32_t f = 0;
+        (f = lv2_time_transport_next_beat(
+             &self->transport, f, n_frames, &beat)) < n_frames;
+        ++f) {
+       render(self, offset, f);
+       start_click(self, beat);
+       offset = f;
+   }
+   render(self, offset, n_frames);
+   @endcode
+
+   A boundary is found at its own frame, so the search for the next one
+   starts at the frame after it.
+
+   @{
+*/
+
+#ifndef LV2_TIME_TRANSPORT_H
+#define LV2_TIME_TRANSPORT_H
+
+#include "lv2/atom/atom.h"
+#include "lv2/atom/util.h"
+#include "lv2/time/time.h"
+#include "lv2/urid/urid.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of segments (position updates plus one) in a block. */
+#define LV2_TIME_TRANSPORT_MAX_SEGMENTS 64u
+
+/** Flags for the fields present in an LV2_Time_Position. */
+typedef enum {
+	LV2_TIME_HAS_BAR              = 1u << 0u,
+	LV2_TIME_HAS_BAR_BEAT         = 1u << 1u,
+	LV2_TIME_HAS_BEAT_UNIT        = 1u << 2u,
+	LV2_TIME_HAS_BEATS_PER_BAR    = 1u << 3u,
+	LV2_TIME_HAS_BEATS_PER_MINUTE = 1u << 4u,
+	LV2_TIME_HAS_FRAME            = 1u << 5u,
+	LV2_TIME_HAS_SPEED            = 1u << 6u
+} LV2_Time_Position_Flags;
+
+/** A time:Position decoded from an object. */
+typedef struct {
+	uint32_t flags;             ///< Fields present (LV2_Time_Position_Flags)
+	int64_t  bar;               ///< time:bar
+	double   bar_beat;          ///< time:barBeat
+	uint32_t beat_unit;         ///< time:beatUnit
+	double   beats_per_bar;     ///< time:beatsPerBar
+	double   beats_per_minute;  ///< time:beatsPerMinute
+	int64_t  frame;             ///< time:frame
+	double   speed;             ///< time:speed
+} LV2_Time_Position;
+
+/**
+   A span of the block with a constant speed and linearly changing tempo.
+
+   The position `dt` frames after the start of the segment is
+   `beat + speed * (bpm * dt + bpm_slope * dt * dt / 2) / (60 * rate)`.
+*/
+typedef struct {
+	uint32_t offset;         ///< Start of segment in frames from block start
+	double   beat;           ///< Position at start in beats since bar 0
+	double   bpm;            ///< Tempo at start
+	double   bpm_slope;      ///< Change in tempo per frame
+	double   speed;          ///< Transport speed
+	double   beats_per_bar;  ///< Time signature numerator
+	uint32_t beat_unit;      ///< Time signature denominator
+	double   frame;          ///< Transport frame at start
+} LV2_Time_Segment;
+
+/** URIDs used by the transport tracker. */
+typedef struct {
+	LV2_URID atom_Blank;
+	LV2_URID atom_Double;
+	LV2_URID atom_Float;
+	LV2_URID atom_Int;
+	LV2_URID atom_Long;
+	LV2_URID atom_Object;
+	LV2_URID atom_beatTime;
+	LV2_URID time_Position;
+	LV2_URID time_bar;
+	LV2_URID time_barBeat;
+	LV2_URID time_beatUnit;
+	LV2_URID time_beatsPerBar;
+	LV2_URID time_beatsPerMinute;
+	LV2_URID time_frame;
+	LV2_URID time_speed;
+} LV2_Time_Transport_URIDs;
+
+/**
+   Transport tracker.
+
+   This is a plain struct which must be initialised with
+   lv2_time_transport_init() and should be treated as opaque.
+*/
+typedef struct {
+	LV2_Time_Transport_URIDs uris;        ///< Mapped URIDs
+	double                   rate;        ///< Sample rate
+	uint32_t                 n_frames;    ///< Length of the current block
+	uint32_t                 n_segments;  ///< Number of segments in block
+	uint32_t                 cursor;      ///< Segment of the last lookup
+	double                   last_beat;   ///< Position at the previous frame
+	bool                     rolling;     ///< True if rolling at that frame
+	LV2_Time_Segment segments[LV2_TIME_TRANSPORT_MAX_SEGMENTS];
+} LV2_Time_Transport;
+
+/**
+   Reset a transport tracker to the initial position.
+
+   The transport is stopped at the beginning of bar 0, at 120 BPM in 4/4 time,
+   until the host sends a position.  This can be called in activate() so that
+   the plugin starts from scratch.
+*/
+static inline void
+lv2_time_transport_reset(LV2_Time_Transport* transport)
+{
+	LV2_Time_Segment* const seg = &transport->segments[0];
+
+	memset(seg, 0, sizeof(LV2_Time_Segment));
+	seg->bpm           = 120.0;
+	seg->beats_per_bar = 4.0;
+	seg->beat_unit     = 4;
+
+	transport->n_frames   = 0;
+	transport->n_segments = 1;
+	transport->cursor     = 0;
+	transport->last_beat  = 0.0;
+	transport->rolling    = false;
+}
+
+/**
+   Initialise a transport tracker.
+
+   This maps the URIs used by the tracker, so must not be called in the audio
+   thread.  The transport starts at the initial position, as after
+   lv2_time_transport_reset().
+*/
+static inline void
+lv2_time_transport_init(LV2_Time_Transport* transport,
+                        LV2_URID_Map*       map,
+                        double              rate)
+{
+	LV2_Time_Transport_URIDs* const ids = &transport->uris;
+
+	memset(transport, 0, sizeof(LV2_Time_Transport));
+	ids->atom_Blank          = map->map(map->handle, LV2_ATOM__Blank);
+	ids->atom_Double         = map->map(map->handle, LV2_ATOM__Double);
+	ids->atom_Float          = map->map(map->handle, LV2_ATOM__Float);
+	ids->atom_Int            = map->map(map->handle, LV2_ATOM__Int);
+	ids->atom_Long           = map->map(map->handle, LV2_ATOM__Long);
+	ids->atom_Object         = map->map(map->handle, LV2_ATOM__Object);
+	ids->atom_beatTime       = map->map(map->handle, LV2_ATOM__beatTime);
+	ids->time_Position       = map->map(map->handle, LV2_TIME__Position);
+	ids->time_bar            = map->map(map->handle, LV2_TIME__bar);
+	ids->time_barBeat        = map->map(map->handle, LV2_TIME__barBeat);
+	ids->time_beatUnit       = map->map(map->handle, LV2_TIME__beatUnit);
+	ids->time_beatsPerBar    = map->map(map->handle, LV2_TIME__beatsPerBar);
+	ids->time_beatsPerMinute = map->map(map->handle, LV2_TIME__beatsPerMinute);
+	ids->time_frame          = map->map(map->handle, LV2_TIME__frame);
+	ids->time_speed          = map->map(map->handle, LV2_TIME__speed);
+
+	transport->rate = rate;
+	lv2_time_transport_reset(transport);
+}
+
+/** Return the position `dt` frames after the start of `seg`. */
+static inline double
+lv2_time_segment_beat(const LV2_Time_Segment* seg, double rate, double dt)
+{
+	const double tempo = seg->bpm * dt + seg->bpm_slope * dt * dt / 2.0;
+	return seg->beat + seg->speed * tempo / (60.0 * rate);
+}
+
+/**
+   Return the number of frames after the start of `seg` when the position
+   reaches `beat`, or a negative number if it never does.
+
+   With a changing tempo, this is the positive root of a quadratic, which is
+   calculated in a form that is accurate when the slope is tiny.
+*/
+static inline double
+lv2_time_segment_frames_until(const LV2_Time_Segment* seg,
+                              double                  rate,
+                              double                  beat)
+{
+	if (!(seg->speed > 0.0)) {
+		return beat == seg->beat ? 0.0 : -1.0;
+	}
+
+	const double dist = (beat - seg->beat) * 60.0 * rate / seg->speed;
+	if (dist <= 0.0) {
+		return dist == 0.0 ? 0.0 : -1.0;
+	} else if (seg->bpm_slope == 0.0) {
+		return seg->bpm > 0.0 ? dist / seg->bpm : -1.0;
+	}
+
+	const double disc  = seg->bpm * seg->bpm + 2.0 * seg->bpm_slope * dist;
+	const double denom = disc >= 0.0 ? seg->bpm + sqrt(disc) : 0.0;
+	return denom > 0.0 ? 2.0 * dist / denom : -1.0;
+}
+
+/** Return the segment at the end of the current block. */
+static inline const LV2_Time_Segment*
+lv2_time_transport_last(const LV2_Time_Transport* transport)
+{
+	return &transport->segments[transport->n_segments - 1];
+}
+
+/** Return the frame offset where segment `i` ends in the current block. */
+static inline uint32_t
+lv2_time_transport_segment_end(const LV2_Time_Transport* transport,
+                               uint32_t                  i)
+{
+	return (i + 1 < transport->n_segments ? transport->segments[i + 1].offset
+	                                      : transport->n_frames);
+}
+
+/**
+   Return the index of the segment that contains frame `frame`.
+
+   The search starts at the segment of the previous lookup, so lookups in
+   increasing order, as in a typical run(), take constant time.
+*/
+static inline uint32_t
+lv2_time_transport_find(LV2_Time_Transport* transport, double frame)
+{
+	uint32_t i = transport->cursor < transport->n_segments
+	                 ? transport->cursor
+	                 : 0;
+
+	if (frame < (double)transport->segments[i].offset) {
+		i = 0;
+	}
+
+	while (i + 1 < transport->n_segments &&
+	       frame >= (double)transport->segments[i + 1].offset) {
+		++i;
+	}
+
+	return (transport->cursor = i);
+}
+
+/**
+   Begin a new block of `n_frames` frames.
+
+   The state at the end of the previous block is carried over as a single
+   segment covering the whole block.  This is called by
+   lv2_time_transport_read(), and only needs to be called directly when
+   applying positions decoded by the plugin itself.
+*/
+static inline void
+lv2_time_transport_begin(LV2_Time_Transport* transport, uint32_t n_frames)
+{
+	if (transport->n_frames > 0) {
+		// Remember the position at the last frame, to find boundaries at 0
+		const double                  end = (double)transport->n_frames - 1.0;
+		const LV2_Time_Segment* const at  = &transport->segments[
+			lv2_time_transport_find(transport, end)];
+
+		transport->last_beat = lv2_time_segment_beat(
+			at, transport->rate, end - (double)at->offset);
+		transport->rolling = at->speed > 0.0;
+	}
+
+	const LV2_Time_Segment* const last = lv2_time_transport_last(transport);
+	LV2_Time_Segment* const       seg  = &transport->segments[0];
+	const double dt = (double)(transport->n_frames - last->offset);
+
+	if (dt > 0.0) {
+		seg->beat  = lv2_time_segment_beat(last, transport->rate, dt);
+		seg->bpm   = last->bpm + last->bpm_slope * dt;
+		seg->frame = last->frame + last->speed * dt;
+	} else {
+		seg->beat  = last->beat;
+		seg->bpm   = last->bpm;
+		seg->frame = last->frame;
+	}
+
+	seg->offset        = 0;
+	seg->bpm_slope     = 0.0;
+	seg->speed         = last->speed;
+	seg->beats_per_bar = last->beats_per_bar;
+	seg->beat_unit     = last->beat_unit;
+
+	transport->n_frames   = n_frames;
+	transport->n_segments = 1;
+	transport->cursor     = 0;
+}
+
+/** Read a numeric atom of any type as a double, or return false. */
+static inline bool
+lv2_time_transport_number(const LV2_Time_Transport* transport,
+                          const LV2_Atom*           atom,
+                          double*                   value)
+{
+	const LV2_Time_Transport_URIDs* const ids = &transport->uris;
+
+	if (atom->type == ids->atom_Float && atom->size >= sizeof(float)) {
+		*value = ((const LV2_Atom_Float*)atom)->body;
+	} else if (atom->type == ids->atom_Double &&
+	           atom->size >= sizeof(double)) {
+		*value = ((const LV2_Atom_Double*)atom)->body;
+	} else if (atom->type == ids->atom_Int && atom->size >= sizeof(int32_t)) {
+		*value = ((const LV2_Atom_Int*)atom)->body;
+	} else if (atom->type == ids->atom_Long && atom->size >= sizeof(int64_t)) {
+		*value = (double)((const LV2_Atom_Long*)atom)->body;
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+/**
+   Decode a time:Position object.
+
+   Numeric properties may be of any atom number type, since hosts differ in
+   which they send.  Properties that are missing or invalid (for example, a
+   tempo that is not positive) are not set in `pos->flags`.
+
+   @return True if `object` is a time:Position (or a deprecated Blank with
+   that type).
+*/
+static inline bool
+lv2_time_transport_decode(const LV2_Time_Transport* transport,
+                          const LV2_Atom_Object*    object,
+                          LV2_Time_Position*        pos)
+{
+	const LV2_Time_Transport_URIDs* const ids = &transport->uris;
+
+	memset(pos, 0, sizeof(LV2_Time_Position));
+	if ((object->atom.type != ids->atom_Object &&
+	     object->atom.type != ids->atom_Blank) ||
+	    object->body.otype != ids->time_Position) {
+		return false;
+	}
+
+	LV2_ATOM_OBJECT_FOREACH(object, prop) {
+		double value = 0.0;
+		if (!lv2_time_transport_number(transport, &prop->value, &value)) {
+			continue;
+		} else if (prop->key == ids->time_bar) {
+			pos->bar = (int64_t)value;
+			pos->flags |= LV2_TIME_HAS_BAR;
+		} else if (prop->key == ids->time_barBeat && value >= 0.0) {
+			pos->bar_beat = value;
+			pos->flags |= LV2_TIME_HAS_BAR_BEAT;
+		} else if (prop->key == ids->time_beatUnit && value >= 1.0) {
+			pos->beat_unit = (uint32_t)value;
+			pos->flags |= LV2_TIME_HAS_BEAT_UNIT;
+		} else if (prop->key == ids->time_beatsPerBar && value > 0.0) {
+			pos->beats_per_bar = value;
+			pos->flags |= LV2_TIME_HAS_BEATS_PER_BAR;
+		} else if (prop->key == ids->time_beatsPerMinute && value > 0.0) {
+			pos->beats_per_minute = value;
+			pos->flags |= LV2_TIME_HAS_BEATS_PER_MINUTE;
+		} else if (prop->key == ids->time_frame) {
+			pos->frame = (int64_t)value;
+			pos->flags |= LV2_TIME_HAS_FRAME;
+		} else if (prop->key == ids->time_speed) {
+			pos->speed = value;
+			pos->flags |= LV2_TIME_HAS_SPEED;
+		}
+	}
+
+	return true;
+}
+
+/**
+   Apply a position update at frame `offset` in the current block.
+
+   This starts a new segment, and sets the tempo of the previous one to ramp
+   linearly to the new tempo.  Updates must be applied in time order, so an
+   offset before the previous update is moved to it, and an offset past the
+   end of the block is moved to the end.  If the update has no time:bar, the
+   bar is chosen to be the closest to the current position, since many hosts
+   only send time:barBeat.  Updates past LV2_TIME_TRANSPORT_MAX_SEGMENTS in
+   one block are ignored.
+
+   @return False if the update was ignored.
+*/
+static inline bool
+lv2_time_transport_apply(LV2_Time_Transport*      transport,
+                         uint32_t                 offset,
+                         const LV2_Time_Position* pos)
+{
+	LV2_Time_Segment* const prev = &transport->segments[
+		transport->n_segments - 1];
+	LV2_Time_Segment* seg = prev;
+
+	if (offset > transport->n_frames) {
+		offset = transport->n_frames;
+	}
+
+	if (offset > prev->offset) {
+		if (transport->n_segments == LV2_TIME_TRANSPORT_MAX_SEGMENTS) {
+			return false;
+		}
+
+		// Ramp to the new tempo, then continue from the end of the ramp
+		const double dt = (double)(offset - prev->offset);
+		if (pos->flags & LV2_TIME_HAS_BEATS_PER_MINUTE) {
+			prev->bpm_slope = (pos->beats_per_minute - prev->bpm) / dt;
+		}
+
+		seg         = &transport->segments[transport->n_segments++];
+		*seg        = *prev;
+		seg->offset = offset;
+		seg->beat   = lv2_time_segment_beat(prev, transport->rate, dt);
+		seg->bpm    = prev->bpm + prev->bpm_slope * dt;
+		seg->frame  = prev->frame + prev->speed * dt;
+		seg->bpm_slope = 0.0;
+	} else if (transport->n_segments > 1 &&
+	           (pos->flags & LV2_TIME_HAS_BEATS_PER_MINUTE)) {
+		// Another update at the same time, ramp to its tempo instead
+		LV2_Time_Segment* const before = prev - 1;
+		before->bpm_slope = ((pos->beats_per_minute - before->bpm) /
+		                     (double)(prev->offset - before->offset));
+	}
+
+	if (pos->flags & LV2_TIME_HAS_BEATS_PER_MINUTE) {
+		seg->bpm = pos->beats_per_minute;
+	}
+	if (pos->flags & LV2_TIME_HAS_SPEED) {
+		seg->speed = pos->speed;
+	}
+	if (pos->flags & LV2_TIME_HAS_FRAME) {
+		seg->frame = (double)pos->frame;
+	}
+	if (pos->flags & LV2_TIME_HAS_BEAT_UNIT) {
+		seg->beat_unit = pos->beat_unit;
+	}
+
+	// Keep the bar number when the time signature changes
+	const double old_bar = floor(seg->beat / seg->beats_per_bar);
+	if (pos->flags & LV2_TIME_HAS_BEATS_PER_BAR) {
+		const double bar_beat = seg->beat - old_bar * seg->beats_per_bar;
+		seg->beats_per_bar    = pos->beats_per_bar;
+		seg->beat             = old_bar * seg->beats_per_bar + bar_beat;
+	}
+
+	if (pos->flags & LV2_TIME_HAS_BAR_BEAT) {
+		const double bpb = seg->beats_per_bar;
+		const double bar = ((pos->flags & LV2_TIME_HAS_BAR)
+		                    ? (double)pos->bar
+		                    : floor((seg->beat - pos->bar_beat) / bpb + 0.5));
+
+		seg->beat = bar * bpb + pos->bar_beat;
+	} else if (pos->flags & LV2_TIME_HAS_BAR) {
+		seg->beat = (double)pos->bar * seg->beats_per_bar +
+		            (seg->beat - old_bar * seg->beats_per_bar);
+	}
+
+	return true;
+}
+
+/**
+   Read every time:Position in `seq` as the map for a block of `n_frames`.
+
+   This begins a new block, and applies every position update in the
+   sequence.  If the sequence is timed in beats (atom:beatTime), the time of
+   each event is taken to be relative to the start of the block, and is
+   converted to frames at the tempo ramp from the previous update.
+
+   @return The number of position updates that were applied.
+*/
+static inline uint32_t
+lv2_time_transport_read(LV2_Time_Transport*      transport,
+                        const LV2_Atom_Sequence* seq,
+                        uint32_t                 n_frames)
+{
+	const bool beat_time = seq->body.unit == transport->uris.atom_beatTime;
+
+	lv2_time_transport_begin(transport, n_frames);
+
+	uint32_t n_updates = 0;
+	double   beats     = 0.0;  // Beat time of the previous update
+	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+		LV2_Time_Position pos;
+		if (!lv2_time_transport_decode(
+			    transport, (const LV2_Atom_Object*)&ev->body, &pos)) {
+			continue;
+		}
+
+		const LV2_Time_Segment* const prev = lv2_time_transport_last(
+			transport);
+
+		uint32_t offset = 0;
+		if (beat_time) {
+			// Solve for the frames where the average tempo reaches it
+			const double next_bpm = ((pos.flags & LV2_TIME_HAS_BEATS_PER_MINUTE)
+			                         ? pos.beats_per_minute
+			                         : prev->bpm);
+			const double dist = ev->time.beats - beats;
+			const double t    = ((dist > 0.0 && prev->speed > 0.0)
+			                     ? ceil(2.0 * dist * 60.0 * transport->rate /
+			                            (prev->speed * (prev->bpm + next_bpm)))
+			                     : 0.0);
+
+			offset = (t < (double)(n_frames - prev->offset)
+			          ? prev->offset + (uint32_t)t
+			          : n_frames);
+			beats = ev->time.beats > beats ? ev->time.beats : beats;
+		} else {
+			const int64_t t = ev->time.frames;
+			offset = (t <= 0                  ? 0u
+			          : t >= (int64_t)n_frames ? n_frames
+			                                   : (uint32_t)t);
+		}
+
+		n_updates += lv2_time_transport_apply(transport, offset, &pos);
+	}
+
+	return n_updates;
+}
+
+/** Return the position at frame `frame` in the current block, in beats. */
+static inline double
+lv2_time_transport_beat_at(LV2_Time_Transport* transport, double frame)
+{
+	const uint32_t                i   = lv2_time_transport_find(transport,
+	                                                            frame);
+	const LV2_Time_Segment* const seg = &transport->segments[i];
+
+	return lv2_time_segment_beat(
+		seg, transport->rate, frame - (double)seg->offset);
+}
+
+/** Return the tempo at frame `frame` in the current block. */
+static inline double
+lv2_time_transport_bpm_at(LV2_Time_Transport* transport, double frame)
+{
+	const uint32_t                i   = lv2_time_transport_find(transport,
+	                                                            frame);
+	const LV2_Time_Segment* const seg = &transport->segments[i];
+
+	return seg->bpm + seg->bpm_slope * (frame - (double)seg->offset);
+}
+
+/**
+   Return the first frame at or after `from` when the position reaches
+   `beat`, or a negative number if it does not.
+
+   The result is exact (not rounded to a whole frame), and may be past the
+   end of the block if the position reaches `beat` later at the tempo at the
+   end of the block.
+*/
+static inline double
+lv2_time_transport_frame_at(LV2_Time_Transport* transport,
+                            double              from,
+                            double              beat)
+{
+	for (uint32_t i = lv2_time_transport_find(transport, from);
+	     i < transport->n_segments;
+	     ++i) {
+		const LV2_Time_Segment* const seg   = &transport->segments[i];
+		const double                  begin = (from > (double)seg->offset
+		                                       ? from
+		                                       : (double)seg->offset);
+
+		const double dt_begin = begin - (double)seg->offset;
+		const double t        = lv2_time_segment_frames_until(
+			seg, transport->rate, beat);
+
+		const bool last = i + 1 == transport->n_segments;
+		const double end = (double)lv2_time_transport_segment_end(transport, i);
+		if (t >= dt_begin && (last || (double)seg->offset + t < end)) {
+			transport->cursor = i;
+			return (double)seg->offset + t;
+		}
+	}
+
+	return -1.0;
+}
+
+/**
+   Get the position at the frame before `frame` in segment `i`.
+
+   @return False if the transport was not rolling at that frame.
+*/
+static inline bool
+lv2_time_transport_prev_beat(const LV2_Time_Transport* transport,
+                             uint32_t                  i,
+                             uint32_t                  frame,
+                             double*                   beat)
+{
+	const LV2_Time_Segment* const seg = &transport->segments[i];
+	if (frame > seg->offset) {
+		*beat = lv2_time_segment_beat(
+			seg, transport->rate, (double)(frame - seg->offset) - 1.0);
+		return seg->speed > 0.0;
+	} else if (i > 0) {
+		const LV2_Time_Segment* const prev = seg - 1;
+		*beat = lv2_time_segment_beat(
+			prev, transport->rate, (double)(frame - prev->offset) - 1.0);
+		return prev->speed > 0.0;
+	}
+
+	*beat = transport->last_beat;
+	return transport->rolling;
+}
+
+/**
+   Return the first frame in [begin, end) where a beat or bar starts, or `end`
+   if there is none.
+
+   A boundary starts at a frame if the position passes it between the
+   previous frame and that one, so for beats, this is the frame where a click
+   on the beat should start.  This is also the case when the host moves the
+   position past a boundary, so no boundary is skipped due to small
+   differences between the host's position and the tempo.  Boundaries are
+   only found while the transport is rolling forwards.
+
+   @param transport Transport tracker.
+   @param begin Start of the range in frames from the start of the block.
+   @param end End of the range in frames from the start of the block.
+   @param bars Find the start of a bar rather than a beat.
+   @param boundary Set to the position of the boundary in beats, if not NULL.
+*/
+static inline uint32_t
+lv2_time_transport_next(LV2_Time_Transport* transport,
+                        uint32_t            begin,
+                        uint32_t            end,
+                        bool                bars,
+                        double*             boundary)
+{
+	const uint32_t n_frames = transport->n_frames;
+	const uint32_t limit    = end < n_frames ? end : n_frames;
+
+	for (uint32_t i = lv2_time_transport_find(transport, (double)begin);
+	     begin < limit && i < transport->n_segments;
+	     ++i) {
+		const LV2_Time_Segment* const seg     = &transport->segments[i];
+		const uint32_t                seg_end = lv2_time_transport_segment_end(
+			transport, i);
+
+		const uint32_t first = begin > seg->offset ? begin : seg->offset;
+		const uint32_t last  = seg_end < limit ? seg_end : limit;
+		if (first >= last || !(seg->speed > 0.0)) {
+			continue;
+		}
+
+		const double period = bars ? seg->beats_per_bar : 1.0;
+		const double rate   = transport->rate;
+		const double beat   = lv2_time_segment_beat(
+			seg, rate, (double)(first - seg->offset));
+
+		/* Find the first boundary after the position at the previous frame,
+		   or at or after the current position if it moved backwards. */
+		double     prev  = 0.0;
+		const bool ahead = (lv2_time_transport_prev_beat(
+			                    transport, i, first, &prev) &&
+		                    prev <= beat);
+		const double next = (ahead ? (floor(prev / period) + 1.0) * period
+		                           : ceil(beat / period) * period);
+
+		if (next <= beat) {
+			// Passed a boundary since the previous frame
+			if (boundary) {
+				*boundary = floor(beat / period) * period;
+			}
+
+			transport->cursor = i;
+			return first;
+		} else if (next > lv2_time_segment_beat(
+			           seg, rate, (double)(last - 1 - seg->offset))) {
+			continue;  // No boundary in this segment
+		}
+
+		// Solve for the frame where the position reaches the boundary
+		const double t     = lv2_time_segment_frames_until(seg, rate, next);
+		const double frame = (double)seg->offset + ceil(t);
+		if (t >= 0.0 && frame < (double)last) {
+			if (boundary) {
+				*boundary = next;
+			}
+
+			transport->cursor = i;
+			return frame > (double)first ? (uint32_t)frame : first;
+		}
+	}
+
+	return end;
+}
+
+/**
+   Return the first frame in [begin, end) where a beat starts, or `end`.
+
+   If `beat` is not NULL, it is set to the position of the beat that starts,
+   which is a whole number of beats since the start of bar 0.
+*/
+static inline uint32_t
+lv2_time_transport_next_beat(LV2_Time_Transport* transport,
+                             uint32_t            begin,
+                             uint32_t            end,
+                             double*             beat)
+{
+	return lv2_time_transport_next(transport, begin, end, false, beat);
+}
+
+/**
+   Return the first frame in [begin, end) where a bar starts, or `end`.
+
+   If `bar` is not NULL, it is set to the number of the bar that starts.
+*/
+static inline uint32_t
+lv2_time_transport_next_bar(LV2_Time_Transport* transport,
+                            uint32_t            begin,
+                            uint32_t            end,
+                            int64_t*            bar)
+{
+	double         beat  = 0.0;
+	const uint32_t frame = lv2_time_transport_next(
+		transport, begin, end, true, &beat);
+
+	if (bar && frame < end) {
+		const double bpb = transport->segments[transport->cursor].beats_per_bar;
+		*bar             = (int64_t)floor(beat / bpb + 0.5);
+	}
+
+	return frame;
+}
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif  /* LV2_TIME_TRANSPORT_H */
+
+/**
+   @}
+*/
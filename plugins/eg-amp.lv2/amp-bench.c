@@ -0,0 +1,334 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   Benchmark of the gain kernels, and of running many amplifier instances with
+   the batch interface compared to calling run() for every instance.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "amp.c"
+
+#include "lv2/atom/atom-bench-utils.c"
+#include "lv2/batch/batch.h"
+#include "lv2/core/lv2.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_INSTANCES  64u
+#define MAX_BLOCK_SIZE 1024u
+
+typedef struct {
+	const LV2_Descriptor*      desc;
+	const LV2_Batch_Interface* batch;
+	LV2_Handle                 instances[MAX_INSTANCES];
+	float                      gains[MAX_INSTANCES];
+	float*                     inputs[MAX_INSTANCES];
+	float*                     outputs[MAX_INSTANCES];
+	uint32_t                   n_instances;
+	uint32_t                   block_size;
+} Context;
+
+static void
+run_separate(void* data)
+{
+	const Context* const ctx = (const Context*)data;
+	lv2_batch_run(ctx->desc, NULL, ctx->instances, ctx->n_instances,
+	              ctx->block_size);
+}
+
+static void
+run_batched(void* data)
+{
+	const Context* const ctx = (const Context*)data;
+	lv2_batch_run(ctx->desc, ctx->batch, ctx->instances, ctx->n_instances,
+	              ctx->block_size);
+}
+
+/** Return true if `a` and `b` are equal within a small relative error. */
+static bool
+approx_equal(float a, float b)
+{
+	return fabsf(a - b) <= 1.0e-6f * fabsf(b);
+}
+
+/** Return true if the gain kernels match a scalar reference for `n` samples. */
+static bool
+check_kernels(float* in, float* out, uint32_t n)
+{
+	const float from = 0.5f;
+	const float to   = 2.0f;
+	const float step = (to - from) / (float)n;
+
+	for (uint32_t i = 0; i < n; ++i) {
+		in[i] = (float)i + 1.0f;
+	}
+
+	gain_apply(in, out, to, n);
+	for (uint32_t i = 0; i < n; ++i) {
+		if (out[i] != ((float)i + 1.0f) * to) {
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < n; ++i) {
+		in[i] = (float)i + 1.0f;  // Restore input in case it was overwritten
+	}
+
+	gain_apply_ramp(in, out, from, to, n);
+	for (uint32_t i = 0; i < n; ++i) {
+		const float coef = from + step * (float)(i + 1);
+		if (!approx_equal(out[i], ((float)i + 1.0f) * coef)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/** Check the gain kernels for every alignment, in-place, and edge cases. */
+static bool
+check_gain(void)
+{
+	static float          in_buf[MAX_BLOCK_SIZE + 4];
+	static float          out_buf[MAX_BLOCK_SIZE + 4];
+	static const uint32_t sizes[] = { 0, 1, 3, 4, 5, 17, 64 };
+
+	for (uint32_t s = 0; s < sizeof(sizes) / sizeof(uint32_t); ++s) {
+		for (uint32_t i = 0; i < 4; ++i) {
+			for (uint32_t o = 0; o < 4; ++o) {
+				if (!check_kernels(in_buf + i, out_buf + o, sizes[s])) {
+					fprintf(stderr, "error: Gain differs (%u, %u, %u)\n",
+					        sizes[s], i, o);
+					return false;
+				}
+			}
+
+			if (!check_kernels(in_buf + i, in_buf + i, sizes[s])) {
+				fprintf(stderr, "error: In-place gain differs (%u, %u)\n",
+				        sizes[s], i);
+				return false;
+			}
+		}
+	}
+
+	// A change during an empty block is applied to the next block
+	GainState state;
+	float     sample = 1.0f;
+	gain_reset(&state);
+	gain_run(&state, 0.0f, &sample, &sample, 1);
+	gain_run(&state, -6.0f, NULL, NULL, 0);
+	if (state.db != 0.0f) {
+		fprintf(stderr, "error: Gain changed in empty block\n");
+		return false;
+	}
+
+	// NaN and anything below the minimum is silent
+	sample = 1.0f;
+	gain_run(&state, NAN, &sample, &sample, 1);
+	gain_run(&state, NAN, &sample, &sample, 1);
+	if (sample != 0.0f || gain_db_to_coef(GAIN_MIN_DB - 1.0f) != 0.0f) {
+		fprintf(stderr, "error: Gain is not silent\n");
+		return false;
+	}
+
+	// After a reset, the first block is not ramped
+	sample = 1.0f;
+	gain_reset(&state);
+	gain_run(&state, 20.0f, &sample, &sample, 1);
+	if (!approx_equal(sample, 10.0f)) {
+		fprintf(stderr, "error: Gain ramped after reset\n");
+		return false;
+	}
+
+	return true;
+}
+
+/**
+   Return true if running separately and in a batch give the same output.
+
+   Two sets of instances share the same gain and input buffers.  One is run
+   separately and the other in a batch, for several blocks where gains
+   sometimes change, so both the batched and fallback paths are checked.
+*/
+static bool
+check_batch(const Context* ctx, uint32_t n_instances, uint32_t block_size)
+{
+	const LV2_Descriptor* const desc = ctx->desc;
+
+	static float gains[MAX_INSTANCES];
+	static float outputs[2][MAX_INSTANCES][MAX_BLOCK_SIZE];
+	LV2_Handle   instances[2][MAX_INSTANCES];
+	for (uint32_t s = 0; s < 2; ++s) {
+		for (uint32_t i = 0; i < n_instances; ++i) {
+			LV2_Handle inst = desc->instantiate(desc, 48000.0, "", NULL);
+
+			gains[i] = (float)i;
+			desc->connect_port(inst, AMP_GAIN, &gains[i]);
+			desc->connect_port(inst, AMP_INPUT, ctx->inputs[i]);
+			desc->connect_port(inst, AMP_OUTPUT, outputs[s][i]);
+			desc->activate(inst);
+			instances[s][i] = inst;
+		}
+	}
+
+	bool ok = true;
+	for (uint32_t b = 0; ok && b < 4; ++b) {
+		if (b == 2 && n_instances > 1) {
+			gains[1] = -3.0f;  // Change a gain in the first group
+		}
+
+		lv2_batch_run(desc, NULL, instances[0], n_instances, block_size);
+		lv2_batch_run(desc, ctx->batch, instances[1], n_instances, block_size);
+		for (uint32_t i = 0; ok && i < n_instances; ++i) {
+			ok = !memcmp(outputs[0][i], outputs[1][i],
+			             block_size * sizeof(float));
+		}
+	}
+
+	for (uint32_t s = 0; s < 2; ++s) {
+		for (uint32_t i = 0; i < n_instances; ++i) {
+			desc->deactivate(instances[s][i]);
+			desc->cleanup(instances[s][i]);
+		}
+	}
+
+	if (!ok) {
+		fprintf(stderr, "error: Batch output differs (%u x %u)\n",
+		        n_instances, block_size);
+	}
+
+	return ok;
+}
+
+static void
+apply_aligned(void* data)
+{
+	const Context* const ctx = (const Context*)data;
+	gain_apply(ctx->inputs[0], ctx->outputs[0], 0.5f, ctx->block_size);
+}
+
+static void
+apply_unaligned(void* data)
+{
+	const Context* const ctx = (const Context*)data;
+	gain_apply(ctx->inputs[0] + 1, ctx->outputs[0], 0.5f, ctx->block_size);
+}
+
+static void
+apply_ramp(void* data)
+{
+	const Context* const ctx = (const Context*)data;
+	gain_apply_ramp(
+		ctx->inputs[0], ctx->outputs[0], 0.5f, 1.0f, ctx->block_size);
+}
+
+static void
+run_automated(void* data)
+{
+	Context* const ctx = (Context*)data;
+	ctx->gains[0] = ctx->gains[0] > 0.0f ? -1.0f : 1.0f;
+	ctx->desc->run(ctx->instances[0], ctx->block_size);
+}
+
+int
+main(void)
+{
+	Context ctx;
+	memset(&ctx, 0, sizeof(ctx));
+
+	ctx.desc  = lv2_descriptor(0);
+	ctx.batch = (const LV2_Batch_Interface*)ctx.desc->extension_data(
+		LV2_BATCH__interface);
+	if (!ctx.batch) {
+		fprintf(stderr, "error: Batch interface not provided\n");
+		return 1;
+	}
+
+	// Create instances with separate buffers, like channels in a mixer
+	for (uint32_t i = 0; i < MAX_INSTANCES; ++i) {
+		ctx.instances[i] = ctx.desc->instantiate(ctx.desc, 48000.0, "", NULL);
+		ctx.gains[i]     = (float)(i % 12) - 6.0f;
+		ctx.inputs[i]    = (float*)calloc(MAX_BLOCK_SIZE, sizeof(float));
+		ctx.outputs[i]   = (float*)calloc(MAX_BLOCK_SIZE, sizeof(float));
+		for (uint32_t s = 0; s < MAX_BLOCK_SIZE; ++s) {
+			ctx.inputs[i][s] = (float)s / (float)MAX_BLOCK_SIZE - 0.5f;
+		}
+
+		ctx.desc->connect_port(ctx.instances[i], AMP_GAIN, &ctx.gains[i]);
+		ctx.desc->connect_port(ctx.instances[i], AMP_INPUT, ctx.inputs[i]);
+		ctx.desc->connect_port(ctx.instances[i], AMP_OUTPUT, ctx.outputs[i]);
+		ctx.desc->activate(ctx.instances[i]);
+	}
+
+	// Check results, including partial batches and blocks
+	bool ok = (check_gain() &&
+	           check_batch(&ctx, MAX_INSTANCES, MAX_BLOCK_SIZE) &&
+	           check_batch(&ctx, 7, 61) &&
+	           check_batch(&ctx, 3, 2) &&
+	           check_batch(&ctx, 0, 64));
+
+	bench_begin();
+
+	if (ok) {
+		// Gain kernels with constant, unaligned, and ramped coefficients
+		ctx.block_size = 256;
+		bench_run("gain_apply_256", apply_aligned, &ctx, 256);
+		bench_run("gain_apply_unaligned_256", apply_unaligned, &ctx, 256);
+		bench_run("gain_apply_ramp_256", apply_ramp, &ctx, 256);
+
+		// A single instance with constant and automated gain
+		ctx.block_size = 64;
+		ctx.n_instances = 1;
+		bench_run("run_constant_64", run_separate, &ctx, 64);
+		bench_run("run_automated_64", run_automated, &ctx, 64);
+	}
+
+	static const uint32_t counts[] = { 4, 64 };
+	static const uint32_t sizes[]  = { 16, 64, 256, 1024 };
+	for (uint32_t c = 0; ok && c < sizeof(counts) / sizeof(uint32_t); ++c) {
+		for (uint32_t s = 0; s < sizeof(sizes) / sizeof(uint32_t); ++s) {
+			ctx.n_instances = counts[c];
+			ctx.block_size  = sizes[s];
+
+			const uint64_t n_ops = (uint64_t)counts[c] * sizes[s];
+			char           name[48];
+
+			snprintf(name, sizeof(name), "run_%ux%u", counts[c], sizes[s]);
+			bench_run(name, run_separate, &ctx, n_ops);
+
+			snprintf(name, sizeof(name), "run_batch_%ux%u", counts[c], sizes[s]);
+			bench_run(name, run_batched, &ctx, n_ops);
+		}
+	}
+
+	bench_end();
+
+	for (uint32_t i = 0; i < MAX_INSTANCES; ++i) {
+		ctx.desc->deactivate(ctx.instances[i]);
+		ctx.desc->cleanup(ctx.instances[i]);
+		free(ctx.outputs[i]);
+		free(ctx.inputs[i]);
+	}
+
+	return ok ? 0 : 1;
+}
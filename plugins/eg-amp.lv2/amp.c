@@ -22,12 +22,19 @@
    replacing `http:/` with `lv2` any header in the specification bundle can be
    included, in this case `lv2.h`.
 */
+#include "lv2/batch/batch.h"
 #include "lv2/core/lv2.h"
 
+/**
+   The gain processing itself is in `gain.h`, which is written so it can be
+   copied into other plugins that need a gain control.
+*/
+#include "gain.h"
+
 /** Include standard C headers */
-#include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 /**
    The URI is the identifier for a plugin, and how the host associates this
@@ -51,14 +58,17 @@ typedef enum {
 /**
    Every plugin defines a private structure for the plugin instance.  All data
    associated with a plugin instance is stored here, and is available to
-   every instance method.  In this simple plugin, only port buffers need to be
-   stored, since there is no additional instance data.
+   every instance method.  In this simple plugin, the only other instance data
+   is the last gain, so the coefficient is only recalculated when it changes.
 */
 typedef struct {
 	// Port buffers
 	const float* gain;
 	const float* input;
 	float*       output;
+
+	// Last gain and coefficient
+	GainState gain_state;
 } Amp;
 
 /**
@@ -113,8 +123,8 @@ connect_port(LV2_Handle instance,
 /**
    The `activate()` method is called by the host to initialise and prepare the
    plugin instance for running.  The plugin must reset all internal state
-   except for buffer locations set by `connect_port()`.  Since this plugin has
-   no other internal state, this method does nothing.
+   except for buffer locations set by `connect_port()`.  Here, the last gain is
+   forgotten, so the first block is processed at its gain without a ramp.
 
    This method is in the ``instantiation'' threading class, so no other
    methods on this instance will be called concurrently with it.
@@ -122,30 +132,57 @@ connect_port(LV2_Handle instance,
 static void
 activate(LV2_Handle instance)
 {
-}
+	Amp* amp = (Amp*)instance;
 
-/** Define a macro for converting a gain in dB to a coefficient. */
-#define DB_CO(g) ((g) > -90.0f ? powf(10.0f, (g) * 0.05f) : 0.0f)
+	gain_reset(&amp->gain_state);
+}
 
 /**
    The `run()` method is the main process function of the plugin.  It processes
    a block of audio in the audio context.  Since this plugin is
    `lv2:hardRTCapable`, `run()` must be real-time safe, so blocking (e.g. with
    a mutex) or memory allocation are not allowed.
+
+   The work is done by `gain_run()`, which only converts the gain to a
+   coefficient when it has changed, and ramps to the new coefficient across
+   the block when it does.
 */
 static void
 run(LV2_Handle instance, uint32_t n_samples)
 {
-	const Amp* amp = (const Amp*)instance;
+	Amp* amp = (Amp*)instance;
+
+	gain_run(&amp->gain_state,
+	         *(amp->gain),
+	         amp->input,
+	         amp->output,
+	         n_samples);
+}
 
-	const float        gain   = *(amp->gain);
-	const float* const input  = amp->input;
-	float* const       output = amp->output;
+/**
+   The `run_batch()` function implements the batch interface, which a host can
+   use to run many instances of this plugin in a single call, for example one
+   on every channel of a mixer.  This avoids the overhead of calling `run()`
+   through a function pointer for every instance, and lets the compiler inline
+   the gain kernel into a single loop over all instances.  The result is
+   exactly the same as calling `run()` for every instance.
 
-	const float coef = DB_CO(gain);
+   Like `run()`, this is in the ``audio'' threading class, for every instance
+   in the batch.
+*/
+static void
+run_batch(const LV2_Handle* instances,
+          uint32_t          n_instances,
+          uint32_t          n_samples)
+{
+	for (uint32_t i = 0; i < n_instances; ++i) {
+		Amp* amp = (Amp*)instances[i];
 
-	for (uint32_t pos = 0; pos < n_samples; pos++) {
-		output[pos] = input[pos] * coef;
+		gain_run(&amp->gain_state,
+		         *(amp->gain),
+		         amp->input,
+		         amp->output,
+		         n_samples);
 	}
 }
 
@@ -181,8 +218,9 @@ cleanup(LV2_Handle instance)
    The `extension_data()` function returns any extension data supported by the
    plugin.  Note that this is not an instance method, but a function on the
    plugin descriptor.  It is usually used by plugins to implement additional
-   interfaces.  This plugin does not have any extension data, so this function
-   returns NULL.
+   interfaces.  This plugin provides the batch interface, which is returned
+   when the host asks for it by URI.  Any other extension data is not
+   supported, so NULL is returned.
 
    This method is in the ``discovery'' threading class, so no other functions
    or methods in this plugin library will be called concurrently with it.
@@ -190,6 +228,10 @@ cleanup(LV2_Handle instance)
 static const void*
 extension_data(const char* uri)
 {
+	static const LV2_Batch_Interface batch = { run_batch };
+	if (!strcmp(uri, LV2_BATCH__interface)) {
+		return &batch;
+	}
 	return NULL;
 }
 
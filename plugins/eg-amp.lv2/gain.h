@@ -0,0 +1,192 @@
+/*
+  LV2 gain utilities
+  Copyright 2026 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   This file defines utilities for applying a gain in dB to audio, which can
+   be used by any plugin with a gain control.
+
+   GainState keeps the last gain and its coefficient, so the (relatively
+   expensive) conversion from dB is only done when the gain changes.  When it
+   does change, the coefficient is ramped linearly across the block, which
+   avoids the ``zipper'' noise caused by jumping to the new gain.
+
+   Where SSE is available, samples are processed four at a time.  Buffers may
+   have any alignment, and may be the same for in-place processing.
+*/
+
+#ifndef GAIN_H_INCLUDED
+#define GAIN_H_INCLUDED
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__SSE__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#    define GAIN_USE_SSE 1
+#    include <xmmintrin.h>
+#endif
+
+/** Gain in dB at or below which the output is silent. */
+#define GAIN_MIN_DB -90.0f
+
+typedef struct {
+	float db;     ///< Current gain in dB
+	float coef;   ///< Coefficient for `db`
+	bool  valid;  ///< False until the first block after a reset
+} GainState;
+
+/** Convert a gain in dB to a coefficient (NaN is treated as silence). */
+static inline float
+gain_db_to_coef(float db)
+{
+	return db > GAIN_MIN_DB ? powf(10.0f, db * 0.05f) : 0.0f;
+}
+
+/** Reset the gain state, so the next block starts at its gain with no ramp. */
+static inline void
+gain_reset(GainState* state)
+{
+	state->db    = 0.0f;
+	state->coef  = 1.0f;
+	state->valid = false;
+}
+
+/** Return true if `db` is the current gain, so the coefficient can be used. */
+static inline bool
+gain_is_current(const GainState* state, float db)
+{
+	return state->valid && db == state->db;
+}
+
+/** Return true if the address `ptr` is aligned for vector loads and stores. */
+static inline bool
+gain_is_aligned(const float* ptr)
+{
+	return !((uintptr_t)ptr & 15u);
+}
+
+/**
+   Multiply `n_samples` samples from `input` by `coef` and write to `output`.
+
+   With SSE, samples are processed one at a time until the output is aligned,
+   then four at a time.  The input is loaded with aligned loads if it is also
+   aligned at that point, which is always the case for in-place processing.
+*/
+static inline void
+gain_apply(const float* input, float* output, float coef, uint32_t n_samples)
+{
+	uint32_t i = 0;
+
+#ifdef GAIN_USE_SSE
+	for (; i < n_samples && !gain_is_aligned(output + i); ++i) {
+		output[i] = input[i] * coef;
+	}
+
+	const __m128 vcoef = _mm_set1_ps(coef);
+	if (gain_is_aligned(input + i)) {
+		for (; i + 4 <= n_samples; i += 4) {
+			const __m128 in = _mm_load_ps(input + i);
+			_mm_store_ps(output + i, _mm_mul_ps(in, vcoef));
+		}
+	} else {
+		for (; i + 4 <= n_samples; i += 4) {
+			const __m128 in = _mm_loadu_ps(input + i);
+			_mm_store_ps(output + i, _mm_mul_ps(in, vcoef));
+		}
+	}
+#endif
+
+	for (; i < n_samples; ++i) {
+		output[i] = input[i] * coef;
+	}
+}
+
+/**
+   Ramp linearly from coefficient `from` to `to` over `n_samples` samples.
+
+   The coefficient for sample `i` is `from + (i + 1) * step`, so the last
+   sample is multiplied by (almost exactly) `to`.  The vector and scalar
+   paths calculate this in the same way, so the result does not depend on
+   the alignment of the buffers.  Ramps are relatively rare, so the input is
+   always loaded with unaligned loads here.
+*/
+static inline void
+gain_apply_ramp(const float* input,
+                float*       output,
+                float        from,
+                float        to,
+                uint32_t     n_samples)
+{
+	const float step = (to - from) / (float)n_samples;
+	uint32_t    i    = 0;
+
+#ifdef GAIN_USE_SSE
+	for (; i < n_samples && !gain_is_aligned(output + i); ++i) {
+		output[i] = input[i] * (from + step * (float)(i + 1));
+	}
+
+	const __m128 vfrom = _mm_set1_ps(from);
+	const __m128 vstep = _mm_set1_ps(step);
+	const __m128 vfour = _mm_set1_ps(4.0f);
+	__m128       index = _mm_setr_ps((float)(i + 1),
+	                                 (float)(i + 2),
+	                                 (float)(i + 3),
+	                                 (float)(i + 4));
+	for (; i + 4 <= n_samples; i += 4) {
+		const __m128 coef = _mm_add_ps(vfrom, _mm_mul_ps(vstep, index));
+		const __m128 in   = _mm_loadu_ps(input + i);
+		_mm_store_ps(output + i, _mm_mul_ps(in, coef));
+		index = _mm_add_ps(index, vfour);
+	}
+#endif
+
+	for (; i < n_samples; ++i) {
+		output[i] = input[i] * (from + step * (float)(i + 1));
+	}
+}
+
+/**
+   Process a block at gain `db`, ramping from the previous gain if it changed.
+
+   The gain only changes if there is at least one sample to ramp over, so a
+   change during an empty block is applied to the next one.
+*/
+static inline void
+gain_run(GainState*   state,
+         float        db,
+         const float* input,
+         float*       output,
+         uint32_t     n_samples)
+{
+	if (gain_is_current(state, db)) {
+		gain_apply(input, output, state->coef, n_samples);
+	} else if (n_samples > 0) {
+		const float coef = gain_db_to_coef(db);
+		if (state->valid && coef != state->coef) {
+			gain_apply_ramp(input, output, state->coef, coef, n_samples);
+		} else {
+			gain_apply(input, output, coef, n_samples);
+		}
+
+		state->db    = db;
+		state->coef  = coef;
+		state->valid = true;
+	}
+}
+
+#endif  /* GAIN_H_INCLUDED */
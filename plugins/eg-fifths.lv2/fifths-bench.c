@@ -0,0 +1,353 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   Benchmark of the MIDI transform, which checks that the cost of a transform
+   does not depend on how many stages it has.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "fifths.c"
+
+#include "lv2/atom/atom-bench-utils.c"
+#include "lv2/atom/forge.h"
+#include "lv2/core/lv2.h"
+#include "lv2/urid/urid.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_EVENTS 256u
+#define CAPACITY 16384u
+#define MAX_URIS 32u
+
+typedef struct {
+	char*    uris[MAX_URIS];
+	uint32_t n_uris;
+} URITable;
+
+typedef struct {
+	MidiTransform transform;
+	LV2_URID      midi_Event;
+	uint8_t*      in;
+	uint8_t*      out;
+} Context;
+
+static LV2_URID
+urid_map(LV2_URID_Map_Handle handle, const char* uri)
+{
+	URITable* const table = (URITable*)handle;
+	for (uint32_t i = 0; i < table->n_uris; ++i) {
+		if (!strcmp(table->uris[i], uri)) {
+			return i + 1;
+		}
+	}
+
+	if (table->n_uris == MAX_URIS) {
+		return 0;
+	}
+
+	const size_t len = strlen(uri);
+	table->uris[table->n_uris] = (char*)malloc(len + 1);
+	memcpy(table->uris[table->n_uris], uri, len + 1);
+	return ++table->n_uris;
+}
+
+/** Write a test sequence of notes, key pressure, and other MIDI events. */
+static void
+write_input(uint8_t* buf, LV2_URID_Map* map, LV2_URID midi_Event)
+{
+	LV2_Atom_Forge       forge;
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_init(&forge, map);
+	lv2_atom_forge_set_buffer(&forge, buf, CAPACITY);
+	lv2_atom_forge_sequence_head(&forge, &frame, 0);
+
+	static const uint8_t types[] = { 0x90, 0x80, 0x90, 0xA0, 0xB0, 0xE0 };
+
+	uint32_t seed = 1;
+	for (uint32_t i = 0; i < N_EVENTS; ++i) {
+		seed = seed * 1103515245u + 12345u;
+
+		const uint8_t type = types[i % sizeof(types)];
+		uint8_t       msg[3];
+		msg[0] = (uint8_t)(type | ((seed >> 8) & 0x0F));
+		msg[1] = (uint8_t)((seed >> 12) & 0x7F);
+		msg[2] = (uint8_t)((seed >> 20) & 0x7F);
+
+		lv2_atom_forge_frame_time(&forge, i);
+		lv2_atom_forge_atom(&forge, sizeof(msg), midi_Event);
+		lv2_atom_forge_write(&forge, msg, sizeof(msg));
+	}
+
+	// A system event, which is forwarded unchanged
+	static const uint8_t clock = LV2_MIDI_MSG_CLOCK;
+	lv2_atom_forge_frame_time(&forge, N_EVENTS);
+	lv2_atom_forge_atom(&forge, 1, midi_Event);
+	lv2_atom_forge_write(&forge, &clock, 1);
+
+	lv2_atom_forge_pop(&forge, &frame);
+}
+
+/** Clear `buf` to an empty output sequence with capacity `CAPACITY`. */
+static LV2_Atom_Sequence*
+clear_output(uint8_t* buf)
+{
+	LV2_Atom_Sequence* const seq = (LV2_Atom_Sequence*)buf;
+	seq->atom.size = CAPACITY - (uint32_t)sizeof(LV2_Atom);
+	seq->atom.type = 0;
+	return seq;
+}
+
+/** Write an empty sequence to `buf` and set up `writer` to append to it. */
+static LV2_Atom_Sequence*
+begin_output(uint8_t* buf, LV2_Atom_Sequence_Writer* writer)
+{
+	LV2_Atom_Sequence* const seq = clear_output(buf);
+	lv2_atom_sequence_clear(seq);
+	lv2_atom_sequence_writer_init(writer, seq, CAPACITY - sizeof(LV2_Atom));
+	return seq;
+}
+
+/**
+   Return true if `out` is what fifths should write for `in`.
+
+   Every MIDI event is forwarded, and a note 7 semitones higher is added after
+   every note on, note off, and key pressure event, unless it would be higher
+   than 127.
+*/
+static bool
+check_fifths(const LV2_Atom_Sequence* in,
+             const LV2_Atom_Sequence* out,
+             LV2_URID                 midi_Event)
+{
+	const LV2_Atom_Event* o   = lv2_atom_sequence_begin(&out->body);
+	const LV2_Atom_Event* end = lv2_atom_sequence_end(&out->body,
+	                                                  out->atom.size);
+	LV2_ATOM_SEQUENCE_FOREACH(in, ev) {
+		const uint8_t* const msg  = (const uint8_t*)(ev + 1);
+		const uint8_t        type = lv2_midi_message_type(msg);
+		if (o >= end ||
+		    memcmp(o, ev, sizeof(LV2_Atom_Event) + ev->body.size)) {
+			return false;
+		}
+
+		o = lv2_atom_sequence_next(o);
+		if ((type == LV2_MIDI_MSG_NOTE_ON ||
+		     type == LV2_MIDI_MSG_NOTE_OFF ||
+		     type == LV2_MIDI_MSG_NOTE_PRESSURE) &&
+		    msg[1] <= 127 - 7) {
+			const uint8_t* const fifth = (const uint8_t*)(o + 1);
+			if (o >= end || o->time.frames != ev->time.frames ||
+			    o->body.size != 3 || fifth[0] != msg[0] ||
+			    fifth[1] != msg[1] + 7 || fifth[2] != msg[2]) {
+				return false;
+			}
+
+			o = lv2_atom_sequence_next(o);
+		}
+	}
+
+	return o == end;
+}
+
+/** Check that stages are composed and applied as documented. */
+static bool
+check_stages(Context* ctx)
+{
+	MidiStage stage;
+
+	// Transposing up then down drops the notes that went out of range
+	MidiLayer layer;
+	midi_layer_reset(&layer);
+	midi_stage_transpose(&stage, 12);
+	midi_layer_add_stage(&layer, &stage);
+	midi_stage_transpose(&stage, -12);
+	midi_layer_add_stage(&layer, &stage);
+	for (uint32_t i = 0; i < 128; ++i) {
+		const uint8_t expected = i < 116 ? (uint8_t)i : MIDI_TRANSFORM_DROP;
+		if (layer.note[i] != expected) {
+			fprintf(stderr, "error: Note %u maps to %u\n", i, layer.note[i]);
+			return false;
+		}
+	}
+
+	// Velocity 0 is never changed, and other velocities never become 0
+	midi_stage_velocity_range(&stage, 0, 0);
+	midi_layer_add_stage(&layer, &stage);
+	if (layer.velocity[0] != 0 || layer.velocity[1] != 1 ||
+	    layer.velocity[127] != 1) {
+		fprintf(stderr, "error: Velocity 0 changed\n");
+		return false;
+	}
+
+	midi_layer_reset(&layer);
+	midi_stage_velocity_range(&stage, 64, 127);
+	midi_layer_add_stage(&layer, &stage);
+	if (layer.velocity[1] != 64 || layer.velocity[127] != 127 ||
+	    layer.velocity[64] != 96) {
+		fprintf(stderr, "error: Velocity range is incorrect\n");
+		return false;
+	}
+
+	// Transform a single note through a channel filter and map
+	MidiTransform* const transform = &ctx->transform;
+	midi_transform_reset(transform);
+	MidiLayer* const l = midi_transform_add_layer(transform);
+	midi_stage_channel_filter(&stage, 2);
+	midi_layer_add_stage(l, &stage);
+	midi_stage_channel_map(&stage, 2, 9);
+	midi_layer_add_stage(l, &stage);
+	midi_layer_add_stage(l, &stage);  // No effect, since 2 is now 9
+	midi_stage_velocity_range(&stage, 100, 100);
+	midi_layer_add_stage(l, &stage);
+
+	static const uint8_t notes[][2][3] = {
+		{ { 0x92, 60, 10 }, { 0x99, 60, 100 } },
+		{ { 0x82, 60, 10 }, { 0x89, 60, 10 } },
+		{ { 0xB2, 7, 10 }, { 0xB9, 7, 10 } },
+		{ { 0x91, 60, 10 }, { 0, 0, 0 } },
+		{ { 0xB1, 7, 10 }, { 0, 0, 0 } },
+	};
+
+	for (uint32_t i = 0; i < sizeof(notes) / sizeof(notes[0]); ++i) {
+		uint8_t buf[sizeof(LV2_Atom_Event) + 8];
+		LV2_Atom_Event* const ev = (LV2_Atom_Event*)buf;
+		ev->time.frames = 0;
+		ev->body.size   = 3;
+		ev->body.type   = ctx->midi_Event;
+		memcpy(ev + 1, notes[i][0], 3);
+
+		LV2_Atom_Sequence_Writer       out;
+		const LV2_Atom_Sequence* const seq = begin_output(ctx->out, &out);
+		midi_transform_event(transform, &out, ev);
+
+		const LV2_Atom_Event* const o = lv2_atom_sequence_begin(&seq->body);
+		if (notes[i][1][0]
+		    ? (seq->atom.size == sizeof(LV2_Atom_Sequence_Body) ||
+		       memcmp(o + 1, notes[i][1], 3))
+		    : seq->atom.size != sizeof(LV2_Atom_Sequence_Body)) {
+			fprintf(stderr, "error: Event %u transformed incorrectly\n", i);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void
+run_transform(void* data)
+{
+	Context* const           ctx = (Context*)data;
+	LV2_Atom_Sequence_Writer out;
+	begin_output(ctx->out, &out);
+	midi_transform_run(
+		&ctx->transform, (const LV2_Atom_Sequence*)ctx->in, &out,
+		ctx->midi_Event);
+}
+
+/** Configure a transform with `n_layers` layers of `n_stages` stages. */
+static void
+configure(MidiTransform* transform, uint32_t n_layers, uint32_t n_stages)
+{
+	MidiStage stage;
+	midi_transform_reset(transform);
+	for (uint32_t l = 0; l < n_layers; ++l) {
+		MidiLayer* const layer = midi_transform_add_layer(transform);
+		for (uint32_t s = 0; s < n_stages; ++s) {
+			switch (s % 4) {
+			case 0:
+				midi_stage_transpose(&stage, (s & 4) ? -1 : 1);
+				break;
+			case 1:
+				midi_stage_velocity_range(&stage, 16, 120);
+				break;
+			case 2:
+				midi_stage_channel_map(&stage, (uint8_t)s, 0);
+				break;
+			default:
+				midi_stage_note_range(&stage, 12, 115);
+				break;
+			}
+			midi_layer_add_stage(layer, &stage);
+		}
+	}
+}
+
+int
+main(void)
+{
+	static uint8_t in[CAPACITY];
+	static uint8_t out[CAPACITY];
+
+	URITable     table = { { NULL }, 0 };
+	LV2_URID_Map map   = { &table, urid_map };
+
+	const LV2_Feature        map_feature = { LV2_URID__map, &map };
+	const LV2_Feature* const features[]  = { &map_feature, NULL };
+
+	Context ctx;
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.midi_Event = urid_map(&table, LV2_MIDI__MidiEvent);
+	ctx.in         = in;
+	ctx.out        = out;
+	write_input(in, &map, ctx.midi_Event);
+
+	// Run the plugin and check its output
+	const LV2_Descriptor* const desc = lv2_descriptor(0);
+	LV2_Handle inst = desc->instantiate(desc, 48000.0, "", features);
+	desc->connect_port(inst, FIFTHS_IN, in);
+	desc->connect_port(inst, FIFTHS_OUT, clear_output(out));
+	desc->run(inst, N_EVENTS + 1);
+
+	bool ok = check_fifths((const LV2_Atom_Sequence*)in,
+	                       (const LV2_Atom_Sequence*)out,
+	                       ctx.midi_Event);
+	if (!ok) {
+		fprintf(stderr, "error: Fifths output differs\n");
+	}
+
+	ok = ok && check_stages(&ctx);
+
+	bench_begin();
+
+	// The cost per event depends on the number of layers, not stages
+	static const uint32_t layers[] = { 1, 2, 4 };
+	static const uint32_t stages[] = { 1, 4, 16 };
+	for (uint32_t l = 0; ok && l < sizeof(layers) / sizeof(uint32_t); ++l) {
+		for (uint32_t s = 0; s < sizeof(stages) / sizeof(uint32_t); ++s) {
+			char name[48];
+			snprintf(name, sizeof(name), "transform_%ux%u",
+			         layers[l], stages[s]);
+
+			configure(&ctx.transform, layers[l], stages[s]);
+			bench_run(name, run_transform, &ctx, N_EVENTS);
+		}
+	}
+
+	bench_end();
+
+	desc->cleanup(inst);
+	for (uint32_t i = 0; i < table.n_uris; ++i) {
+		free(table.uris[i]);
+	}
+
+	return ok ? 0 : 1;
+}
@@ -15,6 +15,7 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "./transform.h"
 #include "./uris.h"
 
 #include "lv2/atom/atom.h"
@@ -47,6 +48,9 @@ typedef struct {
 
 	// URIs
 	FifthsURIs uris;
+
+	// Transform from input to output events
+	MidiTransform transform;
 } Fifths;
 
 static void
@@ -94,6 +98,17 @@ instantiate(const LV2_Descriptor*     descriptor,
 
 	map_fifths_uris(self->map, &self->uris);
 
+	/* Configure the transform.  Here, the first layer forwards the input
+	   notes, and the second adds a note one 5th (7 semitones) higher, which is
+	   dropped if it would be higher than the highest MIDI note.  Any number of
+	   stages can be added to a layer, since they are composed into a single
+	   table, but the transform is not changed in run(). */
+	MidiStage fifth;
+	midi_stage_transpose(&fifth, 7);
+	midi_transform_reset(&self->transform);
+	midi_transform_add_layer(&self->transform);
+	midi_layer_add_stage(midi_transform_add_layer(&self->transform), &fifth);
+
 	return (LV2_Handle)self;
 }
 
@@ -110,12 +125,6 @@ run(LV2_Handle instance,
 	Fifths*     self = (Fifths*)instance;
 	FifthsURIs* uris = &self->uris;
 
-	// Struct for a 3 byte MIDI event, used for writing notes
-	typedef struct {
-		LV2_Atom_Event event;
-		uint8_t        msg[3];
-	} MIDINoteEvent;
-
 	// Initially self->out_port contains a Chunk with size set to capacity
 
 	// Get the capacity
@@ -125,43 +134,12 @@ run(LV2_Handle instance,
 	lv2_atom_sequence_clear(self->out_port);
 	self->out_port->atom.type = self->in_port->atom.type;
 
-	// Read incoming events
-	LV2_ATOM_SEQUENCE_FOREACH(self->in_port, ev) {
-		if (ev->body.type == uris->midi_Event) {
-			const uint8_t* const msg = (const uint8_t*)(ev + 1);
-			switch (lv2_midi_message_type(msg)) {
-			case LV2_MIDI_MSG_NOTE_ON:
-			case LV2_MIDI_MSG_NOTE_OFF:
-				// Forward note to output
-				lv2_atom_sequence_append_event(
-					self->out_port, out_capacity, ev);
-
-				if (msg[1] <= 127 - 7) {
-					// Make a note one 5th (7 semitones) higher than input
-					MIDINoteEvent fifth;
-
-					// Could simply do fifth.event = *ev here instead...
-					fifth.event.time.frames = ev->time.frames;  // Same time
-					fifth.event.body.type   = ev->body.type;    // Same type
-					fifth.event.body.size   = ev->body.size;    // Same size
-
-					fifth.msg[0] = msg[0];      // Same status
-					fifth.msg[1] = msg[1] + 7;  // Pitch up 7 semitones
-					fifth.msg[2] = msg[2];      // Same velocity
-
-					// Write 5th event
-					lv2_atom_sequence_append_event(
-						self->out_port, out_capacity, &fifth.event);
-				}
-				break;
-			default:
-				// Forward all other MIDI events directly
-				lv2_atom_sequence_append_event(
-					self->out_port, out_capacity, ev);
-				break;
-			}
-		}
-	}
+	// Set up a writer to append events to the output
+	LV2_Atom_Sequence_Writer out;
+	lv2_atom_sequence_writer_init(&out, self->out_port, out_capacity);
+
+	// Transform incoming events in a single pass
+	midi_transform_run(&self->transform, self->in_port, &out, uris->midi_Event);
 }
 
 static const void*
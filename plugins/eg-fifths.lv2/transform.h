@@ -0,0 +1,327 @@
+/*
+  LV2 MIDI transform utilities
+  Copyright 2026 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   This file defines a table-driven MIDI transform, which can be used by any
+   plugin that maps notes, velocities, or channels.
+
+   A transform is configured as a chain of stages, each of which is a lookup
+   table that maps a note number, velocity, or channel to a new value, or
+   drops the event.  Stages are composed as they are added, so however long
+   the chain is, processing an event only takes one lookup per value.  A
+   transform has one or more layers which are applied to every note in
+   parallel, so one input note can produce several output notes.
+
+   Configuring a transform is relatively expensive and should be done outside
+   of run(), but midi_transform_run() is real-time safe.
+*/
+
+#ifndef TRANSFORM_H_INCLUDED
+#define TRANSFORM_H_INCLUDED
+
+#include "lv2/atom/atom.h"
+#include "lv2/atom/util.h"
+#include "lv2/midi/midi.h"
+#include "lv2/urid/urid.h"
+
+#include <stdint.h>
+
+/** Table value for an event that is dropped. */
+#define MIDI_TRANSFORM_DROP 0xFF
+
+/** Maximum number of layers in a transform. */
+#define MIDI_TRANSFORM_MAX_LAYERS 8u
+
+/** The value a stage maps. */
+typedef enum {
+	MIDI_STAGE_NOTE,      ///< Note number of note and key pressure events
+	MIDI_STAGE_VELOCITY,  ///< Velocity of note on events
+	MIDI_STAGE_CHANNEL    ///< Channel of all channel events
+} MidiStageType;
+
+/**
+   A stage in a transform chain.
+
+   Each entry is the output for that input value, or MIDI_TRANSFORM_DROP.
+   Channel stages only use the first 16 entries.
+*/
+typedef struct {
+	MidiStageType type;
+	uint8_t       map[128];
+} MidiStage;
+
+/** A chain of stages, composed into a single table for each value. */
+typedef struct {
+	uint8_t note[128];
+	uint8_t velocity[128];
+	uint8_t channel[16];
+} MidiLayer;
+
+/** A MIDI transform, which applies several layers to every note. */
+typedef struct {
+	MidiLayer layers[MIDI_TRANSFORM_MAX_LAYERS];
+	uint32_t  n_layers;
+} MidiTransform;
+
+/** Return the number of entries used in a table for `type`. */
+static inline uint32_t
+midi_stage_size(MidiStageType type)
+{
+	return type == MIDI_STAGE_CHANNEL ? 16u : 128u;
+}
+
+/** Set `stage` to a stage of `type` that passes every value unchanged. */
+static inline void
+midi_stage_identity(MidiStage* stage, MidiStageType type)
+{
+	stage->type = type;
+	for (uint32_t i = 0; i < 128; ++i) {
+		stage->map[i] = (uint8_t)i;
+	}
+}
+
+/** Set `stage` to transpose notes, dropping those that go out of range. */
+static inline void
+midi_stage_transpose(MidiStage* stage, int semitones)
+{
+	stage->type = MIDI_STAGE_NOTE;
+	for (int i = 0; i < 128; ++i) {
+		const int note = i + semitones;
+		stage->map[i] = (note >= 0 && note < 128)
+			? (uint8_t)note
+			: MIDI_TRANSFORM_DROP;
+	}
+}
+
+/** Set `stage` to drop notes outside the range [`min`, `max`]. */
+static inline void
+midi_stage_note_range(MidiStage* stage, uint8_t min, uint8_t max)
+{
+	stage->type = MIDI_STAGE_NOTE;
+	for (uint32_t i = 0; i < 128; ++i) {
+		stage->map[i] = (i >= min && i <= max)
+			? (uint8_t)i
+			: MIDI_TRANSFORM_DROP;
+	}
+}
+
+/**
+   Set `stage` to scale velocities linearly to the range [`min`, `max`].
+
+   Velocity 1 is mapped to `min` and velocity 127 to `max`, so for example a
+   range of 64 to 127 compresses the dynamics, and a range of 100 to 100
+   gives every note the same velocity.
+*/
+static inline void
+midi_stage_velocity_range(MidiStage* stage, uint8_t min, uint8_t max)
+{
+	stage->type   = MIDI_STAGE_VELOCITY;
+	stage->map[0] = 0;
+	for (int i = 1; i < 128; ++i) {
+		stage->map[i] = (uint8_t)(min + ((max - min) * (i - 1) + 63) / 126);
+	}
+}
+
+/** Set `stage` to move events on channel `from` to channel `to`. */
+static inline void
+midi_stage_channel_map(MidiStage* stage, uint8_t from, uint8_t to)
+{
+	midi_stage_identity(stage, MIDI_STAGE_CHANNEL);
+	if (from < 16) {
+		stage->map[from] = to;
+	}
+}
+
+/** Set `stage` to drop events on every channel except `channel`. */
+static inline void
+midi_stage_channel_filter(MidiStage* stage, uint8_t channel)
+{
+	stage->type = MIDI_STAGE_CHANNEL;
+	for (uint32_t i = 0; i < 128; ++i) {
+		stage->map[i] = i == channel ? (uint8_t)i : MIDI_TRANSFORM_DROP;
+	}
+}
+
+/** Reset `layer` to pass everything unchanged. */
+static inline void
+midi_layer_reset(MidiLayer* layer)
+{
+	for (uint32_t i = 0; i < 128; ++i) {
+		layer->note[i]     = (uint8_t)i;
+		layer->velocity[i] = (uint8_t)i;
+	}
+	for (uint32_t i = 0; i < 16; ++i) {
+		layer->channel[i] = (uint8_t)i;
+	}
+}
+
+/**
+   Append `stage` to the end of the chain in `layer`.
+
+   The stage is composed with the layer's existing table, so each entry is
+   looked up in the stage and replaced with the result.  Results that are out
+   of range for the value are treated as MIDI_TRANSFORM_DROP.
+
+   Velocity 0 is a note off, so it is never changed, and other velocities are
+   never mapped to 0 (they are raised to 1 instead).  A velocity that is
+   dropped only drops note ons, so the note off of a dropped note is still
+   sent, which is harmless, rather than risking a stuck note.
+*/
+static inline void
+midi_layer_add_stage(MidiLayer* layer, const MidiStage* stage)
+{
+	uint8_t*       table = NULL;
+	const uint32_t size  = midi_stage_size(stage->type);
+	switch (stage->type) {
+	case MIDI_STAGE_NOTE:
+		table = layer->note;
+		break;
+	case MIDI_STAGE_VELOCITY:
+		table = layer->velocity;
+		break;
+	case MIDI_STAGE_CHANNEL:
+		table = layer->channel;
+		break;
+	}
+
+	for (uint32_t i = 0; i < size; ++i) {
+		if (table[i] != MIDI_TRANSFORM_DROP) {
+			const uint8_t value = stage->map[table[i]];
+			table[i] = value < size ? value : MIDI_TRANSFORM_DROP;
+		}
+	}
+
+	if (stage->type == MIDI_STAGE_VELOCITY) {
+		layer->velocity[0] = 0;
+		for (uint32_t i = 1; i < 128; ++i) {
+			if (layer->velocity[i] == 0) {
+				layer->velocity[i] = 1;
+			}
+		}
+	}
+}
+
+/** Reset `transform` to have no layers, so every note is dropped. */
+static inline void
+midi_transform_reset(MidiTransform* transform)
+{
+	transform->n_layers = 0;
+}
+
+/**
+   Add a new layer that passes everything unchanged to `transform`.
+
+   @return The new layer to add stages to, or NULL if there are already
+   MIDI_TRANSFORM_MAX_LAYERS layers.
+*/
+static inline MidiLayer*
+midi_transform_add_layer(MidiTransform* transform)
+{
+	if (transform->n_layers == MIDI_TRANSFORM_MAX_LAYERS) {
+		return NULL;
+	}
+
+	MidiLayer* const layer = &transform->layers[transform->n_layers++];
+	midi_layer_reset(layer);
+	return layer;
+}
+
+/**
+   Write the events produced by `ev` to `out`.
+
+   Note on, note off, and key pressure events are written once for every
+   layer that does not drop them, in layer order.  Other channel events are
+   written once, on the channel given by the first layer.  System events,
+   and any MIDI events that are too short to transform, are copied unchanged.
+*/
+static inline void
+midi_transform_event(const MidiTransform*      transform,
+                     LV2_Atom_Sequence_Writer* out,
+                     const LV2_Atom_Event*     ev)
+{
+	const uint8_t* const msg  = (const uint8_t*)(ev + 1);
+	const uint8_t        type = ev->body.size ? (msg[0] & 0xF0) : 0;
+	if (type < 0x80 || type == 0xF0) {
+		lv2_atom_sequence_writer_append(out, ev);
+		return;
+	}
+
+	const uint8_t chan = msg[0] & 0x0F;
+	if (type == LV2_MIDI_MSG_NOTE_ON ||
+	    type == LV2_MIDI_MSG_NOTE_OFF ||
+	    type == LV2_MIDI_MSG_NOTE_PRESSURE) {
+		if (ev->body.size < 3) {
+			lv2_atom_sequence_writer_append(out, ev);
+			return;
+		}
+
+		const uint8_t note = msg[1] & 0x7F;
+		const uint8_t vel  = msg[2] & 0x7F;
+		for (uint32_t i = 0; i < transform->n_layers; ++i) {
+			const MidiLayer* const layer = &transform->layers[i];
+			const uint8_t          c     = layer->channel[chan];
+			const uint8_t          n     = layer->note[note];
+			const uint8_t          v     = (type == LV2_MIDI_MSG_NOTE_ON
+			                                ? layer->velocity[vel]
+			                                : msg[2]);
+			if ((c | n | v) & 0x80) {
+				continue;  // Dropped (all valid values are less than 128)
+			}
+
+			// Write the event body directly to the output
+			uint8_t* const body = (uint8_t*)lv2_atom_sequence_writer_reserve(
+				out, ev->time.frames, ev->body.type, 3);
+			if (!body) {
+				return;
+			}
+
+			body[0] = (uint8_t)(type | c);
+			body[1] = n;
+			body[2] = v;
+		}
+	} else if (transform->n_layers > 0) {
+		const uint8_t c = transform->layers[0].channel[chan];
+		if (c != MIDI_TRANSFORM_DROP) {
+			LV2_Atom_Event* const copy = lv2_atom_sequence_writer_append(
+				out, ev);
+			if (copy) {
+				*(uint8_t*)(copy + 1) = (uint8_t)(type | c);
+			}
+		}
+	}
+}
+
+/**
+   Transform all MIDI events in `in` and write the results to `out`.
+
+   This is a single pass over the input, and events of other types are
+   ignored.
+*/
+static inline void
+midi_transform_run(const MidiTransform*      transform,
+                   const LV2_Atom_Sequence*  in,
+                   LV2_Atom_Sequence_Writer* out,
+                   LV2_URID                  midi_Event)
+{
+	LV2_ATOM_SEQUENCE_FOREACH(in, ev) {
+		if (ev->body.type == midi_Event) {
+			midi_transform_event(transform, out, ev);
+		}
+	}
+}
+
+#endif  /* TRANSFORM_H_INCLUDED */
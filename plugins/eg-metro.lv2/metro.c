@@ -16,12 +16,11 @@
 */
 
 #include "lv2/atom/atom.h"
-#include "lv2/atom/util.h"
 #include "lv2/core/lv2.h"
 #include "lv2/core/lv2_util.h"
 #include "lv2/log/log.h"
 #include "lv2/log/logger.h"
-#include "lv2/time/time.h"
+#include "lv2/time/transport.h"
 #include "lv2/urid/urid.h"
 
 #include <math.h>
@@ -35,20 +34,13 @@
 #    define M_PI 3.14159265
 #endif
 
-#define EG_METRO_URI "http://lv2plug.in/plugins/eg-metro"
+#if defined(__SSE__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#    define METRO_USE_SSE 1
+#    include <xmmintrin.h>
+#endif
 
-typedef struct {
-	LV2_URID atom_Blank;
-	LV2_URID atom_Float;
-	LV2_URID atom_Object;
-	LV2_URID atom_Path;
-	LV2_URID atom_Resource;
-	LV2_URID atom_Sequence;
-	LV2_URID time_Position;
-	LV2_URID time_barBeat;
-	LV2_URID time_beatsPerMinute;
-	LV2_URID time_speed;
-} MetroURIs;
+#define EG_METRO_URI "http://lv2plug.in/plugins/eg-metro"
 
 static const double attack_s = 0.005;
 static const double decay_s  = 0.075;
@@ -58,13 +50,6 @@ enum {
 	METRO_OUT     = 1
 };
 
-/** During execution this plugin can be in one of 3 states: */
-typedef enum {
-	STATE_ATTACK,  // Envelope rising
-	STATE_DECAY,   // Envelope lowering
-	STATE_OFF      // Silent
-} State;
-
 /**
    This plugin must keep track of more state than previous examples to be able
    to render audio.  The basic idea is to generate a single cycle of a sine
@@ -72,34 +57,42 @@ typedef enum {
    enveloping the amplitude so there is a short attack/decay peak around a
    tick, and silence the rest of the time.
 
-   This example uses a simple AD envelope with fixed parameters.  A more
+   The position is tracked by an LV2_Time_Transport, which reads the position
+   updates sent by the host, and a click starts at every frame where the
+   position reaches a whole beat.  The tempo may change linearly between
+   position updates within a cycle, so the metronome can follow tempo
+   automation exactly.
+
+   This example uses a simple AD envelope with fixed parameters, which is
+   calculated once in advance and stored in a table, so rendering a click is
+   only a matter of multiplying the wave by the envelope.  A more
    sophisticated implementation might use a more advanced envelope and allow
    the user to modify these parameters, the frequency of the wave, and so on.
 */
 typedef struct {
 	LV2_URID_Map*  map;     // URID map feature
 	LV2_Log_Logger logger;  // Logger API
-	MetroURIs      uris;    // Cache of mapped URIDs
 
 	struct {
 		LV2_Atom_Sequence* control;
 		float*             output;
 	} ports;
 
-	// Variables to keep track of the tempo information sent by the host
-	double rate;   // Sample rate
-	float  bpm;    // Beats per minute (tempo)
-	float  speed;  // Transport speed (usually 0=stop, 1=play)
+	// Tracker for the tempo and position information sent by the host
+	LV2_Time_Transport transport;
 
+	double   click_beat;   // Beat of the last click
 	uint32_t elapsed_len;  // Frames since the start of the last click
 	uint32_t wave_offset;  // Current play offset in the wave
-	State    state;        // Current play state
+	bool     clicking;     // True if the envelope is playing
 
-	// One cycle of a sine wave
+	// One cycle of a sine wave, repeated to be at least env_len longer
 	float*   wave;
 	uint32_t wave_len;
 
-	// Envelope parameters
+	// Envelope table, which rises for attack_len frames then decays to zero
+	float*   env;
+	uint32_t env_len;
 	uint32_t attack_len;
 	uint32_t decay_len;
 } Metro;
@@ -125,16 +118,18 @@ connect_port(LV2_Handle instance,
 
 /**
    The activate() method resets the state completely, so the wave offset is
-   zero and the envelope is off.
+   zero, the envelope is off, and the transport is stopped at the start of the
+   first beat.
 */
 static void
 activate(LV2_Handle instance)
 {
 	Metro* self = (Metro*)instance;
 
+	lv2_time_transport_reset(&self->transport);
 	self->elapsed_len = 0;
 	self->wave_offset = 0;
-	self->state       = STATE_OFF;
+	self->clicking    = false;
 }
 
 /**
@@ -167,34 +162,48 @@ instantiate(const LV2_Descriptor*     descriptor,
 		return NULL;
 	}
 
-	// Map URIS
-	MetroURIs* const    uris  = &self->uris;
-	LV2_URID_Map* const map   = self->map;
-	uris->atom_Blank          = map->map(map->handle, LV2_ATOM__Blank);
-	uris->atom_Float          = map->map(map->handle, LV2_ATOM__Float);
-	uris->atom_Object         = map->map(map->handle, LV2_ATOM__Object);
-	uris->atom_Path           = map->map(map->handle, LV2_ATOM__Path);
-	uris->atom_Resource       = map->map(map->handle, LV2_ATOM__Resource);
-	uris->atom_Sequence       = map->map(map->handle, LV2_ATOM__Sequence);
-	uris->time_Position       = map->map(map->handle, LV2_TIME__Position);
-	uris->time_barBeat        = map->map(map->handle, LV2_TIME__barBeat);
-	uris->time_beatsPerMinute = map->map(map->handle, LV2_TIME__beatsPerMinute);
-	uris->time_speed          = map->map(map->handle, LV2_TIME__speed);
+	// Map URIs and initialise the transport
+	lv2_time_transport_init(&self->transport, self->map, rate);
 
 	// Initialise instance fields
-	self->rate       = rate;
-	self->bpm        = 120.0f;
 	self->attack_len = (uint32_t)(attack_s * rate);
 	self->decay_len  = (uint32_t)(decay_s * rate);
-	self->state      = STATE_OFF;
-
-	// Generate one cycle of a sine wave at the desired frequency
-	const double freq = 440.0 * 2.0;
-	const double amp  = 0.5;
-	self->wave_len = (uint32_t)(rate / freq);
-	self->wave     = (float*)malloc(self->wave_len * sizeof(float));
-	for (uint32_t i = 0; i < self->wave_len; ++i) {
-		self->wave[i] = (float)(sin(i * 2 * M_PI * freq / rate) * amp);
+	self->env_len    = self->attack_len + self->decay_len + 1;
+	self->clicking   = false;
+
+	/* Generate one cycle of a sine wave at the desired frequency.  The cycle
+	   is repeated to cover the length of the envelope past any offset in the
+	   first cycle, so a whole click can be rendered without wrapping. */
+	const double   freq     = 440.0 * 2.0;
+	const double   amp      = 0.5;
+	const uint32_t wave_len = (uint32_t)(rate / freq);
+	self->wave_len          = wave_len > 0 ? wave_len : 1;
+	self->wave              = (float*)malloc(
+		(self->wave_len + self->env_len) * sizeof(float));
+	self->env = (float*)malloc(self->env_len * sizeof(float));
+	if (!self->wave || !self->env) {
+		free(self->env);
+		free(self->wave);
+		free(self);
+		return NULL;
+	}
+
+	for (uint32_t i = 0; i < self->wave_len + self->env_len; ++i) {
+		const uint32_t phase = i % self->wave_len;
+		self->wave[i] = (float)(sin(phase * 2 * M_PI * freq / rate) * amp);
+	}
+
+	/* Generate the envelope, which rises linearly from 0 to 1 over attack_len
+	   frames, then falls linearly back to 0 over decay_len frames. */
+	for (uint32_t i = 0; i < self->env_len; ++i) {
+		if (i <= self->attack_len) {
+			self->env[i] = (self->attack_len
+			                ? (float)i / (float)self->attack_len
+			                : 1.0f);
+		} else {
+			self->env[i] = 1.0f - ((float)(i - self->attack_len) /
+			                       (float)self->decay_len);
+		}
 	}
 
 	return (LV2_Handle)self;
@@ -203,133 +212,112 @@ instantiate(const LV2_Descriptor*     descriptor,
 static void
 cleanup(LV2_Handle instance)
 {
-	free(instance);
+	Metro* self = (Metro*)instance;
+
+	free(self->env);
+	free(self->wave);
+	free(self);
 }
 
 /**
-   Play back audio for the range [begin..end) relative to this cycle.  This is
-   called by run() in-between events to output audio up until the current time.
+   Multiply `n` samples of the wave by the envelope.  With SSE, four samples
+   are processed at a time.  The wave and envelope are read from arbitrary
+   offsets, so unaligned loads are used.
 */
 static void
-play(Metro* self, uint32_t begin, uint32_t end)
+render_click(float*       output,
+             const float* wave,
+             const float* env,
+             uint32_t     n)
 {
-	float* const   output          = self->ports.output;
-	const uint32_t frames_per_beat = 60.0f / self->bpm * self->rate;
+	uint32_t i = 0;
 
-	if (self->speed == 0.0f) {
-		memset(output, 0, (end - begin) * sizeof(float));
-		return;
+#ifdef METRO_USE_SSE
+	for (; i + 4 <= n; i += 4) {
+		const __m128 w = _mm_loadu_ps(wave + i);
+		const __m128 e = _mm_loadu_ps(env + i);
+		_mm_storeu_ps(output + i, _mm_mul_ps(w, e));
 	}
+#endif
 
-	for (uint32_t i = begin; i < end; ++i) {
-		switch (self->state) {
-		case STATE_ATTACK:
-			// Amplitude increases from 0..1 until attack_len
-			output[i] = self->wave[self->wave_offset] *
-				self->elapsed_len / (float)self->attack_len;
-			if (self->elapsed_len >= self->attack_len) {
-				self->state = STATE_DECAY;
-			}
-			break;
-		case STATE_DECAY:
-			// Amplitude decreases from 1..0 until attack_len + decay_len
-			output[i] = 0.0f;
-			output[i] = self->wave[self->wave_offset] *
-				(1 - ((self->elapsed_len - self->attack_len) /
-				      (float)self->decay_len));
-			if (self->elapsed_len >= self->attack_len + self->decay_len) {
-				self->state = STATE_OFF;
-			}
-			break;
-		case STATE_OFF:
-			output[i] = 0.0f;
-		}
-
-		// We continuously play the sine wave regardless of envelope
-		self->wave_offset = (self->wave_offset + 1) % self->wave_len;
-
-		// Update elapsed time and start attack if necessary
-		if (++self->elapsed_len == frames_per_beat) {
-			self->state       = STATE_ATTACK;
-			self->elapsed_len = 0;
-		}
+	for (; i < n; ++i) {
+		output[i] = wave[i] * env[i];
 	}
 }
 
 /**
-   Update the current position based on a host message.  This is called by
-   run() when a time:Position is received.
+   Render audio for the range [begin..end) relative to this cycle.  The range
+   is divided into at most two spans: the rest of the click if one is playing,
+   which is rendered by multiplying the wave by the envelope table, and
+   silence, which is simply cleared.
 */
 static void
-update_position(Metro* self, const LV2_Atom_Object* obj)
+render(Metro* self, uint32_t begin, uint32_t end)
 {
-	const MetroURIs* uris = &self->uris;
-
-	// Received new transport position/speed
-	LV2_Atom *beat = NULL, *bpm = NULL, *speed = NULL;
-	lv2_atom_object_get(obj,
-	                    uris->time_barBeat, &beat,
-	                    uris->time_beatsPerMinute, &bpm,
-	                    uris->time_speed, &speed,
-	                    NULL);
-	if (bpm && bpm->type == uris->atom_Float) {
-		// Tempo changed, update BPM
-		self->bpm = ((LV2_Atom_Float*)bpm)->body;
-	}
-	if (speed && speed->type == uris->atom_Float) {
-		// Speed changed, e.g. 0 (stop) to 1 (play)
-		self->speed = ((LV2_Atom_Float*)speed)->body;
-	}
-	if (beat && beat->type == uris->atom_Float) {
-		// Received a beat position, synchronise
-		// This hard sync may cause clicks, a real plugin would be more graceful
-		const float frames_per_beat = 60.0f / self->bpm * self->rate;
-		const float bar_beats       = ((LV2_Atom_Float*)beat)->body;
-		const float beat_beats      = bar_beats - floorf(bar_beats);
-		self->elapsed_len           = beat_beats * frames_per_beat;
-		if (self->elapsed_len < self->attack_len) {
-			self->state = STATE_ATTACK;
-		} else if (self->elapsed_len < self->attack_len + self->decay_len) {
-			self->state = STATE_DECAY;
+	float* const output = self->ports.output;
+
+	for (uint32_t i = begin; i < end;) {
+		uint32_t n = end - i;
+		if (self->clicking) {
+			// Play the click until the end of the envelope
+			const uint32_t to_silence = self->env_len - self->elapsed_len;
+			n = n < to_silence ? n : to_silence;
+			render_click(output + i,
+			             self->wave + self->wave_offset,
+			             self->env + self->elapsed_len,
+			             n);
+
+			self->elapsed_len += n;
+			self->clicking = self->elapsed_len < self->env_len;
 		} else {
-			self->state = STATE_OFF;
+			// Silence until the end of the range
+			memset(output + i, 0, n * sizeof(float));
 		}
+
+		// We continuously play the sine wave regardless of envelope
+		self->wave_offset = (self->wave_offset + n) % self->wave_len;
+		i += n;
 	}
 }
 
+/**
+   Play back audio for the cycle.  The transport reads the position updates
+   from the host, then finds the frame where each beat starts.  Audio is
+   rendered up to that frame, a new click is started, and so on until the end
+   of the cycle, so there is only work to do for every click, not for every
+   sample.  Any click that is playing continues through position updates and
+   after the transport stops, so it is never cut off.  If the host moves the
+   position back slightly, the same beat may be found again, which is ignored
+   while its click is still playing.
+*/
 static void
 run(LV2_Handle instance, uint32_t sample_count)
 {
-	Metro*           self = (Metro*)instance;
-	const MetroURIs* uris = &self->uris;
-
-	// Work forwards in time frame by frame, handling events as we go
-	const LV2_Atom_Sequence* in     = self->ports.control;
-	uint32_t                 last_t = 0;
-	for (const LV2_Atom_Event* ev = lv2_atom_sequence_begin(&in->body);
-	     !lv2_atom_sequence_is_end(&in->body, in->atom.size, ev);
-	     ev = lv2_atom_sequence_next(ev)) {
-
-		// Play the click for the time slice from last_t until now
-		play(self, last_t, ev->time.frames);
-
-		// Check if this event is an Object
-		// (or deprecated Blank to tolerate old hosts)
-		if (ev->body.type == uris->atom_Object ||
-		    ev->body.type == uris->atom_Blank) {
-			const LV2_Atom_Object* obj = (const LV2_Atom_Object*)&ev->body;
-			if (obj->body.otype == uris->time_Position) {
-				// Received position information, update
-				update_position(self, obj);
-			}
+	Metro*              self      = (Metro*)instance;
+	LV2_Time_Transport* transport = &self->transport;
+
+	lv2_time_transport_read(transport, self->ports.control, sample_count);
+
+	uint32_t offset = 0;
+	double   beat   = 0.0;
+	for (uint32_t f = 0;
+	     (f = lv2_time_transport_next_beat(
+		      transport, f, sample_count, &beat)) < sample_count;
+	     ++f) {
+		if (self->clicking && beat == self->click_beat) {
+			continue;
 		}
 
-		// Update time for next iteration and move to next event
-		last_t = ev->time.frames;
+		render(self, offset, f);
+
+		// Start a new click
+		self->click_beat  = beat;
+		self->elapsed_len = 0;
+		self->clicking    = true;
+		offset            = f;
 	}
 
-	// Play for remainder of cycle
-	play(self, last_t, sample_count);
+	render(self, offset, sample_count);
 }
 
 static const LV2_Descriptor descriptor = {
@@ -23,25 +23,49 @@
 #include "lv2/midi/midi.h"
 #include "lv2/urid/urid.h"
 
+#include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#    define MIDIGATE_USE_SSE 1
+#    include <xmmintrin.h>
+#endif
+
 #define MIDIGATE_URI "http://lv2plug.in/plugins/eg-midigate"
 
+/** Maximum number of segments that are collected before rendering. */
+#define MAX_SEGMENTS 64u
+
 typedef enum {
 	MIDIGATE_CONTROL = 0,
 	MIDIGATE_IN      = 1,
-	MIDIGATE_OUT     = 2
+	MIDIGATE_OUT     = 2,
+	MIDIGATE_FADE    = 3
 } PortIndex;
 
+/**
+   A segment of output with a gain that changes linearly from `from` to `to`.
+   Most segments have a constant gain of 0 or 1, and are simply cleared or
+   copied from the input.
+*/
+typedef struct {
+	uint32_t start;   // Offset in cycle
+	uint32_t length;  // Number of frames
+	float    from;    // Gain before the first frame
+	float    to;      // Gain at the last frame
+} Segment;
+
 typedef struct {
 	// Port buffers
 	const LV2_Atom_Sequence* control;
 	const float*             in;
 	float*                   out;
+	const float*             fade;
 
 	// Features
 	LV2_URID_Map*  map;
@@ -51,8 +75,16 @@ typedef struct {
 		LV2_URID midi_MidiEvent;
 	} uris;
 
+	double   rate;            // Sample rate
+	float    gain;            // Current gain, which fades towards the gate
+	float    fade_ms;         // Fade time that fade_step was calculated for
+	float    fade_step;       // Change in gain per frame while fading
 	unsigned n_active_notes;
-	unsigned program;  // 0 = normal, 1 = inverted
+	unsigned program;         // 0 = normal, 1 = inverted
+
+	// Segments of output that have not been rendered yet
+	Segment  segments[MAX_SEGMENTS];
+	uint32_t n_segments;
 } Midigate;
 
 static LV2_Handle
@@ -82,6 +114,10 @@ instantiate(const LV2_Descriptor*     descriptor,
 	self->uris.midi_MidiEvent = self->map->map(
 		self->map->handle, LV2_MIDI__MidiEvent);
 
+	self->rate      = rate;
+	self->fade_ms   = 0.0f;
+	self->fade_step = 1.0f;
+
 	return (LV2_Handle)self;
 }
 
@@ -102,6 +138,9 @@ connect_port(LV2_Handle instance,
 	case MIDIGATE_OUT:
 		self->out = (float*)data;
 		break;
+	case MIDIGATE_FADE:
+		self->fade = (const float*)data;
+		break;
 	}
 }
 
@@ -109,38 +148,191 @@ static void
 activate(LV2_Handle instance)
 {
 	Midigate* self = (Midigate*)instance;
+	self->gain           = 0.0f;
 	self->n_active_notes = 0;
 	self->program        = 0;
+	self->n_segments     = 0;
 }
 
-/**
-   A function to write a chunk of output, to be called from run().  If the gate
-   is high, then the input will be passed through for this chunk, otherwise
-   silence is written.
-*/
-static void
-write_output(Midigate* self, uint32_t offset, uint32_t len)
+/** Return the gain the output should have with the current gate state. */
+static float
+gate_gain(const Midigate* self)
 {
 	const bool active = (self->program == 0)
 		? (self->n_active_notes > 0)
 		: (self->n_active_notes == 0);
-	if (active) {
-		memcpy(self->out + offset, self->in + offset, len * sizeof(float));
-	} else {
-		memset(self->out + offset, 0, len * sizeof(float));
+
+	return active ? 1.0f : 0.0f;
+}
+
+/**
+   Multiply `n` samples of input by a gain that ramps linearly from `from` to
+   `to`.  The gain for sample `i` is `from + (i + 1) * step`, which is
+   calculated in the same way by the vector and scalar code.  With SSE,
+   samples are processed in groups of four with unaligned loads and stores,
+   since segments start at any frame.
+*/
+static void
+apply_ramp(const float* in, float* out, float from, float to, uint32_t n)
+{
+	const float step = (to - from) / (float)n;
+	uint32_t    i    = 0;
+
+#ifdef MIDIGATE_USE_SSE
+	/* Eight samples are processed per iteration with two separate indices,
+	   so the additions to advance them do not wait on each other. */
+	const __m128 vfrom  = _mm_set1_ps(from);
+	const __m128 vstep  = _mm_set1_ps(step);
+	const __m128 veight = _mm_set1_ps(8.0f);
+	__m128       index0 = _mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f);
+	__m128       index1 = _mm_setr_ps(5.0f, 6.0f, 7.0f, 8.0f);
+	for (; i + 8 <= n; i += 8) {
+		const __m128 gain0 = _mm_add_ps(vfrom, _mm_mul_ps(vstep, index0));
+		const __m128 gain1 = _mm_add_ps(vfrom, _mm_mul_ps(vstep, index1));
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(in + i), gain0));
+		_mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_loadu_ps(in + i + 4), gain1));
+		index0 = _mm_add_ps(index0, veight);
+		index1 = _mm_add_ps(index1, veight);
+	}
+#endif
+
+	for (; i < n; ++i) {
+		out[i] = in[i] * (from + step * (float)(i + 1));
 	}
 }
 
 /**
-   This plugin works through the cycle in chunks starting at offset zero.  The
-   +offset+ represents the current time within this this cycle, so
-   the output from 0 to +offset+ has already been written.
+   Render all collected segments.  The common cases of an open or closed gate
+   are a copy (or nothing at all, if processing in-place) or a clear, and only
+   fades need to multiply every sample.
+*/
+static void
+render_segments(Midigate* self)
+{
+	const float* const in  = self->in;
+	float* const       out = self->out;
+
+	for (uint32_t i = 0; i < self->n_segments; ++i) {
+		const Segment* const seg = &self->segments[i];
+		if (seg->from != seg->to) {
+			apply_ramp(in + seg->start, out + seg->start,
+			           seg->from, seg->to, seg->length);
+		} else if (seg->to == 0.0f) {
+			memset(out + seg->start, 0, seg->length * sizeof(float));
+		} else if (in != out) {
+			memcpy(out + seg->start, in + seg->start,
+			       seg->length * sizeof(float));
+		}
+	}
+
+	self->n_segments = 0;
+}
 
-   MIDI events are read in a loop.  In each iteration, the number of active
-   notes (on note on and note off) or the program (on program change) is
-   updated, then the output is written up until the current event time.  Then
-   +offset+ is updated and the next event is processed.  After the loop the
-   final chunk from the last event to the end of the cycle is emitted.
+/**
+   Add a segment, or extend the previous one if they both have the same
+   constant gain, so several events that do not change the gate only result
+   in a single copy or clear.  If the list is full, the segments collected so
+   far are rendered first.
+*/
+static void
+push_segment(Midigate* self, uint32_t start, uint32_t length, float to)
+{
+	const float from = self->gain;
+	if (self->n_segments > 0) {
+		Segment* const last = &self->segments[self->n_segments - 1];
+		if (from == to && last->from == to && last->to == to) {
+			last->length += length;
+			return;
+		}
+	}
+
+	if (self->n_segments == MAX_SEGMENTS) {
+		render_segments(self);
+	}
+
+	const Segment seg = { start, length, from, to };
+	self->segments[self->n_segments++] = seg;
+	self->gain = to;
+}
+
+/**
+   Add segments for the output in the range [begin..end) relative to this
+   cycle, based on the current gate state.  If the gain is not at the gate
+   yet, it fades towards it at a constant rate, so a fade that is interrupted
+   by the gate changing back takes only as long as it has run so far.
+*/
+static void
+add_segments(Midigate* self, uint32_t begin, uint32_t end)
+{
+	const float target = gate_gain(self);
+
+	while (begin < end) {
+		uint32_t n  = end - begin;
+		float    to = target;
+		if (self->gain != target) {
+			// Fade towards the gate, or jump to it if there is no fade
+			const float    dist = fabsf(target - self->gain);
+			const uint32_t left = (uint32_t)ceilf(dist / self->fade_step);
+			if (n < left) {
+				const float step = (float)n * self->fade_step;
+				to = self->gain + (target > self->gain ? step : -step);
+			} else {
+				n = left;
+			}
+		}
+
+		push_segment(self, begin, n, to);
+		begin += n;
+	}
+}
+
+/**
+   A function to handle a MIDI event, to be called from run().  The number of
+   active notes (on note on and note off) or the program (on program change)
+   is updated, which affects the output written after this event.
+*/
+static void
+handle_event(Midigate* self, const LV2_Atom_Event* ev)
+{
+	if (ev->body.type == self->uris.midi_MidiEvent) {
+		const uint8_t* const msg = (const uint8_t*)(ev + 1);
+		switch (lv2_midi_message_type(msg)) {
+		case LV2_MIDI_MSG_NOTE_ON:
+			++self->n_active_notes;
+			break;
+		case LV2_MIDI_MSG_NOTE_OFF:
+			if (self->n_active_notes > 0) {
+				--self->n_active_notes;
+			}
+			break;
+		case LV2_MIDI_MSG_CONTROLLER:
+			if (msg[1] == LV2_MIDI_CTL_ALL_NOTES_OFF) {
+				self->n_active_notes = 0;
+			}
+			break;
+		case LV2_MIDI_MSG_PGM_CHANGE:
+			if (msg[1] == 0 || msg[1] == 1) {
+				self->program = msg[1];
+			}
+			break;
+		default: break;
+		}
+	}
+}
+
+/**
+   This plugin works through the cycle in a single pass over the MIDI events.
+   The output up to each event is added to a list of segments based on the
+   current gate state, then the event is handled, which may change the gate
+   for the following output.  After all events have been handled, the
+   segments are rendered together.
+
+   Switching between the input and silence instantly would cause clicks, so
+   when the gate changes, the gain fades linearly to the new state over the
+   time set by the fade port.  This is still sample accurate, since the fade
+   starts at the exact frame of the event.  Segments where the gate is steady
+   are simply copied or cleared, so this costs almost nothing more than
+   switching when the gate does not change often.
 
    There is currently no standard way to describe MIDI programs in LV2, so the
    host has no way of knowing that these programs exist and should be presented
@@ -148,48 +340,34 @@ write_output(Midigate* self, uint32_t offset, uint32_t len)
 
    This pattern of iterating over input events and writing output along the way
    is a common idiom for writing sample accurate output based on event input.
-
-   Note that this simple example simply writes input or zero for each sample
-   based on the gate.  A serious implementation would need to envelope the
-   transition to avoid aliasing.
 */
 static void
 run(LV2_Handle instance, uint32_t sample_count)
 {
-	Midigate* self   = (Midigate*)instance;
-	uint32_t  offset = 0;
+	Midigate* self = (Midigate*)instance;
 
+	if (*self->fade != self->fade_ms) {
+		// Fade time changed, calculate the new fade step
+		const double fade_len = *self->fade * self->rate / 1000.0;
+		self->fade_ms         = *self->fade;
+		self->fade_step       = (fade_len > 1.0 ? (float)(1.0 / fade_len)
+		                                        : 1.0f);
+	}
+
+	uint32_t offset = 0;
 	LV2_ATOM_SEQUENCE_FOREACH(self->control, ev) {
-		if (ev->body.type == self->uris.midi_MidiEvent) {
-			const uint8_t* const msg = (const uint8_t*)(ev + 1);
-			switch (lv2_midi_message_type(msg)) {
-			case LV2_MIDI_MSG_NOTE_ON:
-				++self->n_active_notes;
-				break;
-			case LV2_MIDI_MSG_NOTE_OFF:
-				if (self->n_active_notes > 0) {
-					--self->n_active_notes;
-				}
-				break;
-			case LV2_MIDI_MSG_CONTROLLER:
-				if (msg[1] == LV2_MIDI_CTL_ALL_NOTES_OFF) {
-					self->n_active_notes = 0;
-				}
-				break;
-			case LV2_MIDI_MSG_PGM_CHANGE:
-				if (msg[1] == 0 || msg[1] == 1) {
-					self->program = msg[1];
-				}
-				break;
-			default: break;
-			}
-		}
+		const int64_t  t     = ev->time.frames;
+		const uint32_t frame = (t <= (int64_t)offset       ? offset
+		                        : t >= (int64_t)sample_count ? sample_count
+		                                                     : (uint32_t)t);
 
-		write_output(self, offset, ev->time.frames - offset);
-		offset = (uint32_t)ev->time.frames;
+		add_segments(self, offset, frame);
+		handle_event(self, ev);
+		offset = frame;
 	}
 
-	write_output(self, offset, sample_count - offset);
+	add_segments(self, offset, sample_count);
+	render_segments(self);
 }
 
 /**
@@ -41,6 +41,18 @@
 
 #define N_PROPS 9
 
+/* save() may be called while run() is running, so the generations they share
+   are accessed atomically */
+#ifdef __GNUC__
+#    define LOAD_ACQUIRE(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#    define STORE_RELEASE(ptr, val) \
+	__atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+#else
+/* MSVC gives volatile accesses acquire and release semantics by default */
+#    define LOAD_ACQUIRE(ptr) (*(const volatile uint32_t*)(ptr))
+#    define STORE_RELEASE(ptr, val) (*(volatile uint32_t*)(ptr) = (val))
+#endif
+
 typedef struct {
 	LV2_URID plugin;
 	LV2_URID atom_Path;
@@ -56,6 +68,7 @@ typedef struct {
 	LV2_URID patch_subject;
 	LV2_URID patch_property;
 	LV2_URID patch_value;
+	LV2_URID state_StateChanged;
 } URIs;
 
 typedef struct {
@@ -90,6 +103,7 @@ map_uris(LV2_URID_Map* map, URIs* uris)
 	uris->patch_subject      = map->map(map->handle, LV2_PATCH__subject);
 	uris->patch_property     = map->map(map->handle, LV2_PATCH__property);
 	uris->patch_value        = map->map(map->handle, LV2_PATCH__value);
+	uris->state_StateChanged = map->map(map->handle, LV2_STATE__StateChanged);
 }
 
 enum {
@@ -114,8 +128,16 @@ typedef struct {
 	URIs uris;
 
 	// Plugin state
-	StateMapItem props[N_PROPS];
-	State        state;
+	StateMapItem    props[N_PROPS];
+	StateMapChanges changes;  ///< Changes not yet sent to the output
+	State           state;
+
+	/* Generations of the state, which count changes.  Only the published and
+	   saved generations are shared between run() and save(). */
+	uint32_t published_generation;  ///< Generation visible to save()
+	uint32_t saved_generation;      ///< Published generation at last save
+	uint32_t internal_generation;   ///< Generation of last internal change
+	uint32_t changed_generation;    ///< Generation when last announced
 
 	// Buffer for making strings from URIDs if unmap is not provided
 	char urid_buf[12];
@@ -243,9 +265,10 @@ set_parameter(Params*     self,
 	}
 
 	// Set property value in state dictionary
-	lv2_log_trace(&self->log, "Set <%s>\n", entry->uri);
-	memcpy(entry->value + 1, body, size);
-	entry->value->size = size;
+	if (state_map_set(self->props, &self->changes, entry, body, size)) {
+		lv2_log_trace(&self->log, "Set <%s>\n", entry->uri);
+	}
+
 	return LV2_STATE_SUCCESS;
 }
 
@@ -281,6 +304,33 @@ write_param_to_forge(LV2_State_Handle handle,
 	return LV2_STATE_SUCCESS;
 }
 
+/** Store function that writes a property as a complete patch:Set message. */
+static LV2_State_Status
+write_set_to_forge(LV2_State_Handle handle,
+                   uint32_t         key,
+                   const void*      value,
+                   size_t           size,
+                   uint32_t         type,
+                   uint32_t         flags)
+{
+	Params*         self  = (Params*)handle;
+	LV2_Atom_Forge* forge = &self->forge;
+
+	LV2_Atom_Forge_Frame frame;
+	if (!lv2_atom_forge_frame_time(forge, 0) ||
+	    !lv2_atom_forge_object(forge, &frame, 0, self->uris.patch_Set)) {
+		return LV2_STATE_ERR_UNKNOWN;
+	}
+
+	lv2_atom_forge_key(forge, self->uris.patch_property);
+	lv2_atom_forge_urid(forge, key);
+	const LV2_State_Status st = write_param_to_forge(
+		forge, self->uris.patch_value, value, size, type, flags);
+
+	lv2_atom_forge_pop(forge, &frame);
+	return st;
+}
+
 static void
 store_prop(Params*                  self,
            LV2_State_Map_Path*      map_path,
@@ -317,12 +367,42 @@ store_prop(Params*                  self,
 	}
 }
 
+/**
+   Store the properties with a bit set in `mask`.
+
+   This is used by save() to store every property, but also internally for
+   writing messages in the audio thread by passing a "store" function which
+   actually writes the description to the forge.  Messages about changes only
+   include the dirty properties, so they stay small regardless of how many
+   properties the plugin has.
+*/
+static LV2_State_Status
+store_props(Params*                  self,
+            LV2_State_Map_Path*      map_path,
+            LV2_State_Store_Function store,
+            LV2_State_Handle         handle,
+            uint64_t                 mask)
+{
+	LV2_State_Status st = LV2_STATE_SUCCESS;
+	for (unsigned i = 0; i < N_PROPS; ++i) {
+		if (mask & ((uint64_t)1u << i)) {
+			StateMapItem* prop = &self->props[i];
+			store_prop(
+				self, map_path, &st, store, handle, prop->urid, prop->value);
+		}
+	}
+
+	return st;
+}
+
 /**
    State save method.
 
-   This is used in the usual way when called by the host to save plugin state,
-   but also internally for writing messages in the audio thread by passing a
-   "store" function which actually writes the description to the forge.
+   The host builds a new state from everything stored here, so every property
+   is stored, not only those that changed since the last save.  Instead, the
+   plugin notifies the host with a state:StateChanged event when it changes
+   its own state, so the host can avoid saving instances that have not
+   changed at all.
 */
 static LV2_State_Status
 save(LV2_Handle                instance,
@@ -335,12 +415,13 @@ save(LV2_Handle                instance,
 	LV2_State_Map_Path* map_path = (LV2_State_Map_Path*)lv2_features_data(
 		features, LV2_STATE__mapPath);
 
-	LV2_State_Status st = LV2_STATE_SUCCESS;
-	for (unsigned i = 0; i < N_PROPS; ++i) {
-		StateMapItem* prop = &self->props[i];
-		store_prop(self, map_path, &st, store, handle, prop->urid, prop->value);
-	}
+	// Changes after this generation may not be stored, run() announces them
+	const uint32_t generation = LOAD_ACQUIRE(&self->published_generation);
+
+	const LV2_State_Status st = store_props(
+		self, map_path, store, handle, ~(uint64_t)0u);
 
+	STORE_RELEASE(&self->saved_generation, generation);
 	return st;
 }
 
@@ -382,6 +463,8 @@ restore(LV2_Handle                  instance,
 		retrieve_prop(self, &st, retrieve, handle, self->props[i].urid);
 	}
 
+	STORE_RELEASE(&self->published_generation, self->changes.generation);
+
 	return st;
 }
 
@@ -410,6 +493,39 @@ run(LV2_Handle instance, uint32_t sample_count)
 	LV2_Atom_Forge_Frame out_frame;
 	lv2_atom_forge_sequence_head(&self->forge, &out_frame, 0);
 
+	if (self->state.spring.body > 0.0f) {
+		const float spring = self->state.spring.body;
+		const float next   = (spring >= 0.001f) ? spring - 0.001f : 0.0f;
+		state_map_set(self->props,
+		              &self->changes,
+		              state_map_find(self->props, N_PROPS, uris->eg_spring),
+		              &next,
+		              sizeof(next));
+
+		// The host did not make this change, so it must be told about it
+		self->internal_generation = self->changes.generation;
+	}
+
+	/* Tell the host that the state has changed if there are internal changes
+	   that the last save may not include, once for every save. */
+	const uint32_t saved = LOAD_ACQUIRE(&self->saved_generation);
+	if (self->internal_generation > saved &&
+	    self->changed_generation <= saved) {
+		lv2_atom_forge_frame_time(&self->forge, 0);
+		LV2_Atom_Forge_Frame frame;
+		lv2_atom_forge_object(
+			&self->forge, &frame, 0, uris->state_StateChanged);
+		lv2_atom_forge_pop(&self->forge, &frame);
+		self->changed_generation = self->changes.generation;
+	}
+
+	/* Send a patch:Set for every property that changed since the last cycle,
+	   before any replies to messages, so events remain in time order. */
+	if (self->changes.dirty) {
+		store_props(self, NULL, write_set_to_forge, self, self->changes.dirty);
+		self->changes.dirty = 0;
+	}
+
 	// Read incoming events
 	LV2_ATOM_SEQUENCE_FOREACH(self->in_port, ev) {
 		const LV2_Atom_Object* obj = (const LV2_Atom_Object*)&ev->body;
@@ -453,7 +569,8 @@ run(LV2_Handle instance, uint32_t sample_count)
 
 				LV2_Atom_Forge_Frame bframe;
 				lv2_atom_forge_object(&self->forge, &bframe, 0, 0);
-				save(self, write_param_to_forge, &self->forge, 0, NULL);
+				store_props(self, NULL, write_param_to_forge, &self->forge,
+				            ~(uint64_t)0u);
 
 				lv2_atom_forge_pop(&self->forge, &bframe);
 				lv2_atom_forge_pop(&self->forge, &pframe);
@@ -480,22 +597,10 @@ run(LV2_Handle instance, uint32_t sample_count)
 		}
 	}
 
-	if (self->state.spring.body > 0.0f) {
-		const float spring = self->state.spring.body;
-		self->state.spring.body = (spring >= 0.001) ? spring - 0.001 : 0.0;
-		lv2_atom_forge_frame_time(&self->forge, 0);
-		LV2_Atom_Forge_Frame frame;
-		lv2_atom_forge_object(&self->forge, &frame, 0, uris->patch_Set);
-
-		lv2_atom_forge_key(&self->forge, uris->patch_property);
-		lv2_atom_forge_urid(&self->forge, uris->eg_spring);
-		lv2_atom_forge_key(&self->forge, uris->patch_value);
-		lv2_atom_forge_float(&self->forge, self->state.spring.body);
-
-		lv2_atom_forge_pop(&self->forge, &frame);
-	}
-
 	lv2_atom_forge_pop(&self->forge, &out_frame);
+
+	// Publish the generation of the state after this cycle for save()
+	STORE_RELEASE(&self->published_generation, self->changes.generation);
 }
 
 static const void*
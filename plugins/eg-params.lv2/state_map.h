@@ -19,7 +19,10 @@
 #include "lv2/urid/urid.h"
 
 #include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 /** Entry in an array that serves as a dictionary of properties. */
 typedef struct {
@@ -28,6 +31,20 @@ typedef struct {
 	LV2_Atom*   value;
 } StateMapItem;
 
+/**
+   Changes to the values in a state map.
+
+   The dirty set has a bit for each item, which is set when its value changes
+   and cleared by whatever consumes the changes, so a map with changes can
+   have at most 64 items.  The generation is incremented by every change, so
+   comparing it with a previously recorded generation is a cheap way to tell
+   if anything at all has changed since then.
+*/
+typedef struct {
+	uint64_t dirty;       ///< Bit i is set if the value of dict[i] changed
+	uint32_t generation;  ///< Number of changes so far
+} StateMapChanges;
+
 /** Comparator for StateMapItems sorted by URID. */
 static int
 state_map_cmp(const void* a, const void* b)
@@ -112,3 +129,30 @@ state_map_find(StateMapItem dict[], uint32_t n_entries, LV2_URID urid)
 		&key, dict, n_entries, sizeof(StateMapItem), state_map_cmp);
 }
 
+/**
+   Set the value of an item in a state map, and record the change.
+
+   If the new value is identical to the current one, then nothing is changed,
+   so setting a value repeatedly, for example while a UI echoes it back, does
+   not make it dirty.  The value of the item must have room for `size` bytes.
+
+   @return True if the value changed.
+*/
+static bool
+state_map_set(const StateMapItem  dict[],
+              StateMapChanges*    changes,
+              const StateMapItem* item,
+              const void*         body,
+              uint32_t            size)
+{
+	LV2_Atom* const value = item->value;
+	if (value->size == size && !memcmp(value + 1, body, size)) {
+		return false;
+	}
+
+	memcpy(value + 1, body, size);
+	value->size = size;
+	changes->dirty |= (uint64_t)1u << (uint32_t)(item - dict);
+	++changes->generation;
+	return true;
+}
@@ -0,0 +1,205 @@
+/*
+  Copyright 2026 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "atom_sink.h"
+
+#include "lv2/atom/atom-test-utils.c"
+#include "lv2/atom/atom.h"
+#include "lv2/atom/forge.h"
+#include "lv2/atom/util.h"
+#include "lv2/urid/urid.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Size of an int in a tuple, with padding. */
+#define INT_SIZE lv2_atom_pad_size(sizeof(LV2_Atom_Int))
+
+static LV2_URID_Map map = { NULL, urid_map };
+
+static uint32_t
+count_chunks(const AtomSink* sink)
+{
+	uint32_t n = 0;
+	for (const AtomSinkChunk* c = sink->chunks; c; c = c->next) {
+		++n;
+	}
+	return n;
+}
+
+/** Forge a tuple of `n` ints counting up from `first` into `sink`. */
+static LV2_Atom_Forge_Ref
+write_tuple(AtomSink* sink, int32_t first, uint32_t n)
+{
+	LV2_Atom_Forge forge;
+	lv2_atom_forge_init(&forge, &map);
+	lv2_atom_forge_set_sink(&forge, atom_sink, atom_sink_deref, sink);
+
+	LV2_Atom_Forge_Frame     frame;
+	const LV2_Atom_Forge_Ref ref = lv2_atom_forge_tuple(&forge, &frame);
+	for (uint32_t i = 0; i < n; ++i) {
+		if (!lv2_atom_forge_int(&forge, first + (int32_t)i)) {
+			return 0;
+		}
+	}
+
+	lv2_atom_forge_pop(&forge, &frame);
+	return ref;
+}
+
+/** Return true iff `atom` is a tuple written by write_tuple(). */
+static bool
+check_tuple(const LV2_Atom* atom, int32_t first, uint32_t n)
+{
+	if (!atom || atom->size != n * INT_SIZE) {
+		return false;
+	}
+
+	int32_t expected = first;
+	LV2_ATOM_TUPLE_FOREACH((const LV2_Atom_Tuple*)atom, elem) {
+		if (((const LV2_Atom_Int*)elem)->body != expected++) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int
+test_growth(void)
+{
+	AtomSink sink;
+	if (!atom_sink_init(&sink, 64)) {
+		return test_fail("Failed to initialise sink\n");
+	}
+
+	// A message much larger than a chunk is moved to a new larger chunk
+	if (!write_tuple(&sink, 0, 100) || sink.overflow) {
+		return test_fail("Failed to write message larger than a chunk\n");
+	} else if (!check_tuple(atom_sink_atom(&sink), 0, 100)) {
+		return test_fail("Corrupt message after moving to a new chunk\n");
+	} else if (sink.chunk == sink.chunks || sink.chunk->capacity % 64) {
+		return test_fail("Unexpected chunks after growing\n");
+	}
+
+	// After a reset, the same message is written without allocating
+	const uint32_t n_chunks = count_chunks(&sink);
+	atom_sink_reset(&sink);
+	if (atom_sink_atom(&sink) || sink.chunk != sink.chunks) {
+		return test_fail("Sink not empty after reset\n");
+	} else if (!write_tuple(&sink, 1, 100) ||
+	           count_chunks(&sink) != n_chunks ||
+	           !check_tuple(atom_sink_atom(&sink), 1, 100)) {
+		return test_fail("Failed to reuse chunks after reset\n");
+	}
+
+	atom_sink_free(&sink);
+	return 0;
+}
+
+static int
+test_arena(void)
+{
+	AtomSink sink;
+	if (!atom_sink_init(&sink, 128)) {
+		return test_fail("Failed to initialise sink\n");
+	}
+
+	// Finished messages stay in place while more are written
+	write_tuple(&sink, 0, 2);
+	const LV2_Atom* const first = atom_sink_finish(&sink);
+	write_tuple(&sink, 10, 2);
+	const LV2_Atom* const second = atom_sink_finish(&sink);
+	write_tuple(&sink, 20, 50);
+	const LV2_Atom* const third = atom_sink_finish(&sink);
+	if (!check_tuple(first, 0, 2) || !check_tuple(second, 10, 2) ||
+	    !check_tuple(third, 20, 50)) {
+		return test_fail("Corrupt finished messages\n");
+	} else if ((const uint8_t*)second !=
+	           (const uint8_t*)first + lv2_atom_total_size(first)) {
+		return test_fail("Messages in a chunk are not contiguous\n");
+	} else if (sink.chunk == sink.chunks) {
+		return test_fail("Large message was not moved to a new chunk\n");
+	}
+
+	// Finishing nothing gives nothing
+	if (atom_sink_finish(&sink)) {
+		return test_fail("Finished empty message\n");
+	}
+
+	atom_sink_free(&sink);
+	return 0;
+}
+
+static int
+test_fixed(void)
+{
+	AtomSink sink;
+	if (!atom_sink_init(&sink, 64) || !atom_sink_reserve(&sink, 512)) {
+		return test_fail("Failed to initialise sink\n");
+	}
+
+	// Reserving again with enough capacity does not allocate
+	const uint32_t n_chunks = count_chunks(&sink);
+	if (!atom_sink_reserve(&sink, 256) || count_chunks(&sink) != n_chunks) {
+		return test_fail("Reserved capacity that was already available\n");
+	}
+
+	// A message that fits in the reserved chunk is written
+	sink.fixed = true;
+	atom_sink_reset(&sink);
+	const uint32_t max_ints = (512 - sizeof(LV2_Atom)) / INT_SIZE;
+	if (!write_tuple(&sink, 0, max_ints) || sink.overflow ||
+	    !check_tuple(atom_sink_atom(&sink), 0, max_ints)) {
+		return test_fail("Failed to write reserved size message\n");
+	}
+
+	// A larger message fails and reports overflow without allocating
+	atom_sink_reset(&sink);
+	if (write_tuple(&sink, 0, max_ints + 1) || !sink.overflow) {
+		return test_fail("Fixed sink wrote past its capacity\n");
+	} else if (count_chunks(&sink) != n_chunks) {
+		return test_fail("Fixed sink allocated\n");
+	} else if (atom_sink_finish(&sink) || sink.overflow) {
+		return test_fail("Finished message that overflowed\n");
+	}
+
+	// Reset clears the overflow
+	atom_sink_reset(&sink);
+	if (sink.overflow || !write_tuple(&sink, 0, 1)) {
+		return test_fail("Failed to write after reset\n");
+	}
+
+	// Capacities that can not be rounded up to a chunk are rejected
+	if (atom_sink_reserve(&sink, UINT32_MAX) ||
+	    atom_sink_reserve(&sink, UINT32_MAX - 62)) {
+		return test_fail("Reserved capacity that overflows\n");
+	}
+
+	atom_sink_free(&sink);
+	return 0;
+}
+
+int
+main(void)
+{
+	const int ret = test_growth() || test_arena() || test_fixed();
+
+	free_urid_map();
+	return ret;
+}
@@ -1,5 +1,5 @@
 /*
-  Copyright 2016 David Robillard <d@drobilla.net>
+  Copyright 2016-2026 David Robillard <d@drobilla.net>
 
   Permission to use, copy, modify, and/or distribute this software for any
   purpose with or without fee is hereby granted, provided that the above
@@ -15,28 +15,249 @@
 */
 
 #include "lv2/atom/forge.h"
+#include "lv2/atom/util.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** A chunk of memory in an AtomSink. */
+typedef struct AtomSinkChunkImpl {
+	struct AtomSinkChunkImpl* next;      ///< Next chunk, or NULL
+	uint32_t                  capacity;  ///< Size of data in bytes
+	uint32_t                  padding;   ///< Unused, for alignment
+	uint64_t                  data[];    ///< Chunk memory
+} AtomSinkChunk;
+
+/**
+   A chunked arena for forge output.
+
+   Memory is kept in a list of chunks, which are never moved or freed until
+   the sink is freed.  Each message is forged contiguously into a chunk, and
+   when it does not fit in the rest of the current chunk, what has been
+   written so far is moved to the next chunk that is large enough.  Finished
+   messages stay where they are, so several messages can be forged before
+   using any of them.
+
+   When `fixed` is false, a new chunk is allocated if no existing one is large
+   enough, so this must only be done in non-realtime threads.  In realtime
+   threads, set `fixed` so the sink only uses the chunks that have already
+   been allocated (see atom_sink_reserve()), which is realtime safe.  In either
+   case, a write that does not fit fails, which the forge reports as a null
+   ref, and sets `overflow`, so nothing is ever written out of bounds.
+
+   atom_sink_reset() makes all chunks available again without freeing
+   anything, so the same memory can be reused every cycle.
+*/
+typedef struct {
+	AtomSinkChunk* chunks;      ///< First chunk
+	AtomSinkChunk* chunk;       ///< Chunk the current message is in
+	uint8_t*       buf;         ///< Current message, in chunk
+	uint32_t       offset;      ///< Offset of buf in chunk
+	uint32_t       size;        ///< Size of current message
+	uint32_t       chunk_size;  ///< Minimum size of new chunks
+	bool           fixed;       ///< If true, never allocate (realtime safe)
+	bool           overflow;    ///< True if a write failed since the last reset
+} AtomSink;
 
 /**
-   A forge sink that writes to an atom buffer.
+   Allocate a new chunk of at least `capacity` bytes after the last chunk.
 
-   It is assumed that the handle points to an LV2_Atom large enough to store
-   the forge output.  The forged result is in the body of the buffer atom.
+   @return The new chunk, or NULL if allocation failed.
 */
-static LV2_Atom_Forge_Ref
+static inline AtomSinkChunk*
+atom_sink_new_chunk(AtomSink* sink, uint32_t capacity)
+{
+	if (capacity > UINT32_MAX - sink->chunk_size + 1) {
+		return NULL;  // Rounding up would overflow
+	}
+
+	const uint32_t n_chunks = (capacity + sink->chunk_size - 1) /
+		sink->chunk_size;
+	const uint32_t chunk_capacity = (n_chunks ? n_chunks : 1) *
+		sink->chunk_size;
+	AtomSinkChunk* const chunk = (AtomSinkChunk*)malloc(
+		sizeof(AtomSinkChunk) + chunk_capacity);
+	if (!chunk) {
+		return NULL;
+	}
+
+	chunk->next     = NULL;
+	chunk->capacity = chunk_capacity;
+	chunk->padding  = 0;
+
+	AtomSinkChunk** tail = &sink->chunks;
+	while (*tail) {
+		tail = &(*tail)->next;
+	}
+
+	*tail = chunk;
+	return chunk;
+}
+
+/**
+   Make sure a message of `capacity` bytes can be written after a reset.
+
+   This allocates a chunk if there is not already one large enough, so must
+   not be called in a realtime thread.  It is used to prepare a sink for use
+   with `fixed` set.
+   @return True on success, or false if allocation failed.
+*/
+static inline bool
+atom_sink_reserve(AtomSink* sink, uint32_t capacity)
+{
+	for (const AtomSinkChunk* c = sink->chunks; c; c = c->next) {
+		if (c->capacity >= capacity) {
+			return true;
+		}
+	}
+
+	return atom_sink_new_chunk(sink, capacity) != NULL;
+}
+
+/** Clear all output from `sink`, keeping its memory.  Realtime safe. */
+static inline void
+atom_sink_reset(AtomSink* sink)
+{
+	sink->chunk    = sink->chunks;
+	sink->buf      = (uint8_t*)sink->chunks->data;
+	sink->offset   = 0;
+	sink->size     = 0;
+	sink->overflow = false;
+}
+
+/**
+   Initialise `sink` and allocate its first chunk.
+
+   @param sink Sink to initialise.
+   @param chunk_size Size of each allocation, which is also the initial
+   capacity.  This is rounded up to a multiple of 8 bytes.
+   @return True on success, or false if allocation failed.
+*/
+static inline bool
+atom_sink_init(AtomSink* sink, uint32_t chunk_size)
+{
+	memset(sink, 0, sizeof(AtomSink));
+	sink->chunk_size = lv2_atom_pad_size(chunk_size ? chunk_size : 8);
+	if (!atom_sink_new_chunk(sink, sink->chunk_size)) {
+		return false;
+	}
+
+	atom_sink_reset(sink);
+	return true;
+}
+
+/** Free all memory used by `sink`. */
+static inline void
+atom_sink_free(AtomSink* sink)
+{
+	for (AtomSinkChunk* c = sink->chunks; c;) {
+		AtomSinkChunk* const next = c->next;
+		free(c);
+		c = next;
+	}
+
+	memset(sink, 0, sizeof(AtomSink));
+}
+
+/** Return the current forged atom in `sink`, or NULL if nothing is written. */
+static inline LV2_Atom*
+atom_sink_atom(const AtomSink* sink)
+{
+	return (sink->size >= sizeof(LV2_Atom)) ? (LV2_Atom*)sink->buf : NULL;
+}
+
+/**
+   Finish the current message and start a new one after it.  Realtime safe.
+
+   The finished message stays valid until the sink is reset or freed.
+
+   @return The finished atom, or NULL if nothing was written or a write
+   failed, in which case the partial message is discarded.
+*/
+static inline LV2_Atom*
+atom_sink_finish(AtomSink* sink)
+{
+	LV2_Atom* const atom = sink->overflow ? NULL : atom_sink_atom(sink);
+	if (atom) {
+		const uint32_t size = lv2_atom_pad_size(sink->size);
+		const uint32_t room = sink->chunk->capacity - sink->offset;
+		sink->offset += size < room ? size : room;
+		sink->buf = (uint8_t*)sink->chunk->data + sink->offset;
+	}
+
+	sink->size     = 0;
+	sink->overflow = false;
+	return atom;
+}
+
+/**
+   Move the current message to a chunk with room for `size` more bytes.
+
+   @return True on success, or false if there is no such chunk and one could
+   not be allocated.
+*/
+static inline bool
+atom_sink_move(AtomSink* sink, uint32_t size)
+{
+	if (size > UINT32_MAX - sink->size) {
+		return false;
+	}
+
+	const uint32_t needed = sink->size + size;
+	AtomSinkChunk* chunk  = sink->chunk->next;
+	while (chunk && chunk->capacity < needed) {
+		chunk = chunk->next;
+	}
+
+	if (!chunk && !sink->fixed) {
+		// Grow geometrically so a growing message is not moved too often
+		const uint32_t current = sink->chunk->capacity;
+		const uint32_t doubled = current < UINT32_MAX / 2 ? current * 2 : 0;
+		chunk = atom_sink_new_chunk(sink, needed > doubled ? needed : doubled);
+	}
+
+	if (!chunk) {
+		return false;
+	}
+
+	memcpy(chunk->data, sink->buf, sink->size);
+	sink->chunk  = chunk;
+	sink->buf    = (uint8_t*)chunk->data;
+	sink->offset = 0;
+	return true;
+}
+
+/**
+   A forge sink that writes to an AtomSink.
+
+   The returned refs are offsets into the current message plus one, so they
+   stay valid if the message is moved to another chunk, and a failed write
+   returns 0.
+*/
+static inline LV2_Atom_Forge_Ref
 atom_sink(LV2_Atom_Forge_Sink_Handle handle, const void* buf, uint32_t size)
 {
-	LV2_Atom*      atom   = (LV2_Atom*)handle;
-	const uint32_t offset = lv2_atom_total_size(atom);
-	memcpy((char*)atom + offset, buf, size);
-	atom->size += size;
-	return offset;
+	AtomSink* const sink = (AtomSink*)handle;
+	if (sink->overflow ||
+	    (size > sink->chunk->capacity - sink->offset - sink->size &&
+	     !atom_sink_move(sink, size))) {
+		sink->overflow = true;
+		return 0;
+	}
+
+	const uint32_t offset = sink->size;
+	memcpy(sink->buf + offset, buf, size);
+	sink->size += size;
+	return (LV2_Atom_Forge_Ref)offset + 1;
 }
 
 /**
    Dereference counterpart to atom_sink().
 */
-static LV2_Atom*
+static inline LV2_Atom*
 atom_sink_deref(LV2_Atom_Forge_Sink_Handle handle, LV2_Atom_Forge_Ref ref)
 {
-	return (LV2_Atom*)((char*)handle + ref);
+	return (LV2_Atom*)(((AtomSink*)handle)->buf + ref - 1);
 }
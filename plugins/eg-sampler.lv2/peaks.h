@@ -90,12 +90,15 @@ peaks_map_uris(PeaksURIs* uris, LV2_URID_Map* map)
    Initialise peaks sender.  The new sender is inactive and will do nothing
    when `peaks_sender_send()` is called, until a transmission is started with
    `peaks_sender_start()`.
+
+   The URIDs are copied from `uris`, which must have been mapped with
+   `peaks_map_uris()`, so many senders can be initialised without mapping.
 */
 static inline PeaksSender*
-peaks_sender_init(PeaksSender* sender, LV2_URID_Map* map)
+peaks_sender_init(PeaksSender* sender, const PeaksURIs* uris)
 {
 	memset(sender, 0, sizeof(*sender));
-	peaks_map_uris(&sender->uris, map);
+	sender->uris = *uris;
 	return sender;
 }
 
@@ -128,6 +131,11 @@ peaks_sender_start(PeaksSender* sender,
    	   peaks:total 1024 ;
    	   peaks:magnitudes [ 0.2f, 0.3f, ... ] .
    ----
+
+   As many peaks as fit in the remaining space of `forge` are sent, and if
+   there is not enough space for any, nothing is written at all.
+
+   @return True if a message was written.
 */
 static inline bool
 peaks_sender_send(PeaksSender*    sender,
@@ -140,31 +148,39 @@ peaks_sender_send(PeaksSender*    sender,
 		return sender->sending = false;
 	}
 
-	// Start PeakUpdate object
-	lv2_atom_forge_frame_time(forge, offset);
+	/* Start PeakUpdate object.  If the header does not fit, roll back so no
+	   partial message is left in the output, and try again next time. */
+	const LV2_Atom_Forge_Checkpoint checkpoint =
+		lv2_atom_forge_checkpoint(forge);
 	LV2_Atom_Forge_Frame frame;
-	lv2_atom_forge_object(forge, &frame, 0, uris->peaks_PeakUpdate);
-
-	// eg:offset = OFFSET
-	lv2_atom_forge_key(forge, uris->peaks_offset);
-	lv2_atom_forge_int(forge, sender->current_offset);
-
-	// eg:total = TOTAL
-	lv2_atom_forge_key(forge, uris->peaks_total);
-	lv2_atom_forge_int(forge, sender->n_peaks);
-
-	// eg:magnitudes = Vector<Float>(PEAK, PEAK, ...)
-	lv2_atom_forge_key(forge, uris->peaks_magnitudes);
 	LV2_Atom_Forge_Frame vec_frame;
-	lv2_atom_forge_vector_head(
-		forge, &vec_frame, sizeof(float), uris->atom_Float);
+	if (!lv2_atom_forge_frame_time(forge, offset) ||
+	    !lv2_atom_forge_object(forge, &frame, 0, uris->peaks_PeakUpdate) ||
+	    // eg:offset = OFFSET
+	    !lv2_atom_forge_key(forge, uris->peaks_offset) ||
+	    !lv2_atom_forge_int(forge, sender->current_offset) ||
+	    // eg:total = TOTAL
+	    !lv2_atom_forge_key(forge, uris->peaks_total) ||
+	    !lv2_atom_forge_int(forge, sender->n_peaks) ||
+	    // eg:magnitudes = Vector<Float>(PEAK, PEAK, ...)
+	    !lv2_atom_forge_key(forge, uris->peaks_magnitudes) ||
+	    !lv2_atom_forge_vector_head(
+		    forge, &vec_frame, sizeof(float), uris->atom_Float)) {
+		lv2_atom_forge_rollback(forge, &checkpoint);
+		return false;
+	}
 
-	// Calculate how many peaks to send this update
+	// Calculate how many peaks to send this update, filling the space left
 	const int      chunk_size = MAX(1, sender->n_samples / sender->n_peaks);
 	const uint32_t space      = forge->size - forge->offset;
 	const uint32_t remaining  = sender->n_peaks - sender->current_offset;
 	const int      n_update   = MIN(remaining,
 	                                MIN(n_frames / 4, space / sizeof(float)));
+	if (n_update <= 0) {
+		// No room for any peaks, so don't bother sending an empty update
+		lv2_atom_forge_rollback(forge, &checkpoint);
+		return false;
+	}
 
 	// Calculate peak (maximum magnitude) for each chunk
 	for (int i = 0; i < n_update; ++i) {
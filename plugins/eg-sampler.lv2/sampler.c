@@ -19,6 +19,8 @@
 
 #include "atom_sink.h"
 #include "peaks.h"
+#include "state_file.h"
+#include "urid_cache.h"
 #include "uris.h"
 
 #include "lv2/atom/atom.h"
@@ -49,12 +51,43 @@ enum {
 };
 
 typedef struct {
-	SF_INFO  info;      // Info about sample from sndfile
-	float*   data;      // Sample data in float
-	char*    path;      // Path of file
-	uint32_t path_len;  // Length of path
+	SF_INFO      info;      // Info about sample from sndfile
+	float*       data;      // Sample data in float
+	char*        path;      // Path of file
+	uint32_t     path_len;  // Length of path
+	StateFileMap map;       // Saved state file that data is in, if any
 } Sample;
 
+/** Byte order mark for sample data files, which differs on big-endian hosts. */
+#define SAMPLE_FILE_BYTE_ORDER 0x01020304u
+
+/**
+   Header of a sample data file saved with the plugin state.
+
+   This is followed by the sample data as native floats, which is used
+   directly from the mapped file on restore.  A file written on a machine with
+   a different byte order is ignored, and the sample is loaded from the
+   original file instead.
+*/
+typedef struct {
+	char     magic[4];    // "EGSD"
+	uint32_t byte_order;  // SAMPLE_FILE_BYTE_ORDER
+	uint64_t frames;      // Number of frames of data
+} SampleFileHeader;
+
+/**
+   URIDs shared by all instances that use the same URID map.
+
+   The forge and logger here have only their URIDs set, instances copy them
+   to initialise their own without mapping anything.
+*/
+typedef struct {
+	SamplerURIs    uris;
+	PeaksURIs      peaks_uris;
+	LV2_Atom_Forge forge;
+	LV2_Log_Logger logger;
+} SamplerURIDs;
+
 typedef struct {
 	// Features
 	LV2_URID_Map*        map;
@@ -70,9 +103,15 @@ typedef struct {
 	LV2_Atom_Forge_Frame notify_frame;  ///< Cached for worker replies
 	LV2_Atom_Forge       forge;         ///< Forge for writing atoms in run thread
 	PeaksSender          psend;         ///< Audio peaks sender
+	AtomSink             restore_sink;  ///< Buffer for messages from restore()
+
+	// Messages logged in the audio thread, written later by the worker
+	LV2_Log_Deferred         rt_log;
+	LV2_Log_Deferred_Message rt_log_messages[16];
 
 	// URIs
-	SamplerURIs uris;
+	const SamplerURIDs* urids;  ///< Shared URIDs from the URID cache
+	const SamplerURIs*  uris;   ///< Sampler URIDs in urids
 
 	// Playback state
 	Sample*    sample;
@@ -145,13 +184,59 @@ load_sample(LV2_Log_Logger* logger, const char* path)
 	return sample;
 }
 
+/**
+   Make a sample from sample data saved in a state file.
+
+   The sample uses the data directly from the mapped file, so unlike
+   load_sample(), this does not read or decode anything, and takes no time
+   however large the sample is.  On success, the sample takes ownership of
+   `map`, otherwise it is unmapped.
+*/
+static Sample*
+map_sample(LV2_Log_Logger* logger, StateFileMap* map, const char* path)
+{
+	const SampleFileHeader* const header = (const SampleFileHeader*)map->data;
+	const size_t                  size   = map->size - sizeof(SampleFileHeader);
+	if (map->size < sizeof(SampleFileHeader) ||
+	    memcmp(header->magic, "EGSD", 4) ||
+	    header->byte_order != SAMPLE_FILE_BYTE_ORDER ||
+	    !header->frames || size / sizeof(float) < header->frames) {
+		lv2_log_warning(logger, "Ignoring invalid sample data\n");
+		state_file_unmap(map);
+		return NULL;
+	}
+
+	lv2_log_trace(logger, "Mapped saved data for %s\n", path);
+
+	const size_t  path_len = strlen(path);
+	Sample* const sample   = (Sample*)calloc(1, sizeof(Sample));
+	if (!sample || !(sample->path = (char*)malloc(path_len + 1))) {
+		free(sample);
+		state_file_unmap(map);
+		return NULL;
+	}
+
+	sample->info.frames   = (sf_count_t)header->frames;
+	sample->info.channels = 1;
+	sample->data          = (float*)((uint8_t*)map->data + sizeof(*header));
+	sample->path_len      = (uint32_t)path_len;
+	sample->map           = *map;
+	memcpy(sample->path, path, path_len + 1);
+
+	return sample;
+}
+
 static void
 free_sample(Sampler* self, Sample* sample)
 {
 	if (sample) {
 		lv2_log_trace(&self->logger, "Freeing %s\n", sample->path);
 		free(sample->path);
-		free(sample->data);
+		if (sample->map.data) {
+			state_file_unmap(&sample->map);
+		} else {
+			free(sample->data);
+		}
 		free(sample);
 	}
 }
@@ -172,14 +257,21 @@ work(LV2_Handle                  instance,
 {
 	Sampler*        self = (Sampler*)instance;
 	const LV2_Atom* atom = (const LV2_Atom*)data;
-	if (atom->type == self->uris.eg_freeSample) {
+	if (atom->type == self->uris->eg_flushLog) {
+		// Write messages logged in the audio thread
+		lv2_log_deferred_flush(&self->rt_log, &self->logger);
+	} else if (atom->type == self->uris->eg_freeSample) {
 		// Free old sample
 		const SampleMessage* msg = (const SampleMessage*)data;
 		free_sample(self, msg->sample);
+	} else if (atom->type == self->uris->eg_applySample) {
+		// Send sample made by restore() to run() to be applied
+		const SampleMessage* msg = (const SampleMessage*)data;
+		respond(handle, sizeof(msg->sample), &msg->sample);
 	} else if (atom->type == self->forge.Object) {
 		// Handle set message (load sample).
 		const LV2_Atom_Object* obj  = (const LV2_Atom_Object*)data;
-		const char*            path = read_set_file(&self->uris, obj);
+		const char*            path = read_set_file(self->uris, obj);
 		if (!path) {
 			lv2_log_error(&self->logger, "Malformed set file request\n");
 			return LV2_WORKER_ERR_UNKNOWN;
@@ -216,13 +308,13 @@ work_response(LV2_Handle  instance,
 	self->sample = *(Sample*const*)data;
 
 	// Schedule work to free the old sample
-	SampleMessage msg = { { sizeof(Sample*), self->uris.eg_freeSample },
+	SampleMessage msg = { { sizeof(Sample*), self->uris->eg_freeSample },
 	                      old_sample };
 	self->schedule->schedule_work(self->schedule->handle, sizeof(msg), &msg);
 
 	// Send a notification that we're using a new sample
 	lv2_atom_forge_frame_time(&self->forge, self->frame_offset);
-	write_set_file(&self->forge, &self->uris,
+	write_set_file(&self->forge, self->uris,
 		       new_sample->path,
 		       new_sample->path_len);
 
@@ -250,6 +342,23 @@ connect_port(LV2_Handle instance,
 	}
 }
 
+/**
+   Map all the URIDs shared between instances.
+
+   This is called by the URID cache when the first instance is instantiated
+   with a given map.
+*/
+static void
+map_shared_urids(LV2_URID_Map* map, void* urids)
+{
+	SamplerURIDs* const shared = (SamplerURIDs*)urids;
+
+	map_sampler_uris(map, &shared->uris);
+	peaks_map_uris(&shared->peaks_uris, map);
+	lv2_atom_forge_init(&shared->forge, map);
+	lv2_log_logger_set_map(&shared->logger, map);
+}
+
 static LV2_Handle
 instantiate(const LV2_Descriptor*     descriptor,
             double                    rate,
@@ -269,17 +378,39 @@ instantiate(const LV2_Descriptor*     descriptor,
 		LV2_URID__map,        &self->map,        true,
 		LV2_WORKER__schedule, &self->schedule,   true,
 		NULL);
-	lv2_log_logger_set_map(&self->logger, self->map);
 	if (missing) {
+		lv2_log_logger_set_map(&self->logger, self->map);
 		lv2_log_error(&self->logger, "Missing feature <%s>\n", missing);
 		free(self);
 		return NULL;
 	}
 
-	// Map URIs and initialise forge
-	map_sampler_uris(self->map, &self->uris);
-	lv2_atom_forge_init(&self->forge, self->map);
-	peaks_sender_init(&self->psend, self->map);
+	// Get URIDs shared with other instances, mapping them only if necessary
+	self->urids = (const SamplerURIDs*)urid_cache_acquire(
+		self->map, sizeof(SamplerURIDs), map_shared_urids);
+	if (!self->urids) {
+		free(self);
+		return NULL;
+	}
+
+	// Initialise utilities by copying the shared URIDs
+	LV2_Log_Log* const log = self->logger.log;
+	self->uris       = &self->urids->uris;
+	self->forge      = self->urids->forge;
+	self->logger     = self->urids->logger;
+	self->logger.log = log;
+	peaks_sender_init(&self->psend, &self->urids->peaks_uris);
+
+	// Set up a deferred logger so the audio thread never calls the host log
+	lv2_log_deferred_init(
+		&self->rt_log, &self->logger, self->rt_log_messages, 16);
+
+	// Allocate a buffer for restore() which is large enough for most paths
+	if (!atom_sink_init(&self->restore_sink, 1024)) {
+		urid_cache_release(self->urids);
+		free(self);
+		return NULL;
+	}
 
 	self->gain = 1.0;
 
@@ -290,7 +421,10 @@ static void
 cleanup(LV2_Handle instance)
 {
 	Sampler* self = (Sampler*)instance;
+	lv2_log_deferred_flush(&self->rt_log, &self->logger);
 	free_sample(self, self->sample);
+	atom_sink_free(&self->restore_sink);
+	urid_cache_release(self->urids);
 	free(self);
 }
 
@@ -316,10 +450,18 @@ deactivate(LV2_Handle instance)
    playback, a sample change, or responding to requests from the UI.
 */
 static void
-handle_event(Sampler* self, LV2_Atom_Event* ev)
+handle_event(void* instance, uint32_t frame, const LV2_Atom_Event* ev)
 {
-	SamplerURIs* uris       = &self->uris;
-	PeaksURIs*   peaks_uris = &self->psend.uris;
+	Sampler*           self       = (Sampler*)instance;
+	const SamplerURIs* uris       = self->uris;
+	PeaksURIs*         peaks_uris = &self->psend.uris;
+
+	/* Update current frame offset to this event's time.  This is stored in
+	   the instance because it is used for sychronous worker event
+	   execution.  This allows a sample load event to be executed with
+	   sample accuracy when running in a non-realtime context (such as
+	   exporting a session). */
+	self->frame_offset = frame;
 
 	if (ev->body.type == uris->midi_Event) {
 		const uint8_t* const msg = (const uint8_t*)(ev + 1);
@@ -342,17 +484,20 @@ handle_event(Sampler* self, LV2_Atom_Event* ev)
 			                    uris->patch_value,    &value,
 			                    0);
 			if (!property) {
-				lv2_log_error(&self->logger, "Set message with no property\n");
+				lv2_log_deferred_error(&self->rt_log,
+				                       "Set message with no property\n");
 				return;
 			} else if (property->type != uris->atom_URID) {
-				lv2_log_error(&self->logger, "Set property is not a URID\n");
+				lv2_log_deferred_error(&self->rt_log,
+				                       "Set property is not a URID\n");
 				return;
 			}
 
 			const uint32_t key = ((const LV2_Atom_URID*)property)->body;
 			if (key == uris->eg_sample) {
 				// Sample change, send it to the worker.
-				lv2_log_trace(&self->logger, "Scheduling sample change\n");
+				lv2_log_deferred_trace(&self->rt_log,
+				                       "Scheduling sample change\n");
 				self->schedule->schedule_work(self->schedule->handle,
 				                              lv2_atom_total_size(&ev->body),
 				                              &ev->body);
@@ -378,17 +523,19 @@ handle_event(Sampler* self, LV2_Atom_Event* ev)
 			} else {
 				// Received a get message, emit our state (probably to UI)
 				lv2_atom_forge_frame_time(&self->forge, self->frame_offset);
-				write_set_file(&self->forge, &self->uris,
+				write_set_file(&self->forge, self->uris,
 				               self->sample->path,
 				               self->sample->path_len);
 			}
 		} else {
-			lv2_log_trace(&self->logger,
-			              "Unknown object type %d\n", obj->body.otype);
+			lv2_log_deferred_trace(&self->rt_log,
+			                       "Unknown object type %u\n",
+			                       obj->body.otype);
 		}
 	} else {
-		lv2_log_trace(&self->logger,
-		              "Unknown event type %d\n", ev->body.type);
+		lv2_log_deferred_trace(&self->rt_log,
+		                       "Unknown event type %u\n",
+		                       ev->body.type);
 	}
 
 }
@@ -397,9 +544,10 @@ handle_event(Sampler* self, LV2_Atom_Event* ev)
    Output audio for a slice of the current cycle.
 */
 static void
-render(Sampler* self, uint32_t start, uint32_t end)
+render(void* instance, uint32_t start, uint32_t end)
 {
-	float* output = self->output_port;
+	Sampler* self   = (Sampler*)instance;
+	float*   output = self->output_port;
 
 	if (self->play && self->sample) {
 		// Start/continue writing sample to output
@@ -435,34 +583,84 @@ run(LV2_Handle instance, uint32_t sample_count)
 	// Send update to UI if sample has changed due to state restore
 	if (self->sample_changed) {
 		lv2_atom_forge_frame_time(&self->forge, 0);
-		write_set_file(&self->forge, &self->uris,
+		write_set_file(&self->forge, self->uris,
 		               self->sample->path,
 		               self->sample->path_len);
 		self->sample_changed = false;
 	}
 
-	// Iterate over incoming events, emitting audio along the way
+	/* Iterate over incoming events, emitting audio along the way.  This calls
+	   render() for each span between events, and handle_event() at the time
+	   of each event, which also updates self->frame_offset. */
 	self->frame_offset = 0;
-	LV2_ATOM_SEQUENCE_FOREACH(self->control_port, ev) {
-		// Render output up to the time of this event
-		render(self, self->frame_offset, ev->time.frames);
-
-		/* Update current frame offset to this event's time.  This is stored in
-		   the instance because it is used for sychronous worker event
-		   execution.  This allows a sample load event to be executed with
-		   sample accuracy when running in a non-realtime context (such as
-		   exporting a session). */
-		self->frame_offset = ev->time.frames;
-
-		// Process this event
-		handle_event(self, ev);
-	}
+	lv2_atom_sequence_split(self->control_port, sample_count, 0,
+	                        render, handle_event, self);
 
 	// Use available space after any emitted events to send peaks
 	peaks_sender_send(&self->psend, &self->forge, sample_count, self->frame_offset);
 
-	// Render output for the rest of the cycle past the last event
-	render(self, self->frame_offset, sample_count);
+	// Schedule writing of any messages logged in this cycle
+	if (lv2_log_deferred_poll(&self->rt_log)) {
+		const LV2_Atom msg = { 0, self->uris->eg_flushLog };
+		self->schedule->schedule_work(self->schedule->handle, sizeof(msg), &msg);
+	}
+}
+
+/**
+   Save the sample data to a new file and store eg:sampleData = its path.
+
+   The data is written straight from the sample to the file, so the host
+   never holds a copy of it, and restore() can map the file to use it
+   directly, without loading the original file at all.  This also makes the
+   state self-contained, so it still works if the original file is moved.
+
+   Sample data is never modified, so if the sample was mapped from the data
+   file of the state being saved, that file is already correct and is not
+   written again.
+*/
+static LV2_State_Status
+save_sample_data(Sampler*                   self,
+                 const LV2_State_Make_Path* make_path,
+                 const LV2_State_Map_Path*  map_path,
+                 LV2_State_Store_Function   store,
+                 LV2_State_Handle           handle)
+{
+	const Sample* const    sample = self->sample;
+	const SampleFileHeader header = { { 'E', 'G', 'S', 'D' },
+	                                  SAMPLE_FILE_BYTE_ORDER,
+	                                  (uint64_t)sample->info.frames };
+
+	if (sample->map.path) {
+		char* const path = make_path->path(make_path->handle, "sample.data");
+		if (path && !strcmp(path, sample->map.path)) {
+			lv2_log_trace(&self->logger, "Sample data already saved\n");
+			free(path);
+			return state_file_store(map_path,
+			                        store,
+			                        handle,
+			                        self->uris->eg_sampleData,
+			                        self->uris->atom_Path,
+			                        sample->map.path);
+		}
+		free(path);
+	}
+
+	StateFileWriter writer;
+	if (!state_file_writer_open(&writer, make_path, "sample.data")) {
+		return LV2_STATE_ERR_UNKNOWN;
+	}
+
+	state_file_writer_write(&writer, &header, sizeof(header));
+	state_file_writer_write(&writer,
+	                        sample->data,
+	                        sizeof(float) * (size_t)sample->info.frames);
+
+	return state_file_writer_store(&writer,
+	                               map_path,
+	                               store,
+	                               handle,
+	                               self->uris->eg_sampleData,
+	                               self->uris->atom_Path);
 }
 
 static LV2_State_Status
@@ -485,16 +683,28 @@ save(LV2_Handle                instance,
 
 	// Map absolute sample path to an abstract state path
 	char* apath = map_path->abstract_path(map_path->handle, self->sample->path);
+	if (!apath) {
+		return LV2_STATE_ERR_UNKNOWN;
+	}
 
 	// Store eg:sample = abstract path
 	store(handle,
-	      self->uris.eg_sample,
+	      self->uris->eg_sample,
 	      apath,
 	      strlen(apath) + 1,
-	      self->uris.atom_Path,
+	      self->uris->atom_Path,
 	      LV2_STATE_IS_POD | LV2_STATE_IS_PORTABLE);
 
 	free(apath);
+
+	// Save the sample data in a file as well, if the host supports it
+	const LV2_State_Make_Path* make_path = (const LV2_State_Make_Path*)
+		lv2_features_data(features, LV2_STATE__makePath);
+	if (make_path &&
+	    save_sample_data(self, make_path, map_path, store, handle)) {
+		lv2_log_warning(&self->logger, "Failed to save sample data\n");
+	}
+
 	return LV2_STATE_SUCCESS;
 }
 
@@ -524,12 +734,12 @@ restore(LV2_Handle                  instance,
 	size_t      size;
 	uint32_t    type;
 	uint32_t    valflags;
-	const void* value = retrieve(handle, self->uris.eg_sample,
+	const void* value = retrieve(handle, self->uris->eg_sample,
 	                             &size, &type, &valflags);
 	if (!value) {
 		lv2_log_error(&self->logger, "Missing eg:sample\n");
 		return LV2_STATE_ERR_NO_PROPERTY;
-	} else if (type != self->uris.atom_Path) {
+	} else if (type != self->uris->atom_Path) {
 		lv2_log_error(&self->logger, "Non-path eg:sample\n");
 		return LV2_STATE_ERR_BAD_TYPE;
 	}
@@ -538,28 +748,59 @@ restore(LV2_Handle                  instance,
 	const char* apath = (const char*)value;
 	char*       path  = paths->absolute_path(paths->handle, apath);
 
+	// Map saved sample data if there is any, which is much faster than loading
+	Sample*      sample = NULL;
+	StateFileMap map;
+	if (!state_file_retrieve(&map, paths, retrieve, handle,
+	                         self->uris->eg_sampleData,
+	                         self->uris->atom_Path)) {
+		sample = map_sample(&self->logger, &map, path);
+	}
+
 	// Replace current sample with the new one
 	if (!self->activated || !schedule) {
 		// No scheduling available, load sample immediately
 		lv2_log_trace(&self->logger, "Synchronous restore\n");
-		Sample* sample = load_sample(&self->logger, path);
+		if (!sample) {
+			sample = load_sample(&self->logger, path);
+		}
 		if (sample) {
 			free_sample(self, self->sample);
 			self->sample         = sample;
 			self->sample_changed = true;
 		}
+	} else if (sample) {
+		// Send the mapped sample through the worker to be applied in run()
+		lv2_log_trace(&self->logger, "Scheduling mapped sample\n");
+		const SampleMessage msg = {
+			{ sizeof(Sample*), self->uris->eg_applySample }, sample
+		};
+		if (schedule->schedule_work(schedule->handle, sizeof(msg), &msg)) {
+			free_sample(self, sample);
+			free(path);
+			return LV2_STATE_ERR_UNKNOWN;
+		}
 	} else {
-		// Schedule sample to be loaded by the provided worker
+		/* Schedule sample to be loaded by the provided worker.  The message
+		   is forged into a buffer which is grown to fit if necessary, since
+		   restore() is not called in the audio thread. */
 		lv2_log_trace(&self->logger, "Scheduling restore\n");
-		LV2_Atom_Forge forge;
-		LV2_Atom*      buf = (LV2_Atom*)calloc(1, strlen(path) + 128);
-		lv2_atom_forge_init(&forge, self->map);
-		lv2_atom_forge_set_sink(&forge, atom_sink, atom_sink_deref, buf);
-		write_set_file(&forge, &self->uris, path, strlen(path));
-
-		const uint32_t msg_size = lv2_atom_pad_size(buf->size);
-		schedule->schedule_work(self->schedule->handle, msg_size, buf + 1);
-		free(buf);
+		LV2_Atom_Forge forge = self->urids->forge;
+		AtomSink*      sink  = &self->restore_sink;
+		atom_sink_reset(sink);
+		lv2_atom_forge_set_sink(&forge, atom_sink, atom_sink_deref, sink);
+		write_set_file(&forge, self->uris, path, strlen(path));
+
+		const LV2_Atom* msg = atom_sink_atom(sink);
+		if (sink->overflow || !msg) {
+			lv2_log_error(&self->logger, "Failed to allocate message\n");
+			free(path);
+			return LV2_STATE_ERR_UNKNOWN;
+		}
+
+		schedule->schedule_work(schedule->handle,
+		                        lv2_atom_total_size(msg),
+		                        msg);
 	}
 
 	free(path);
@@ -0,0 +1,329 @@
+/*
+  LV2 state file utilities
+  Copyright 2026 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef STATE_FILE_H
+#define STATE_FILE_H
+
+/**
+   Utilities for saving large values in files rather than in memory.
+
+   Values passed to the host's store() function are held in memory by the
+   host until it writes the session, which is fine for small values, but not
+   for large ones like recorded audio.  These utilities instead write a large
+   value directly to a file made with state:makePath, in as many chunks as the
+   plugin likes, and store only the path of the file.  On restore, the file
+   is mapped into memory rather than read, so the data is only loaded by the
+   operating system as it is used.
+
+   A file is first written to a temporary path, then renamed when it is
+   complete, so a failed save never leaves a partial file behind, and a file
+   that is currently mapped is never overwritten.
+
+   None of these functions are real-time safe.
+*/
+
+#include "lv2/state/state.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+/** A state file being written. */
+typedef struct {
+	FILE* file;      ///< Temporary file being written
+	char* path;      ///< Absolute path of the complete file
+	char* tmp_path;  ///< Absolute path of the temporary file
+	bool  error;     ///< True if a write failed
+} StateFileWriter;
+
+/** A state file mapped into memory. */
+typedef struct {
+	void*  data;  ///< Contents of the file (read only), or NULL
+	size_t size;  ///< Size of the file in bytes
+	char*  path;  ///< Absolute path of the file
+} StateFileMap;
+
+/**
+   Store the absolute `path` of a state file as the value of `key`.
+
+   The path is stored as an abstract path made with `map_path`, so the state
+   remains valid if the host moves it.
+*/
+static inline LV2_State_Status
+state_file_store(const LV2_State_Map_Path* map_path,
+                 LV2_State_Store_Function  store,
+                 LV2_State_Handle          handle,
+                 uint32_t                  key,
+                 uint32_t                  atom_Path,
+                 const char*               path)
+{
+	char* const apath = map_path->abstract_path(map_path->handle, path);
+	if (!apath) {
+		return LV2_STATE_ERR_UNKNOWN;
+	}
+
+	const LV2_State_Status st = store(handle,
+	                                  key,
+	                                  apath,
+	                                  strlen(apath) + 1,
+	                                  atom_Path,
+	                                  LV2_STATE_IS_POD | LV2_STATE_IS_PORTABLE);
+
+	free(apath);
+	return st;
+}
+
+/** Close the file and free everything in `writer`, removing the file. */
+static inline void
+state_file_writer_abort(StateFileWriter* writer)
+{
+	if (writer->file) {
+		fclose(writer->file);
+		remove(writer->tmp_path);
+	}
+
+	free(writer->tmp_path);
+	free(writer->path);
+	memset(writer, 0, sizeof(StateFileWriter));
+}
+
+/**
+   Create a new state file called `name` and open it for writing.
+
+   This must only be called in save(), with the state:makePath feature passed
+   to it.
+
+   @return True on success, in which case the file must be finished with
+   state_file_writer_store() or state_file_writer_abort().
+*/
+static inline bool
+state_file_writer_open(StateFileWriter*           writer,
+                       const LV2_State_Make_Path* make_path,
+                       const char*                name)
+{
+	memset(writer, 0, sizeof(StateFileWriter));
+	if (!(writer->path = make_path->path(make_path->handle, name))) {
+		return false;
+	}
+
+	const size_t path_len = strlen(writer->path);
+	if ((writer->tmp_path = (char*)malloc(path_len + 5))) {
+		memcpy(writer->tmp_path, writer->path, path_len);
+		memcpy(writer->tmp_path + path_len, ".tmp", 5);
+		writer->file = fopen(writer->tmp_path, "wb");
+	}
+
+	if (!writer->file) {
+		state_file_writer_abort(writer);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+   Write a chunk of data to the end of the file.
+
+   Errors are remembered, so many chunks can be written without checking,
+   and state_file_writer_store() will fail if any of them failed.
+
+   @return True on success.
+*/
+static inline bool
+state_file_writer_write(StateFileWriter* writer,
+                        const void*      data,
+                        size_t           size)
+{
+	if (!writer->error && fwrite(data, 1, size, writer->file) != size) {
+		writer->error = true;
+	}
+
+	return !writer->error;
+}
+
+/**
+   Finish writing the file and store its path as the value of `key`.
+
+   The path is stored with state_file_store().  Everything in `writer` is
+   freed, and if anything failed, the file is removed.
+*/
+static inline LV2_State_Status
+state_file_writer_store(StateFileWriter*          writer,
+                        const LV2_State_Map_Path* map_path,
+                        LV2_State_Store_Function  store,
+                        LV2_State_Handle          handle,
+                        uint32_t                  key,
+                        uint32_t                  atom_Path)
+{
+	FILE* const file = writer->file;
+	writer->file = NULL;
+	if (fclose(file) || writer->error) {
+		remove(writer->tmp_path);
+		state_file_writer_abort(writer);
+		return LV2_STATE_ERR_UNKNOWN;
+	}
+
+#ifdef _WIN32
+	remove(writer->path);  // Windows can not rename over an existing file
+#endif
+	if (rename(writer->tmp_path, writer->path)) {
+		remove(writer->tmp_path);
+		state_file_writer_abort(writer);
+		return LV2_STATE_ERR_UNKNOWN;
+	}
+
+	const LV2_State_Status st = state_file_store(
+		map_path, store, handle, key, atom_Path, writer->path);
+
+	state_file_writer_abort(writer);
+	return st;
+}
+
+/** Unmap a file mapped with state_file_map(). */
+static inline void
+state_file_unmap(StateFileMap* map)
+{
+	if (map->data) {
+#ifdef _WIN32
+		UnmapViewOfFile(map->data);
+#else
+		munmap(map->data, map->size);
+#endif
+		free(map->path);
+		map->data = NULL;
+		map->size = 0;
+		map->path = NULL;
+	}
+}
+
+/**
+   Map the file at `path` into memory for reading.
+
+   @return True on success, in which case the file must be unmapped with
+   state_file_unmap().
+*/
+static inline bool
+state_file_map(StateFileMap* map, const char* path)
+{
+	map->data = NULL;
+	map->size = 0;
+	map->path = NULL;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path,
+	                          GENERIC_READ,
+	                          FILE_SHARE_READ,
+	                          NULL,
+	                          OPEN_EXISTING,
+	                          FILE_ATTRIBUTE_NORMAL,
+	                          NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	HANDLE        mapping = NULL;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	}
+
+	CloseHandle(file);
+	if (mapping) {
+		if ((map->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0))) {
+			map->size = (size_t)size.QuadPart;
+		}
+		CloseHandle(mapping);
+	}
+#else
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat st;
+	if (!fstat(fd, &st) && st.st_size > 0) {
+		void* const data = mmap(
+			NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED) {
+			map->data = data;
+			map->size = (size_t)st.st_size;
+		}
+	}
+
+	close(fd);
+#endif
+
+	if (map->data) {
+		// Copy the path only once mapped, so there is nothing to free on failure
+		const size_t path_len = strlen(path);
+		if (!(map->path = (char*)malloc(path_len + 1))) {
+			state_file_unmap(map);
+			return false;
+		}
+
+		memcpy(map->path, path, path_len + 1);
+	}
+
+	return map->data != NULL;
+}
+
+/**
+   Retrieve the path stored as the value of `key` and map the file.
+
+   @return LV2_STATE_SUCCESS, in which case the file must be unmapped with
+   state_file_unmap(), or an error if there is no such path or the file
+   could not be mapped.
+*/
+static inline LV2_State_Status
+state_file_retrieve(StateFileMap*               map,
+                    const LV2_State_Map_Path*   map_path,
+                    LV2_State_Retrieve_Function retrieve,
+                    LV2_State_Handle            handle,
+                    uint32_t                    key,
+                    uint32_t                    atom_Path)
+{
+	size_t      size     = 0;
+	uint32_t    type     = 0;
+	uint32_t    valflags = 0;
+	const void* value    = retrieve(handle, key, &size, &type, &valflags);
+	if (!value) {
+		return LV2_STATE_ERR_NO_PROPERTY;
+	} else if (type != atom_Path) {
+		return LV2_STATE_ERR_BAD_TYPE;
+	}
+
+	char* const path = map_path->absolute_path(map_path->handle,
+	                                           (const char*)value);
+	const bool  success = path && state_file_map(map, path);
+
+	free(path);
+	return success ? LV2_STATE_SUCCESS : LV2_STATE_ERR_UNKNOWN;
+}
+
+#endif  /* STATE_FILE_H */
@@ -0,0 +1,153 @@
+/*
+  LV2 Sampler Example Plugin
+  Copyright 2026 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef URID_CACHE_H
+#define URID_CACHE_H
+
+/**
+   A process-wide cache of URIDs shared between plugin instances.
+
+   Every instance that is given the same URID map gets the same URIDs, so
+   there is no need for each to map them again.  This cache maps a set of
+   URIDs the first time it is requested for a map, and subsequent instances
+   share the result by pointer.
+
+   Entries are reference counted and freed when the last instance that uses
+   them is cleaned up.  The cache is protected by a lock, since LV2 allows
+   instantiate() and cleanup() to be called concurrently for different
+   instances.  This is never used in the audio thread.
+*/
+
+#include "lv2/urid/urid.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#    include <windows.h>
+#else
+#    include <pthread.h>
+#endif
+
+/**
+   Function to map a set of URIDs into `urids`, which is zero-initialised.
+*/
+typedef void (*URIDCacheMapFunc)(LV2_URID_Map* map, void* urids);
+
+typedef struct URIDCacheEntryImpl {
+	struct URIDCacheEntryImpl* next;
+	LV2_URID_Map*              map;       ///< Map used to map URIDs
+	URIDCacheMapFunc           map_func;  ///< Function that mapped URIDs
+	unsigned                   refs;      ///< Number of users
+	uint64_t                   urids[];   ///< Mapped URIDs
+} URIDCacheEntry;
+
+static URIDCacheEntry* urid_cache = NULL;
+
+#ifdef _WIN32
+static SRWLOCK urid_cache_mutex = SRWLOCK_INIT;
+#else
+static pthread_mutex_t urid_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static inline void
+urid_cache_lock(void)
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive(&urid_cache_mutex);
+#else
+	pthread_mutex_lock(&urid_cache_mutex);
+#endif
+}
+
+static inline void
+urid_cache_unlock(void)
+{
+#ifdef _WIN32
+	ReleaseSRWLockExclusive(&urid_cache_mutex);
+#else
+	pthread_mutex_unlock(&urid_cache_mutex);
+#endif
+}
+
+/**
+   Get the URIDs for `map`, mapping them with `map_func` if necessary.
+
+   The same `size` and `map_func` must be given for every request for the same
+   set of URIDs.  Different sets (with a different `map_func`) are cached
+   separately.
+
+   @return A pointer to URIDs shared with other users of the same map, which
+   must be released with urid_cache_release(), or NULL on allocation failure.
+*/
+static inline const void*
+urid_cache_acquire(LV2_URID_Map* map, size_t size, URIDCacheMapFunc map_func)
+{
+	urid_cache_lock();
+
+	URIDCacheEntry* entry = urid_cache;
+	while (entry && (entry->map != map || entry->map_func != map_func)) {
+		entry = entry->next;
+	}
+
+	if (!entry) {
+		// Not cached yet, map URIDs and add a new entry
+		entry = (URIDCacheEntry*)calloc(1, sizeof(URIDCacheEntry) + size);
+		if (entry) {
+			entry->next     = urid_cache;
+			entry->map      = map;
+			entry->map_func = map_func;
+			map_func(map, entry->urids);
+			urid_cache = entry;
+		}
+	}
+
+	if (entry) {
+		++entry->refs;
+	}
+
+	urid_cache_unlock();
+
+	return entry ? entry->urids : NULL;
+}
+
+/**
+   Release URIDs returned by urid_cache_acquire().
+
+   The URIDs are freed if this was the last user.
+*/
+static inline void
+urid_cache_release(const void* urids)
+{
+	urid_cache_lock();
+
+	for (URIDCacheEntry** e = &urid_cache; *e; e = &(*e)->next) {
+		URIDCacheEntry* const entry = *e;
+		if ((const void*)entry->urids == urids) {
+			if (--entry->refs == 0) {
+				*e = entry->next;
+				free(entry);
+			}
+			break;
+		}
+	}
+
+	urid_cache_unlock();
+}
+
+#endif  /* URID_CACHE_H */
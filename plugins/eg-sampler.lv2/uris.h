@@ -28,8 +28,10 @@
 
 #define EG_SAMPLER_URI          "http://lv2plug.in/plugins/eg-sampler"
 #define EG_SAMPLER__applySample EG_SAMPLER_URI "#applySample"
+#define EG_SAMPLER__flushLog    EG_SAMPLER_URI "#flushLog"
 #define EG_SAMPLER__freeSample  EG_SAMPLER_URI "#freeSample"
 #define EG_SAMPLER__sample      EG_SAMPLER_URI "#sample"
+#define EG_SAMPLER__sampleData  EG_SAMPLER_URI "#sampleData"
 
 typedef struct {
 	LV2_URID atom_Float;
@@ -39,8 +41,10 @@ typedef struct {
 	LV2_URID atom_URID;
 	LV2_URID atom_eventTransfer;
 	LV2_URID eg_applySample;
+	LV2_URID eg_flushLog;
 	LV2_URID eg_freeSample;
 	LV2_URID eg_sample;
+	LV2_URID eg_sampleData;
 	LV2_URID midi_Event;
 	LV2_URID param_gain;
 	LV2_URID patch_Get;
@@ -60,8 +64,10 @@ map_sampler_uris(LV2_URID_Map* map, SamplerURIs* uris)
 	uris->atom_URID          = map->map(map->handle, LV2_ATOM__URID);
 	uris->atom_eventTransfer = map->map(map->handle, LV2_ATOM__eventTransfer);
 	uris->eg_applySample     = map->map(map->handle, EG_SAMPLER__applySample);
+	uris->eg_flushLog        = map->map(map->handle, EG_SAMPLER__flushLog);
 	uris->eg_freeSample      = map->map(map->handle, EG_SAMPLER__freeSample);
 	uris->eg_sample          = map->map(map->handle, EG_SAMPLER__sample);
+	uris->eg_sampleData      = map->map(map->handle, EG_SAMPLER__sampleData);
 	uris->midi_Event         = map->map(map->handle, LV2_MIDI__MidiEvent);
 	uris->param_gain         = map->map(map->handle, LV2_PARAMETERS__gain);
 	uris->patch_Get          = map->map(map->handle, LV2_PATCH__Get);
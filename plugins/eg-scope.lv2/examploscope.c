@@ -33,6 +33,22 @@
 #include <stdlib.h>
 #include <string.h>
 
+/**
+   ==== UI State ====
+
+   Settings sent by the UI are decoded into this plain struct, using a schema
+   built once when the plugin is instantiated.
+*/
+typedef struct {
+	int32_t spp;
+	float   amp;
+} UIState;
+
+enum {
+	UI_STATE_SPP = 1u << 0,
+	UI_STATE_AMP = 1u << 1
+};
+
 /**
    ==== Private Plugin Instance Structure ====
 
@@ -66,6 +82,9 @@ typedef struct {
 	bool     send_settings_to_ui;
 	float    ui_amp;
 	uint32_t ui_spp;
+
+	// Schema for decoding UI state messages
+	LV2_Atom_Object_Field ui_state_fields[3];
 } EgScope;
 
 /** ==== Port Indices ==== */
@@ -130,6 +149,16 @@ instantiate(const LV2_Descriptor*     descriptor,
 	map_sco_uris(self->map, &self->uris);
 	lv2_atom_forge_init(&self->forge, self->map);
 
+	// Build schema for decoding UI state messages
+	const LV2_Atom_Object_Field ui_state_fields[] = {
+		LV2_ATOM_OBJECT_FIELD(
+			self->uris.ui_spp, self->uris.atom_Int, UIState, spp),
+		LV2_ATOM_OBJECT_FIELD(
+			self->uris.ui_amp, self->uris.atom_Float, UIState, amp),
+		LV2_ATOM_OBJECT_FIELD_END
+	};
+	memcpy(self->ui_state_fields, ui_state_fields, sizeof(ui_state_fields));
+
 	return (LV2_Handle)self;
 }
 
@@ -179,31 +208,39 @@ connect_port(LV2_Handle handle,
    where the value of the `sco:audioData` property, `[ 0.0, 0.0, ... ]`, is a
    http://lv2plug.in/ns/ext/atom#Vector[Vector] of
    http://lv2plug.in/ns/ext/atom#Float[Float].
+
+   The message is written in full or not at all: a checkpoint is taken before
+   writing, and if any part of the message does not fit, the forge is rolled
+   back to it so no partial message is sent.
 */
-static void
+static bool
 tx_rawaudio(LV2_Atom_Forge* forge,
             ScoLV2URIs*     uris,
             const int32_t   channel,
             const size_t    n_samples,
             const float*    data)
 {
+	const LV2_Atom_Forge_Checkpoint checkpoint =
+		lv2_atom_forge_checkpoint(forge);
 	LV2_Atom_Forge_Frame frame;
 
 	// Forge container object of type 'RawAudio'
-	lv2_atom_forge_frame_time(forge, 0);
-	lv2_atom_forge_object(forge, &frame, 0, uris->RawAudio);
-
-	// Add integer 'channelID' property
-	lv2_atom_forge_key(forge, uris->channelID);
-	lv2_atom_forge_int(forge, channel);
-
-	// Add vector of floats 'audioData' property
-	lv2_atom_forge_key(forge, uris->audioData);
-	lv2_atom_forge_vector(
-		forge, sizeof(float), uris->atom_Float, n_samples, data);
+	if (!lv2_atom_forge_frame_time(forge, 0) ||
+	    !lv2_atom_forge_object(forge, &frame, 0, uris->RawAudio) ||
+	    // Add integer 'channelID' property
+	    !lv2_atom_forge_key(forge, uris->channelID) ||
+	    !lv2_atom_forge_int(forge, channel) ||
+	    // Add vector of floats 'audioData' property
+	    !lv2_atom_forge_key(forge, uris->audioData) ||
+	    !lv2_atom_forge_vector(
+		    forge, sizeof(float), uris->atom_Float, n_samples, data)) {
+		lv2_atom_forge_rollback(forge, &checkpoint);
+		return false;
+	}
 
 	// Close off object
 	lv2_atom_forge_pop(forge, &frame);
+	return true;
 }
 
 /** ==== Run Method ==== */
@@ -212,24 +249,12 @@ run(LV2_Handle handle, uint32_t n_samples)
 {
 	EgScope* self = (EgScope*)handle;
 
-	/* Ensure notify port buffer is large enough to hold all audio-samples and
-	   configuration settings.  A minimum size was requested in the .ttl file,
-	   but check here just to be sure.
-
-	   TODO: Explain these magic numbers.
+	/* Prepare forge buffer and initialize atom-sequence.  A minimum size for
+	   the notify port buffer was requested in the .ttl file, but messages
+	   are written in full or not at all, so a smaller buffer is handled
+	   gracefully by sending as many channels as fit.
 	*/
-	const size_t   size  = (sizeof(float) * n_samples + 64) * self->n_channels;
 	const uint32_t space = self->notify->atom.size;
-	if (space < size + 128) {
-		/* Insufficient space, report error and do nothing.  Note that a
-		   real-time production plugin mustn't call log functions in run(), but
-		   this can be useful for debugging and example purposes.
-		*/
-		lv2_log_error(&self->logger, "Buffer size is insufficient\n");
-		return;
-	}
-
-	// Prepare forge buffer and initialize atom-sequence
 	lv2_atom_forge_set_buffer(&self->forge, (uint8_t*)self->notify, space);
 	lv2_atom_forge_sequence_head(&self->forge, &self->frame, 0);
 
@@ -240,20 +265,25 @@ run(LV2_Handle handle, uint32_t n_samples)
 	   every time it asks for them or if the user initializes a 'load preset'.
 	*/
 	if (self->send_settings_to_ui && self->ui_active) {
-		self->send_settings_to_ui = false;
 		// Forge container object of type 'ui_state'
+		const LV2_Atom_Forge_Checkpoint checkpoint =
+			lv2_atom_forge_checkpoint(&self->forge);
 		LV2_Atom_Forge_Frame frame;
-		lv2_atom_forge_frame_time(&self->forge, 0);
-		lv2_atom_forge_object(&self->forge, &frame, 0, self->uris.ui_State);
-
-		// Add UI state as properties
-		lv2_atom_forge_key(&self->forge, self->uris.ui_spp);
-		lv2_atom_forge_int(&self->forge, self->ui_spp);
-		lv2_atom_forge_key(&self->forge, self->uris.ui_amp);
-		lv2_atom_forge_float(&self->forge, self->ui_amp);
-		lv2_atom_forge_key(&self->forge, self->uris.param_sampleRate);
-		lv2_atom_forge_float(&self->forge, self->rate);
-		lv2_atom_forge_pop(&self->forge, &frame);
+		if (lv2_atom_forge_frame_time(&self->forge, 0) &&
+		    lv2_atom_forge_object(&self->forge, &frame, 0, self->uris.ui_State) &&
+		    // Add UI state as properties
+		    lv2_atom_forge_key(&self->forge, self->uris.ui_spp) &&
+		    lv2_atom_forge_int(&self->forge, self->ui_spp) &&
+		    lv2_atom_forge_key(&self->forge, self->uris.ui_amp) &&
+		    lv2_atom_forge_float(&self->forge, self->ui_amp) &&
+		    lv2_atom_forge_key(&self->forge, self->uris.param_sampleRate) &&
+		    lv2_atom_forge_float(&self->forge, self->rate)) {
+			lv2_atom_forge_pop(&self->forge, &frame);
+			self->send_settings_to_ui = false;
+		} else {
+			// Did not fit, remove any partial message and try next cycle
+			lv2_atom_forge_rollback(&self->forge, &checkpoint);
+		}
 	}
 
 	// Process incoming events from GUI
@@ -275,16 +305,14 @@ run(LV2_Handle handle, uint32_t n_samples)
 					self->ui_active = false;
 				} else if (obj->body.otype == self->uris.ui_State) {
 					// If the object is a ui-state, it's the current UI settings
-					const LV2_Atom* spp = NULL;
-					const LV2_Atom* amp = NULL;
-					lv2_atom_object_get(obj, self->uris.ui_spp, &spp,
-					                    self->uris.ui_amp, &amp,
-					                    0);
-					if (spp) {
-						self->ui_spp = ((const LV2_Atom_Int*)spp)->body;
+					UIState        state;
+					const uint32_t found = lv2_atom_object_decode(
+						obj, self->ui_state_fields, &state);
+					if (found & UI_STATE_SPP) {
+						self->ui_spp = (uint32_t)state.spp;
 					}
-					if (amp) {
-						self->ui_amp = ((const LV2_Atom_Float*)amp)->body;
+					if (found & UI_STATE_AMP) {
+						self->ui_amp = state.amp;
 					}
 				}
 			}
@@ -293,10 +321,12 @@ run(LV2_Handle handle, uint32_t n_samples)
 	}
 
 	// Process audio data
+	bool fits = self->ui_active;
 	for (uint32_t c = 0; c < self->n_channels; ++c) {
-		if (self->ui_active) {
-			// If UI is active, send raw audio data to UI
-			tx_rawaudio(&self->forge, &self->uris, c, n_samples, self->input[c]);
+		if (fits) {
+			// If UI is active, send raw audio data to UI while there is space
+			fits = tx_rawaudio(
+				&self->forge, &self->uris, c, n_samples, self->input[c]);
 		}
 		// If not processing audio in-place, forward audio
 		if (self->input[c] != self->output[c]) {
@@ -0,0 +1,792 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   Headless benchmark host for the example plugins.
+
+   This loads the example plugins from the given bundles, and runs each at
+   every power of 2 block size from 16 to 8192 frames.  Audio inputs are fed
+   a sine wave, and atom inputs are fed synthetic MIDI, patch:Set, or
+   time:Position events at a fixed interval.  Work is done synchronously in
+   the calling thread.
+
+   Results are written to stdout as JSON, with the time per frame, the
+   number of input events processed per second of run() time, and the
+   number of allocations per cycle (where supported, with glibc).  Messages
+   from plugins are written to stderr.
+
+   Since there is no RDF parser here, the ports of each example plugin are
+   described in a table below.  Plugins that are not in the table are
+   skipped.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "lv2/atom/atom.h"
+#include "lv2/atom/forge.h"
+#include "lv2/core/lv2.h"
+#include "lv2/log/log.h"
+#include "lv2/midi/midi.h"
+#include "lv2/patch/patch.h"
+#include "lv2/time/time.h"
+#include "lv2/urid/urid.h"
+#include "lv2/worker/worker.h"
+
+#include "util/lv2_profile.h"
+
+#include <dirent.h>
+#include <dlfcn.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __APPLE__
+#    define LIB_EXT ".dylib"
+#else
+#    define LIB_EXT ".so"
+#endif
+
+#define MIN_BLOCK_SIZE 16
+#define MAX_BLOCK_SIZE 8192
+#define MAX_PORTS      6
+#define ATOM_CAPACITY  65536
+#define RESPONSES_SIZE 4096
+
+/* Allocation counting.  With glibc, malloc() and friends are defined here
+   to count calls while counting is enabled, which also catches calls from
+   loaded plugins.  Other systems do not report allocations. */
+
+#ifdef __GLIBC__
+#    define HAVE_ALLOC_COUNT 1
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t nmemb, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+static bool     alloc_counting = false;
+static uint64_t n_allocs       = 0;
+
+void*
+malloc(size_t size)
+{
+	n_allocs += alloc_counting;
+	return __libc_malloc(size);
+}
+
+void*
+calloc(size_t nmemb, size_t size)
+{
+	n_allocs += alloc_counting;
+	return __libc_calloc(nmemb, size);
+}
+
+void*
+realloc(void* ptr, size_t size)
+{
+	n_allocs += alloc_counting;
+	return __libc_realloc(ptr, size);
+}
+
+#else
+#    define HAVE_ALLOC_COUNT 0
+
+static bool     alloc_counting = false;
+static uint64_t n_allocs       = 0;
+#endif
+
+typedef enum {
+	PORT_CONTROL,    ///< Control input
+	PORT_AUDIO_IN,   ///< Audio input
+	PORT_AUDIO_OUT,  ///< Audio output
+	PORT_ATOM_IN,    ///< Atom sequence input
+	PORT_ATOM_OUT    ///< Atom sequence output
+} PortType;
+
+typedef enum {
+	EVENTS_NONE,     ///< No events
+	EVENTS_MIDI,     ///< Alternating MIDI note on and off
+	EVENTS_PATCH,    ///< patch:Set of a float property
+	EVENTS_POSITION  ///< time:Position at 120 BPM
+} EventsType;
+
+typedef struct {
+	PortType   type;    ///< Port type
+	EventsType events;  ///< Events for atom inputs
+	float      value;   ///< Value for control inputs
+} PortSpec;
+
+/** Description of an example plugin, in place of its data files. */
+typedef struct {
+	const char* uri;         ///< Plugin URI
+	const char* property;    ///< Float property for patch:Set events
+	const char* file_key;    ///< Path property to set before running
+	const char* file_name;   ///< Bundle file to set file_key to
+	uint32_t    n_ports;     ///< Number of ports
+	PortSpec    ports[MAX_PORTS];
+} PluginSpec;
+
+#define EG "http://lv2plug.in/plugins/"
+
+static const PluginSpec plugins[] = {
+	{ EG "eg-amp", NULL, NULL, NULL, 3,
+	  { { PORT_CONTROL, EVENTS_NONE, 0.0f },
+	    { PORT_AUDIO_IN, EVENTS_NONE, 0.0f },
+	    { PORT_AUDIO_OUT, EVENTS_NONE, 0.0f } } },
+	{ EG "eg-fifths", NULL, NULL, NULL, 2,
+	  { { PORT_ATOM_IN, EVENTS_MIDI, 0.0f },
+	    { PORT_ATOM_OUT, EVENTS_NONE, 0.0f } } },
+	{ EG "eg-metro", NULL, NULL, NULL, 2,
+	  { { PORT_ATOM_IN, EVENTS_POSITION, 0.0f },
+	    { PORT_AUDIO_OUT, EVENTS_NONE, 0.0f } } },
+	{ EG "eg-midigate", NULL, NULL, NULL, 4,
+	  { { PORT_ATOM_IN, EVENTS_MIDI, 0.0f },
+	    { PORT_AUDIO_IN, EVENTS_NONE, 0.0f },
+	    { PORT_AUDIO_OUT, EVENTS_NONE, 0.0f },
+	    { PORT_CONTROL, EVENTS_NONE, 5.0f } } },
+	{ EG "eg-params", EG "eg-params#float", NULL, NULL, 2,
+	  { { PORT_ATOM_IN, EVENTS_PATCH, 0.0f },
+	    { PORT_ATOM_OUT, EVENTS_NONE, 0.0f } } },
+	{ EG "eg-sampler", NULL, EG "eg-sampler#sample", "click.wav", 3,
+	  { { PORT_ATOM_IN, EVENTS_MIDI, 0.0f },
+	    { PORT_ATOM_OUT, EVENTS_NONE, 0.0f },
+	    { PORT_AUDIO_OUT, EVENTS_NONE, 0.0f } } },
+	{ EG "eg-scope#Mono", NULL, NULL, NULL, 4,
+	  { { PORT_ATOM_IN, EVENTS_NONE, 0.0f },
+	    { PORT_ATOM_OUT, EVENTS_NONE, 0.0f },
+	    { PORT_AUDIO_IN, EVENTS_NONE, 0.0f },
+	    { PORT_AUDIO_OUT, EVENTS_NONE, 0.0f } } },
+	{ EG "eg-scope#Stereo", NULL, NULL, NULL, 6,
+	  { { PORT_ATOM_IN, EVENTS_NONE, 0.0f },
+	    { PORT_ATOM_OUT, EVENTS_NONE, 0.0f },
+	    { PORT_AUDIO_IN, EVENTS_NONE, 0.0f },
+	    { PORT_AUDIO_OUT, EVENTS_NONE, 0.0f },
+	    { PORT_AUDIO_IN, EVENTS_NONE, 0.0f },
+	    { PORT_AUDIO_OUT, EVENTS_NONE, 0.0f } } },
+};
+
+typedef struct {
+	LV2_URID atom_Chunk;
+	LV2_URID atom_Float;
+	LV2_URID atom_Path;
+	LV2_URID atom_URID;
+	LV2_URID midi_MidiEvent;
+	LV2_URID patch_Set;
+	LV2_URID patch_property;
+	LV2_URID patch_value;
+	LV2_URID time_Position;
+	LV2_URID time_barBeat;
+	LV2_URID time_beatsPerMinute;
+	LV2_URID time_speed;
+} URIs;
+
+/** Synchronous worker for a plugin instance. */
+typedef struct {
+	const LV2_Worker_Interface* iface;           ///< Plugin worker interface
+	LV2_Handle                  instance;        ///< Wrapped plugin instance
+	uint32_t                    responses_size;  ///< Size of responses
+	uint64_t                    responses[RESPONSES_SIZE / sizeof(uint64_t)];
+} Worker;
+
+typedef struct {
+	char**              uris;          ///< Mapped URIs, indexed by URID - 1
+	uint32_t            n_uris;        ///< Number of mapped URIs
+	URIs                urids;         ///< URIDs used by the host
+	LV2_URID_Map        map;           ///< URID map feature data
+	LV2_URID_Unmap      unmap;         ///< URID unmap feature data
+	LV2_Log_Log         log;           ///< Log feature data
+	LV2_Worker_Schedule schedule;      ///< Worker schedule feature data
+	Worker              worker;        ///< Worker for the current instance
+	LV2_Atom_Forge      forge;         ///< Forge for input events
+	double              rate;          ///< Sample rate
+	uint32_t            n_frames;      ///< Frames to measure per block size
+	uint32_t            interval;      ///< Frames between input events
+	bool                first_result;  ///< True if no results are written yet
+	float               audio_in[MAX_BLOCK_SIZE];
+	float               audio_out[MAX_PORTS][MAX_BLOCK_SIZE];
+	uint64_t            atoms[MAX_PORTS][ATOM_CAPACITY / sizeof(uint64_t)];
+} Bench;
+
+static LV2_URID
+map_uri(LV2_URID_Map_Handle handle, const char* uri)
+{
+	Bench* const bench = (Bench*)handle;
+	for (uint32_t i = 0; i < bench->n_uris; ++i) {
+		if (!strcmp(bench->uris[i], uri)) {
+			return i + 1;
+		}
+	}
+
+	const size_t len  = strlen(uri);
+	char**       uris = (char**)realloc(
+		bench->uris, (bench->n_uris + 1) * sizeof(char*));
+	if (!uris) {
+		return 0;
+	}
+
+	bench->uris                = uris;
+	bench->uris[bench->n_uris] = (char*)malloc(len + 1);
+	memcpy(bench->uris[bench->n_uris], uri, len + 1);
+	return ++bench->n_uris;
+}
+
+static const char*
+unmap_uri(LV2_URID_Unmap_Handle handle, LV2_URID urid)
+{
+	Bench* const bench = (Bench*)handle;
+	return (urid > 0 && urid <= bench->n_uris) ? bench->uris[urid - 1] : NULL;
+}
+
+LV2_LOG_FUNC(3, 0)
+static int
+log_vprintf(LV2_Log_Handle handle, LV2_URID type, const char* fmt, va_list ap)
+{
+	Bench* const      bench = (Bench*)handle;
+	const char* const uri   = unmap_uri(bench, type);
+	if (uri && !strcmp(uri, LV2_LOG__Trace)) {
+		return 0;  // Ignore trace messages, which would dominate the time
+	}
+
+	fprintf(stderr, "%s: ", uri);
+	return vfprintf(stderr, fmt, ap);
+}
+
+LV2_LOG_FUNC(3, 4)
+static int
+log_printf(LV2_Log_Handle handle, LV2_URID type, const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	const int ret = log_vprintf(handle, type, fmt, args);
+	va_end(args);
+	return ret;
+}
+
+static LV2_Worker_Status
+worker_respond(LV2_Worker_Respond_Handle handle, uint32_t size, const void* data)
+{
+	Worker* const  worker = (Worker*)handle;
+	const uint32_t offset = worker->responses_size;
+	const uint32_t total  = lv2_atom_pad_size(sizeof(uint32_t) + size);
+	if (offset + total > RESPONSES_SIZE) {
+		return LV2_WORKER_ERR_NO_SPACE;
+	}
+
+	uint8_t* const buf = (uint8_t*)worker->responses + offset;
+	memcpy(buf, &size, sizeof(size));
+	memcpy(buf + sizeof(size), data, size);
+	worker->responses_size += total;
+	return LV2_WORKER_SUCCESS;
+}
+
+/** Do work immediately, which is not counted as allocation in run(). */
+static LV2_Worker_Status
+worker_schedule(LV2_Worker_Schedule_Handle handle,
+                uint32_t                   size,
+                const void*                data)
+{
+	Worker* const worker = (Worker*)handle;
+	if (!worker->iface) {
+		return LV2_WORKER_ERR_UNKNOWN;
+	}
+
+	const bool counting = alloc_counting;
+	alloc_counting = false;
+
+	const LV2_Worker_Status st = worker->iface->work(
+		worker->instance, worker_respond, worker, size, data);
+
+	alloc_counting = counting;
+	return st;
+}
+
+/** Deliver responses to the plugin at the end of a cycle. */
+static void
+worker_emit_responses(Worker* worker)
+{
+	if (!worker->iface) {
+		return;
+	}
+
+	for (uint32_t offset = 0; offset < worker->responses_size;) {
+		const uint8_t* const buf  = (const uint8_t*)worker->responses + offset;
+		uint32_t             size = 0;
+		memcpy(&size, buf, sizeof(size));
+		worker->iface->work_response(
+			worker->instance, size, buf + sizeof(size));
+		offset += lv2_atom_pad_size(sizeof(uint32_t) + size);
+	}
+
+	worker->responses_size = 0;
+	if (worker->iface->end_run) {
+		worker->iface->end_run(worker->instance);
+	}
+}
+
+static void
+write_event(Bench*            bench,
+            const PluginSpec* spec,
+            EventsType        type,
+            uint32_t          frame,
+            uint64_t          index)
+{
+	LV2_Atom_Forge* const forge = &bench->forge;
+	const URIs* const     uris  = &bench->urids;
+	LV2_Atom_Forge_Frame  frame_obj;
+
+	lv2_atom_forge_frame_time(forge, frame);
+	switch (type) {
+	case EVENTS_NONE:
+		break;
+	case EVENTS_MIDI: {
+		// Note on for even events, off for odd, with some other note
+		const uint8_t msg[3] = { (index % 2) ? LV2_MIDI_MSG_NOTE_OFF
+		                                     : LV2_MIDI_MSG_NOTE_ON,
+		                         (uint8_t)(48 + (index / 2) % 24),
+		                         (uint8_t)((index % 2) ? 0 : 100) };
+		lv2_atom_forge_atom(forge, sizeof(msg), uris->midi_MidiEvent);
+		lv2_atom_forge_write(forge, msg, sizeof(msg));
+		break;
+	}
+	case EVENTS_PATCH:
+		lv2_atom_forge_object(forge, &frame_obj, 0, uris->patch_Set);
+		lv2_atom_forge_key(forge, uris->patch_property);
+		lv2_atom_forge_urid(forge, map_uri(bench, spec->property));
+		lv2_atom_forge_key(forge, uris->patch_value);
+		lv2_atom_forge_float(forge, (float)(index % 100) / 100.0f);
+		lv2_atom_forge_pop(forge, &frame_obj);
+		break;
+	case EVENTS_POSITION: {
+		const double beat = (double)index * bench->interval * 2.0 / bench->rate;
+		lv2_atom_forge_object(forge, &frame_obj, 0, uris->time_Position);
+		lv2_atom_forge_key(forge, uris->time_barBeat);
+		lv2_atom_forge_float(forge, (float)fmod(beat, 4.0));
+		lv2_atom_forge_key(forge, uris->time_beatsPerMinute);
+		lv2_atom_forge_float(forge, 120.0f);
+		lv2_atom_forge_key(forge, uris->time_speed);
+		lv2_atom_forge_float(forge, 1.0f);
+		lv2_atom_forge_pop(forge, &frame_obj);
+		break;
+	}
+	}
+}
+
+/** Write a patch:Set of a file in the bundle, to load it before running. */
+static void
+write_set_file(Bench*            bench,
+               const PluginSpec* spec,
+               const char*       bundle_path)
+{
+	LV2_Atom_Forge* const forge = &bench->forge;
+	const URIs* const     uris  = &bench->urids;
+	const size_t          len   = strlen(bundle_path) + strlen(spec->file_name);
+	char* const           path  = (char*)calloc(1, len + 1);
+	snprintf(path, len + 1, "%s%s", bundle_path, spec->file_name);
+
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_frame_time(forge, 0);
+	lv2_atom_forge_object(forge, &frame, 0, uris->patch_Set);
+	lv2_atom_forge_key(forge, uris->patch_property);
+	lv2_atom_forge_urid(forge, map_uri(bench, spec->file_key));
+	lv2_atom_forge_key(forge, uris->patch_value);
+	lv2_atom_forge_path(forge, path, (uint32_t)len);
+	lv2_atom_forge_pop(forge, &frame);
+
+	free(path);
+}
+
+/**
+   Prepare ports for a cycle of `n_frames` starting at `pos`.
+
+   Input events are written at every multiple of the event interval, and
+   numbered by `*n_events`.  If `bundle_path` is given, a file is set first.
+*/
+static void
+prepare_ports(Bench*            bench,
+              const PluginSpec* spec,
+              uint64_t          pos,
+              uint32_t          n_frames,
+              uint64_t*         n_events,
+              const char*       bundle_path)
+{
+	for (uint32_t p = 0; p < spec->n_ports; ++p) {
+		LV2_Atom_Sequence* const seq = (LV2_Atom_Sequence*)bench->atoms[p];
+		if (spec->ports[p].type == PORT_ATOM_OUT) {
+			// Output buffers contain a chunk the size of the capacity
+			seq->atom.type = bench->urids.atom_Chunk;
+			seq->atom.size = ATOM_CAPACITY - sizeof(LV2_Atom);
+		} else if (spec->ports[p].type == PORT_ATOM_IN) {
+			LV2_Atom_Forge_Frame frame;
+			lv2_atom_forge_set_buffer(
+				&bench->forge, (uint8_t*)seq, ATOM_CAPACITY);
+			lv2_atom_forge_sequence_head(&bench->forge, &frame, 0);
+			if (bundle_path && spec->file_name) {
+				write_set_file(bench, spec, bundle_path);
+			}
+
+			const EventsType type = spec->ports[p].events;
+			if (type != EVENTS_NONE) {
+				const uint64_t next = (pos + bench->interval - 1) /
+				                      bench->interval * bench->interval;
+				for (uint64_t t = next; t < pos + n_frames; t += bench->interval) {
+					write_event(bench, spec, type, (uint32_t)(t - pos),
+					            (*n_events)++);
+				}
+			}
+
+			lv2_atom_forge_pop(&bench->forge, &frame);
+		}
+	}
+}
+
+/** Run one cycle, and deliver any worker responses. */
+static void
+run_cycle(Bench*                bench,
+          const LV2_Descriptor* desc,
+          LV2_Handle            instance,
+          uint32_t              n_frames)
+{
+	desc->run(instance, n_frames);
+	worker_emit_responses(&bench->worker);
+}
+
+static void
+write_result(Bench*                   bench,
+             const char*              uri,
+             uint32_t                 block_size,
+             const LV2_Profile_Stats* stats,
+             uint64_t                 allocs)
+{
+	const double secs = (double)stats->total_ns / 1.0e9;
+
+	printf("%s\n    {\"plugin\": \"%s\", \"block_size\": %u, \"cycles\": %llu",
+	       bench->first_result ? "" : ",",
+	       uri,
+	       block_size,
+	       (unsigned long long)stats->n_runs);
+	printf(", \"ns_per_frame\": %.4f, \"ns_per_cycle\": %.1f",
+	       (double)stats->total_ns / (double)stats->n_frames,
+	       (double)stats->total_ns / (double)stats->n_runs);
+	printf(", \"p50_ns\": %llu, \"p99_ns\": %llu, \"max_ns\": %llu",
+	       (unsigned long long)stats->p50_ns,
+	       (unsigned long long)stats->p99_ns,
+	       (unsigned long long)stats->max_ns);
+	printf(", \"overruns\": %llu, \"events\": %llu, \"events_per_s\": %.1f",
+	       (unsigned long long)stats->n_overruns,
+	       (unsigned long long)stats->n_events,
+	       secs > 0.0 ? (double)stats->n_events / secs : 0.0);
+	if (HAVE_ALLOC_COUNT) {
+		printf(", \"allocs_per_cycle\": %.4f}",
+		       (double)allocs / (double)stats->n_runs);
+	} else {
+		printf(", \"allocs_per_cycle\": null}");
+	}
+
+	bench->first_result = false;
+}
+
+/** Benchmark a plugin at every block size. */
+static int
+bench_plugin(Bench*                bench,
+             const PluginSpec*     spec,
+             const LV2_Descriptor* plugin,
+             const char*           bundle_path)
+{
+	const LV2_Feature map_feature      = { LV2_URID__map, &bench->map };
+	const LV2_Feature unmap_feature    = { LV2_URID__unmap, &bench->unmap };
+	const LV2_Feature log_feature      = { LV2_LOG__log, &bench->log };
+	const LV2_Feature schedule_feature = { LV2_WORKER__schedule,
+	                                       &bench->schedule };
+	const LV2_Feature* const features[] = {
+		&map_feature, &unmap_feature, &log_feature, &schedule_feature, NULL
+	};
+
+	LV2_Profile_Descriptor profile;
+	const LV2_Descriptor*  desc = lv2_profile_wrap(&profile, plugin);
+	for (uint32_t p = 0; p < spec->n_ports; ++p) {
+		if (spec->ports[p].type == PORT_ATOM_IN) {
+			lv2_profile_watch_atom_input(&profile, p);
+		}
+	}
+
+	for (uint32_t block = MIN_BLOCK_SIZE; block <= MAX_BLOCK_SIZE; block *= 2) {
+		LV2_Handle instance = desc->instantiate(
+			desc, bench->rate, bundle_path, features);
+		if (!instance) {
+			fprintf(stderr, "error: Failed to instantiate <%s>\n", spec->uri);
+			return 1;
+		}
+
+		// Set up worker for this instance
+		bench->worker.iface =
+			plugin->extension_data
+			? (const LV2_Worker_Interface*)plugin->extension_data(
+				LV2_WORKER__interface)
+			: NULL;
+		bench->worker.instance       = lv2_profile_get_instance(instance);
+		bench->worker.responses_size = 0;
+
+		// Connect ports
+		for (uint32_t p = 0; p < spec->n_ports; ++p) {
+			switch (spec->ports[p].type) {
+			case PORT_CONTROL:
+				desc->connect_port(instance, p, (void*)&spec->ports[p].value);
+				break;
+			case PORT_AUDIO_IN:
+				desc->connect_port(instance, p, bench->audio_in);
+				break;
+			case PORT_AUDIO_OUT:
+				desc->connect_port(instance, p, bench->audio_out[p]);
+				break;
+			case PORT_ATOM_IN:
+			case PORT_ATOM_OUT:
+				desc->connect_port(instance, p, bench->atoms[p]);
+				break;
+			}
+		}
+
+		desc->activate(instance);
+
+		// Warm up for 100ms without profiling, loading any file first
+		uint64_t       pos      = 0;
+		uint64_t       n_events = 0;
+		const uint32_t n_warmup = (uint32_t)(bench->rate / 10.0 / block) + 1;
+		lv2_profile_set_enabled(instance, false);
+		for (uint32_t i = 0; i < n_warmup; ++i, pos += block) {
+			prepare_ports(bench, spec, pos, block, &n_events,
+			              i == 0 ? bundle_path : NULL);
+			run_cycle(bench, desc, instance, block);
+		}
+
+		// Measure
+		const uint32_t n_cycles = bench->n_frames / block + 1;
+		lv2_profile_reset(instance);
+		lv2_profile_set_enabled(instance, true);
+		n_allocs = 0;
+		for (uint32_t i = 0; i < n_cycles; ++i, pos += block) {
+			prepare_ports(bench, spec, pos, block, &n_events, NULL);
+			alloc_counting = true;
+			run_cycle(bench, desc, instance, block);
+			alloc_counting = false;
+		}
+
+		LV2_Profile_Stats stats;
+		lv2_profile_get_stats(instance, &stats);
+		write_result(bench, spec->uri, block, &stats, n_allocs);
+
+		if (desc->deactivate) {
+			desc->deactivate(instance);
+		}
+		desc->cleanup(instance);
+	}
+
+	return 0;
+}
+
+static const PluginSpec*
+find_spec(const char* uri)
+{
+	for (size_t i = 0; i < sizeof(plugins) / sizeof(PluginSpec); ++i) {
+		if (!strcmp(plugins[i].uri, uri)) {
+			return &plugins[i];
+		}
+	}
+	return NULL;
+}
+
+/** Benchmark all known plugins in a library. */
+static int
+bench_library(Bench* bench, const char* bundle_path, const char* lib_path)
+{
+	void* const lib = dlopen(lib_path, RTLD_NOW | RTLD_LOCAL);
+	if (!lib) {
+		fprintf(stderr, "error: Failed to open %s (%s)\n", lib_path, dlerror());
+		return 1;
+	}
+
+	LV2_Descriptor_Function df  = NULL;
+	void* const             sym = dlsym(lib, "lv2_descriptor");
+	memcpy(&df, &sym, sizeof(df));
+	if (!df) {
+		dlclose(lib);
+		return 0;  // Not a plugin library, probably a UI
+	}
+
+	int st = 0;
+	for (uint32_t i = 0; !st; ++i) {
+		const LV2_Descriptor* const desc = df(i);
+		if (!desc) {
+			break;
+		}
+
+		const PluginSpec* const spec = find_spec(desc->URI);
+		if (spec) {
+			st = bench_plugin(bench, spec, desc, bundle_path);
+		} else {
+			fprintf(stderr, "warning: Skipping unknown <%s>\n", desc->URI);
+		}
+	}
+
+	dlclose(lib);
+	return st;
+}
+
+/** Benchmark all plugins in every library in a bundle directory. */
+static int
+bench_bundle(Bench* bench, const char* path)
+{
+	// Make a bundle path with a trailing slash
+	const size_t path_len    = strlen(path);
+	const bool   has_slash   = path_len > 0 && path[path_len - 1] == '/';
+	char* const  bundle_path = (char*)calloc(1, path_len + 2);
+	memcpy(bundle_path, path, path_len);
+	if (!has_slash) {
+		bundle_path[path_len] = '/';
+	}
+
+	DIR* const dir = opendir(bundle_path);
+	if (!dir) {
+		fprintf(stderr, "error: Failed to open bundle %s\n", bundle_path);
+		free(bundle_path);
+		return 1;
+	}
+
+	int st = 0;
+	for (struct dirent* e = readdir(dir); e && !st; e = readdir(dir)) {
+		const size_t name_len = strlen(e->d_name);
+		const size_t ext_len  = strlen(LIB_EXT);
+		if (name_len > ext_len &&
+		    !strcmp(e->d_name + name_len - ext_len, LIB_EXT)) {
+			const size_t lib_len  = strlen(bundle_path) + name_len;
+			char* const  lib_path = (char*)calloc(1, lib_len + 1);
+			snprintf(lib_path, lib_len + 1, "%s%s", bundle_path, e->d_name);
+			st = bench_library(bench, bundle_path, lib_path);
+			free(lib_path);
+		}
+	}
+
+	closedir(dir);
+	free(bundle_path);
+	return st;
+}
+
+static int
+print_usage(const char* name, bool error)
+{
+	FILE* const os = error ? stderr : stdout;
+	fprintf(os, "Usage: %s [OPTION]... BUNDLE...\n", name);
+	fprintf(os, "Benchmark the example plugins in the given bundles.\n\n");
+	fprintf(os, "  -e FRAMES  Frames between input events (default: 480)\n");
+	fprintf(os, "  -f FRAMES  Frames to run per block size (default: 5 s)\n");
+	fprintf(os, "  -h         Display this help and exit\n");
+	fprintf(os, "  -r RATE    Sample rate (default: 48000)\n");
+	return error ? 1 : 0;
+}
+
+int
+main(int argc, char** argv)
+{
+	Bench* const bench = (Bench*)calloc(1, sizeof(Bench));
+	if (!bench) {
+		return 1;
+	}
+
+	bench->rate         = 48000.0;
+	bench->interval     = 480;
+	bench->first_result = true;
+
+	long n_frames = 0;
+	int  a        = 1;
+	for (; a < argc && argv[a][0] == '-'; ++a) {
+		if (argv[a][1] == 'h') {
+			free(bench);
+			return print_usage(argv[0], false);
+		} else if (a + 1 == argc) {
+			free(bench);
+			return print_usage(argv[0], true);
+		} else if (argv[a][1] == 'e') {
+			bench->interval = (uint32_t)strtoul(argv[++a], NULL, 10);
+		} else if (argv[a][1] == 'f') {
+			n_frames = strtol(argv[++a], NULL, 10);
+		} else if (argv[a][1] == 'r') {
+			bench->rate = strtod(argv[++a], NULL);
+		} else {
+			free(bench);
+			return print_usage(argv[0], true);
+		}
+	}
+
+	if (a == argc || bench->interval == 0 || bench->rate <= 0.0) {
+		free(bench);
+		return print_usage(argv[0], true);
+	}
+
+	bench->n_frames = (n_frames > 0 ? (uint32_t)n_frames
+	                                 : (uint32_t)(bench->rate * 5.0));
+
+	// Set up host features
+	bench->map.handle      = bench;
+	bench->map.map         = map_uri;
+	bench->unmap.handle    = bench;
+	bench->unmap.unmap     = unmap_uri;
+	bench->log.handle      = bench;
+	bench->log.printf      = log_printf;
+	bench->log.vprintf     = log_vprintf;
+	bench->schedule.handle = &bench->worker;
+	bench->schedule.schedule_work = worker_schedule;
+
+	URIs* const uris          = &bench->urids;
+	uris->atom_Chunk          = map_uri(bench, LV2_ATOM__Chunk);
+	uris->atom_Float          = map_uri(bench, LV2_ATOM__Float);
+	uris->atom_Path           = map_uri(bench, LV2_ATOM__Path);
+	uris->atom_URID           = map_uri(bench, LV2_ATOM__URID);
+	uris->midi_MidiEvent      = map_uri(bench, LV2_MIDI__MidiEvent);
+	uris->patch_Set           = map_uri(bench, LV2_PATCH__Set);
+	uris->patch_property      = map_uri(bench, LV2_PATCH__property);
+	uris->patch_value         = map_uri(bench, LV2_PATCH__value);
+	uris->time_Position       = map_uri(bench, LV2_TIME__Position);
+	uris->time_barBeat        = map_uri(bench, LV2_TIME__barBeat);
+	uris->time_beatsPerMinute = map_uri(bench, LV2_TIME__beatsPerMinute);
+	uris->time_speed          = map_uri(bench, LV2_TIME__speed);
+	lv2_atom_forge_init(&bench->forge, &bench->map);
+
+	// Generate a 440 Hz sine for audio inputs
+	for (uint32_t i = 0; i < MAX_BLOCK_SIZE; ++i) {
+		bench->audio_in[i] = 0.5f * (float)sin(
+			2.0 * 3.14159265358979 * 440.0 * i / bench->rate);
+	}
+
+	printf("{\n  \"rate\": %.0f,\n  \"event_interval\": %u,\n",
+	       bench->rate, bench->interval);
+	printf("  \"results\": [");
+
+	int st = 0;
+	for (; a < argc && !st; ++a) {
+		st = bench_bundle(bench, argv[a]);
+	}
+
+	printf("\n  ]\n}\n");
+
+	for (uint32_t i = 0; i < bench->n_uris; ++i) {
+		free(bench->uris[i]);
+	}
+	free(bench->uris);
+	free(bench);
+	return st;
+}
@@ -0,0 +1,478 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   A proxy descriptor that measures the run() time of any plugin.
+
+   A host wraps a plugin descriptor with lv2_profile_wrap(), and uses the
+   returned proxy descriptor in place of the original.  The proxy records the
+   duration of every call to run() in a histogram, counts the events on
+   selected atom input ports, and counts overruns where run() takes longer
+   than a given fraction of the real time of the block.  Statistics can be
+   read at any time from another thread with lv2_profile_get_stats().
+
+   Extension data is not available from the proxy descriptor, since
+   LV2_Descriptor::extension_data() is not told which descriptor it is called
+   for.  Hosts should get extension data from the wrapped descriptor, and
+   call it with the wrapped instance from lv2_profile_get_instance().
+
+   The clock uses clock_gettime() if `CLOCK_MONOTONIC` is defined (on POSIX
+   systems with a suitable `_POSIX_C_SOURCE`), otherwise timespec_get() if
+   available, and otherwise the coarse clock().  A different clock can be set
+   in the profile descriptor.
+
+   This header is not installed.  It is used by the benchmark programs, and
+   is not a part of the core specification since it depends on atoms.
+*/
+
+#ifndef LV2_PROFILE_H
+#define LV2_PROFILE_H
+
+#include "lv2/atom/atom.h"
+#include "lv2/atom/util.h"
+#include "lv2/core/lv2.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of ports, only atom inputs below this can be watched. */
+#define LV2_PROFILE_MAX_PORTS 64
+
+/** Number of histogram buckets, with 4 per power of 2 nanoseconds. */
+#define LV2_PROFILE_N_BUCKETS 252
+
+/** @cond */
+#ifdef __GNUC__
+#    define LV2_PROFILE_LOAD(ptr) __atomic_load_n(ptr, __ATOMIC_RELAXED)
+#    define LV2_PROFILE_STORE(ptr, val) \
+	__atomic_store_n(ptr, val, __ATOMIC_RELAXED)
+#else
+#    define LV2_PROFILE_LOAD(ptr) (*(ptr))
+#    define LV2_PROFILE_STORE(ptr, val) (*(ptr) = (val))
+#endif
+/** @endcond */
+
+/**
+   Function that returns the current time in nanoseconds.
+*/
+typedef uint64_t (*LV2_Profile_Clock_Func)(void);
+
+/**
+   A proxy descriptor that profiles a wrapped descriptor.
+
+   This must be initialised with lv2_profile_wrap(), and must outlive all
+   instances created with it.
+*/
+typedef struct {
+	LV2_Descriptor         descriptor;  ///< Proxy descriptor for hosts
+	const LV2_Descriptor*  wrapped;     ///< Profiled plugin descriptor
+	uint64_t               atom_inputs; ///< Bit mask of atom input ports
+	double                 overrun;     ///< Overrun fraction of block time
+	LV2_Profile_Clock_Func clock;       ///< Clock for measuring run()
+} LV2_Profile_Descriptor;
+
+/**
+   Statistics for a profiled instance.
+*/
+typedef struct {
+	uint64_t n_runs;      ///< Number of calls to run()
+	uint64_t n_frames;    ///< Total number of frames run
+	uint64_t n_events;    ///< Total number of events on atom inputs
+	uint64_t n_overruns;  ///< Number of runs that exceeded the overrun time
+	uint64_t total_ns;    ///< Total time in run()
+	uint64_t max_ns;      ///< Longest run() time
+	uint64_t p50_ns;      ///< Median run() time
+	uint64_t p90_ns;      ///< 90th percentile run() time
+	uint64_t p99_ns;      ///< 99th percentile run() time
+} LV2_Profile_Stats;
+
+/**
+   A profiled plugin instance.
+
+   Counters are only written by run(), and may be read from any thread.
+*/
+typedef struct {
+	const LV2_Profile_Descriptor* profile;   ///< Proxy descriptor
+	LV2_Handle                    instance;  ///< Wrapped plugin instance
+	double                        rate;      ///< Sample rate
+	uint32_t                      enabled;   ///< Non-zero if recording
+	uint32_t                      reset;     ///< Non-zero if reset requested
+	const LV2_Atom_Sequence*      atom_inputs[LV2_PROFILE_MAX_PORTS];
+
+	uint64_t n_runs;
+	uint64_t n_frames;
+	uint64_t n_events;
+	uint64_t n_overruns;
+	uint64_t total_ns;
+	uint64_t max_ns;
+	uint64_t histogram[LV2_PROFILE_N_BUCKETS];
+} LV2_Profile_Instance;
+
+/**
+   Return the current time in nanoseconds from the default clock.
+*/
+static inline uint64_t
+lv2_profile_now(void)
+{
+#if defined(CLOCK_MONOTONIC)
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+#elif defined(TIME_UTC)
+	struct timespec t;
+	timespec_get(&t, TIME_UTC);
+	return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+#else
+	return (uint64_t)((double)clock() * 1.0e9 / CLOCKS_PER_SEC);
+#endif
+}
+
+/**
+   Return the histogram bucket for a duration in nanoseconds.
+
+   Durations under 8ns have a bucket each, larger durations have 4 buckets
+   per power of 2, so a bucket is at most 25% wider than its lower bound.
+*/
+static inline uint32_t
+lv2_profile_bucket(uint64_t ns)
+{
+	if (ns < 8) {
+		return (uint32_t)ns;
+	}
+
+#ifdef __GNUC__
+	const uint32_t e = 63u - (uint32_t)__builtin_clzll(ns);
+#else
+	uint32_t e = 0;
+	for (uint64_t v = ns; v > 1; v >>= 1) {
+		++e;
+	}
+#endif
+
+	return 4 * e - 4 + (uint32_t)((ns >> (e - 2)) & 3);
+}
+
+/**
+   Return the smallest duration in nanoseconds in a histogram bucket.
+*/
+static inline uint64_t
+lv2_profile_bucket_min(uint32_t bucket)
+{
+	if (bucket < 8) {
+		return bucket;
+	}
+
+	const uint32_t e = bucket / 4 + 1;
+	return (uint64_t)(4 + bucket % 4) << (e - 2);
+}
+
+/** @cond */
+
+static inline LV2_Handle
+lv2_profile_instantiate(const LV2_Descriptor*     proxy,
+                        double                    rate,
+                        const char*               bundle_path,
+                        const LV2_Feature* const* features)
+{
+	const LV2_Profile_Descriptor* const profile =
+		(const LV2_Profile_Descriptor*)proxy;
+
+	LV2_Profile_Instance* const inst =
+		(LV2_Profile_Instance*)calloc(1, sizeof(LV2_Profile_Instance));
+	if (!inst) {
+		return NULL;
+	}
+
+	inst->instance = profile->wrapped->instantiate(
+		profile->wrapped, rate, bundle_path, features);
+	if (!inst->instance) {
+		free(inst);
+		return NULL;
+	}
+
+	inst->profile = profile;
+	inst->rate    = rate;
+	inst->enabled = 1;
+	return inst;
+}
+
+static inline void
+lv2_profile_connect_port(LV2_Handle instance, uint32_t port, void* data)
+{
+	LV2_Profile_Instance* const inst = (LV2_Profile_Instance*)instance;
+
+	if (port < LV2_PROFILE_MAX_PORTS &&
+	    (inst->profile->atom_inputs & ((uint64_t)1 << port))) {
+		inst->atom_inputs[port] = (const LV2_Atom_Sequence*)data;
+	}
+
+	inst->profile->wrapped->connect_port(inst->instance, port, data);
+}
+
+static inline void
+lv2_profile_activate(LV2_Handle instance)
+{
+	LV2_Profile_Instance* const inst = (LV2_Profile_Instance*)instance;
+	if (inst->profile->wrapped->activate) {
+		inst->profile->wrapped->activate(inst->instance);
+	}
+}
+
+static inline void
+lv2_profile_deactivate(LV2_Handle instance)
+{
+	LV2_Profile_Instance* const inst = (LV2_Profile_Instance*)instance;
+	if (inst->profile->wrapped->deactivate) {
+		inst->profile->wrapped->deactivate(inst->instance);
+	}
+}
+
+static inline void
+lv2_profile_cleanup(LV2_Handle instance)
+{
+	LV2_Profile_Instance* const inst = (LV2_Profile_Instance*)instance;
+	inst->profile->wrapped->cleanup(inst->instance);
+	free(inst);
+}
+
+static inline void
+lv2_profile_clear(LV2_Profile_Instance* inst)
+{
+	LV2_PROFILE_STORE(&inst->n_runs, 0);
+	LV2_PROFILE_STORE(&inst->n_frames, 0);
+	LV2_PROFILE_STORE(&inst->n_events, 0);
+	LV2_PROFILE_STORE(&inst->n_overruns, 0);
+	LV2_PROFILE_STORE(&inst->total_ns, 0);
+	LV2_PROFILE_STORE(&inst->max_ns, 0);
+	for (uint32_t i = 0; i < LV2_PROFILE_N_BUCKETS; ++i) {
+		LV2_PROFILE_STORE(&inst->histogram[i], 0);
+	}
+}
+
+/** Increment a counter which is only written by this thread. */
+static inline void
+lv2_profile_add(uint64_t* counter, uint64_t n)
+{
+	LV2_PROFILE_STORE(counter, LV2_PROFILE_LOAD(counter) + n);
+}
+
+static inline void
+lv2_profile_run(LV2_Handle instance, uint32_t sample_count)
+{
+	LV2_Profile_Instance* const         inst    = (LV2_Profile_Instance*)instance;
+	const LV2_Profile_Descriptor* const profile = inst->profile;
+
+	if (!LV2_PROFILE_LOAD(&inst->enabled)) {
+		profile->wrapped->run(inst->instance, sample_count);
+		return;
+	}
+
+	if (LV2_PROFILE_LOAD(&inst->reset)) {
+		lv2_profile_clear(inst);
+		LV2_PROFILE_STORE(&inst->reset, 0);
+	}
+
+	// Count input events before run(), since a plugin may use the buffer
+	uint64_t n_events = 0;
+	for (uint64_t mask = profile->atom_inputs; mask; mask &= mask - 1) {
+		uint32_t port = 0;
+		while (!(mask & ((uint64_t)1 << port))) {
+			++port;
+		}
+
+		if (inst->atom_inputs[port]) {
+			LV2_ATOM_SEQUENCE_FOREACH(inst->atom_inputs[port], ev) {
+				++n_events;
+			}
+		}
+	}
+
+	const uint64_t t_start = profile->clock();
+	profile->wrapped->run(inst->instance, sample_count);
+	const uint64_t t_end = profile->clock();
+
+	const uint64_t ns       = t_end - t_start;
+	const double   block_ns = sample_count * 1.0e9 / inst->rate;
+
+	lv2_profile_add(&inst->n_runs, 1);
+	lv2_profile_add(&inst->n_frames, sample_count);
+	lv2_profile_add(&inst->n_events, n_events);
+	lv2_profile_add(&inst->total_ns, ns);
+	lv2_profile_add(&inst->histogram[lv2_profile_bucket(ns)], 1);
+	if (ns > LV2_PROFILE_LOAD(&inst->max_ns)) {
+		LV2_PROFILE_STORE(&inst->max_ns, ns);
+	}
+	if ((double)ns > block_ns * profile->overrun) {
+		lv2_profile_add(&inst->n_overruns, 1);
+	}
+}
+
+static inline const void*
+lv2_profile_extension_data(const char* uri)
+{
+	(void)uri;
+	return NULL;
+}
+
+/** @endcond */
+
+/**
+   Initialise a proxy descriptor that profiles `wrapped`.
+
+   By default, no atom inputs are watched, an overrun is a run() that takes
+   longer than the real time of the block, and lv2_profile_now() is used as
+   the clock.  These may be changed in `profile` before instantiating.
+
+   @return The proxy descriptor to use in place of `wrapped`.
+*/
+static inline const LV2_Descriptor*
+lv2_profile_wrap(LV2_Profile_Descriptor* profile,
+                 const LV2_Descriptor*   wrapped)
+{
+	memset(profile, 0, sizeof(*profile));
+
+	profile->descriptor.URI            = wrapped->URI;
+	profile->descriptor.instantiate    = lv2_profile_instantiate;
+	profile->descriptor.connect_port   = lv2_profile_connect_port;
+	profile->descriptor.activate       = lv2_profile_activate;
+	profile->descriptor.run            = lv2_profile_run;
+	profile->descriptor.deactivate     = lv2_profile_deactivate;
+	profile->descriptor.cleanup        = lv2_profile_cleanup;
+	profile->descriptor.extension_data = lv2_profile_extension_data;
+
+	profile->wrapped = wrapped;
+	profile->overrun = 1.0;
+	profile->clock   = lv2_profile_now;
+
+	return &profile->descriptor;
+}
+
+/**
+   Watch an atom sequence input port, so events on it are counted.
+
+   The port index must be less than @ref LV2_PROFILE_MAX_PORTS.
+*/
+static inline void
+lv2_profile_watch_atom_input(LV2_Profile_Descriptor* profile, uint32_t port)
+{
+	if (port < LV2_PROFILE_MAX_PORTS) {
+		profile->atom_inputs |= (uint64_t)1 << port;
+	}
+}
+
+/**
+   Return the wrapped instance of a profiled instance.
+
+   This is the handle to pass to extension data from the wrapped descriptor.
+*/
+static inline LV2_Handle
+lv2_profile_get_instance(LV2_Handle instance)
+{
+	return ((LV2_Profile_Instance*)instance)->instance;
+}
+
+/**
+   Enable or disable profiling of an instance.
+
+   When disabled, run() only calls the wrapped run() without measuring.
+   This may be called from any thread.
+*/
+static inline void
+lv2_profile_set_enabled(LV2_Handle instance, bool enabled)
+{
+	LV2_PROFILE_STORE(&((LV2_Profile_Instance*)instance)->enabled,
+	                  enabled ? 1u : 0u);
+}
+
+/**
+   Reset the statistics of an instance.
+
+   This may be called from any thread, statistics are cleared at the start of
+   the next run().
+*/
+static inline void
+lv2_profile_reset(LV2_Handle instance)
+{
+	LV2_PROFILE_STORE(&((LV2_Profile_Instance*)instance)->reset, 1u);
+}
+
+/**
+   Return an upper bound of the `p`th percentile of run() times.
+
+   This may be called from any thread.
+
+   @param instance A profiled instance.
+   @param p The percentile, from 0.0 to 100.0.
+*/
+static inline uint64_t
+lv2_profile_percentile(LV2_Handle instance, double p)
+{
+	LV2_Profile_Instance* const inst = (LV2_Profile_Instance*)instance;
+
+	uint64_t counts[LV2_PROFILE_N_BUCKETS];
+	uint64_t n = 0;
+	for (uint32_t i = 0; i < LV2_PROFILE_N_BUCKETS; ++i) {
+		n += counts[i] = LV2_PROFILE_LOAD(&inst->histogram[i]);
+	}
+
+	const uint64_t max_ns = LV2_PROFILE_LOAD(&inst->max_ns);
+	const double   rank   = p / 100.0 * (double)n;
+	uint64_t       seen   = 0;
+	for (uint32_t i = 0; i < LV2_PROFILE_N_BUCKETS - 1; ++i) {
+		seen += counts[i];
+		if (n && (double)seen >= rank) {
+			const uint64_t upper = lv2_profile_bucket_min(i + 1) - 1;
+			return (upper < max_ns) ? upper : max_ns;
+		}
+	}
+
+	return max_ns;
+}
+
+/**
+   Get the statistics of a profiled instance.
+
+   This may be called from any thread.  The statistics are not a consistent
+   snapshot if run() is called concurrently, but each value is valid.
+*/
+static inline void
+lv2_profile_get_stats(LV2_Handle instance, LV2_Profile_Stats* stats)
+{
+	LV2_Profile_Instance* const inst = (LV2_Profile_Instance*)instance;
+
+	stats->n_runs     = LV2_PROFILE_LOAD(&inst->n_runs);
+	stats->n_frames   = LV2_PROFILE_LOAD(&inst->n_frames);
+	stats->n_events   = LV2_PROFILE_LOAD(&inst->n_events);
+	stats->n_overruns = LV2_PROFILE_LOAD(&inst->n_overruns);
+	stats->total_ns   = LV2_PROFILE_LOAD(&inst->total_ns);
+	stats->max_ns     = LV2_PROFILE_LOAD(&inst->max_ns);
+	stats->p50_ns     = lv2_profile_percentile(instance, 50.0);
+	stats->p90_ns     = lv2_profile_percentile(instance, 90.0);
+	stats->p99_ns     = lv2_profile_percentile(instance, 99.0);
+}
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif  /* LV2_PROFILE_H */
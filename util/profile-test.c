@@ -0,0 +1,230 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "lv2/atom/atom.h"
+#include "lv2/core/lv2.h"
+
+#include "util/lv2_profile.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RATE 48000.0
+
+/** Fake time in nanoseconds, advanced by the test plugin. */
+static uint64_t now = 0;
+
+/** Fake plugin which takes a given time to run. */
+typedef struct {
+	uint64_t run_ns;
+	uint32_t n_runs;
+	void*    ports[2];
+	bool     active;
+} TestPlugin;
+
+static int
+test_fail(const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	fprintf(stderr, "error: ");
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	return 1;
+}
+
+static uint64_t
+test_clock(void)
+{
+	return now;
+}
+
+static LV2_Handle
+test_instantiate(const LV2_Descriptor*     descriptor,
+                 double                    rate,
+                 const char*               bundle_path,
+                 const LV2_Feature* const* features)
+{
+	return rate == RATE ? calloc(1, sizeof(TestPlugin)) : NULL;
+}
+
+static void
+test_connect_port(LV2_Handle instance, uint32_t port, void* data)
+{
+	((TestPlugin*)instance)->ports[port] = data;
+}
+
+static void
+test_activate(LV2_Handle instance)
+{
+	((TestPlugin*)instance)->active = true;
+}
+
+static void
+test_run(LV2_Handle instance, uint32_t sample_count)
+{
+	TestPlugin* const plugin = (TestPlugin*)instance;
+	now += plugin->run_ns;
+	++plugin->n_runs;
+}
+
+static void
+test_cleanup(LV2_Handle instance)
+{
+	free(instance);
+}
+
+static const void*
+test_extension_data(const char* uri)
+{
+	return NULL;
+}
+
+static const LV2_Descriptor test_descriptor = {
+	"http://example.org/test",
+	test_instantiate,
+	test_connect_port,
+	test_activate,
+	test_run,
+	NULL,
+	test_cleanup,
+	test_extension_data
+};
+
+static int
+test_buckets(void)
+{
+	uint32_t last = 0;
+	for (uint64_t ns = 0; ns < 100000; ++ns) {
+		const uint32_t bucket = lv2_profile_bucket(ns);
+		if (bucket < last || bucket > last + 1) {
+			return test_fail("Bucket for %u is not contiguous\n", (unsigned)ns);
+		} else if (lv2_profile_bucket_min(bucket) > ns ||
+		           lv2_profile_bucket_min(bucket + 1) <= ns) {
+			return test_fail("Bucket %u does not contain %u\n",
+			                 bucket, (unsigned)ns);
+		}
+		last = bucket;
+	}
+
+	if (lv2_profile_bucket(UINT64_MAX) != LV2_PROFILE_N_BUCKETS - 1) {
+		return test_fail("Bucket for maximum duration is not the last\n");
+	}
+
+	return 0;
+}
+
+static int
+test_profile(void)
+{
+	LV2_Profile_Descriptor profile;
+	const LV2_Descriptor*  desc = lv2_profile_wrap(&profile, &test_descriptor);
+	lv2_profile_watch_atom_input(&profile, 1);
+	profile.overrun = 0.5;
+	profile.clock   = test_clock;
+
+	if (strcmp(desc->URI, test_descriptor.URI) ||
+	    desc->extension_data(LV2_CORE__isLive)) {
+		return test_fail("Bad proxy descriptor\n");
+	} else if (desc->instantiate(desc, RATE / 2, "", NULL)) {
+		return test_fail("Failed instantiation succeeded\n");
+	}
+
+	LV2_Handle        instance = desc->instantiate(desc, RATE, "", NULL);
+	TestPlugin* const plugin   = (TestPlugin*)lv2_profile_get_instance(instance);
+
+	// Set up an input sequence with 3 events
+	uint64_t           buf[16] = { 0 };
+	LV2_Atom_Sequence* seq     = (LV2_Atom_Sequence*)buf;
+	seq->atom.size             = sizeof(LV2_Atom_Sequence_Body) +
+	                             3 * sizeof(LV2_Atom_Event);
+
+	float audio[64];
+	desc->connect_port(instance, 0, audio);
+	desc->connect_port(instance, 1, seq);
+	desc->activate(instance);
+	desc->deactivate(instance);
+	if (plugin->ports[0] != audio || plugin->ports[1] != seq ||
+	    !plugin->active) {
+		return test_fail("Calls were not forwarded to plugin\n");
+	}
+
+	/* Run 100 blocks of 48 frames (1ms, so overruns take over 500us), where
+	   run() takes 1us to 100us. */
+	for (uint64_t i = 1; i <= 100; ++i) {
+		plugin->run_ns = i * 1000;
+		desc->run(instance, 48);
+	}
+
+	LV2_Profile_Stats stats;
+	lv2_profile_get_stats(instance, &stats);
+	if (stats.n_runs != 100 || stats.n_frames != 4800 ||
+	    stats.n_events != 300 || stats.total_ns != 5050000 ||
+	    stats.max_ns != 100000 || stats.n_overruns != 0) {
+		return test_fail("Incorrect statistics\n");
+	}
+
+	// Percentiles are upper bounds at most 25% larger than exact
+	if (stats.p50_ns < 50000 || stats.p50_ns > 62500 ||
+	    stats.p90_ns < 90000 || stats.p90_ns > 100000 ||
+	    stats.p99_ns < 99000 || stats.p99_ns > 100000 ||
+	    lv2_profile_percentile(instance, 100.0) != 100000) {
+		return test_fail("Incorrect percentiles %u %u %u\n",
+		                 (unsigned)stats.p50_ns,
+		                 (unsigned)stats.p90_ns,
+		                 (unsigned)stats.p99_ns);
+	}
+
+	// Run over half the block time
+	plugin->run_ns = 600000;
+	desc->run(instance, 48);
+	lv2_profile_get_stats(instance, &stats);
+	if (stats.n_overruns != 1 || stats.max_ns != 600000) {
+		return test_fail("Overrun not counted\n");
+	}
+
+	// Run while disabled, which only runs the plugin
+	lv2_profile_set_enabled(instance, false);
+	desc->run(instance, 48);
+	lv2_profile_set_enabled(instance, true);
+	lv2_profile_get_stats(instance, &stats);
+	if (plugin->n_runs != 102 || stats.n_runs != 101) {
+		return test_fail("Disabled run was recorded\n");
+	}
+
+	// Reset, which clears statistics at the start of the next run
+	lv2_profile_reset(instance);
+	plugin->run_ns = 1000;
+	desc->run(instance, 48);
+	lv2_profile_get_stats(instance, &stats);
+	if (stats.n_runs != 1 || stats.max_ns != 1000 || stats.n_events != 3 ||
+	    stats.p99_ns < 1000 || stats.p99_ns > 1250) {
+		return test_fail("Statistics were not reset\n");
+	}
+
+	desc->cleanup(instance);
+	return 0;
+}
+
+int
+main(void)
+{
+	return test_buckets() || test_profile();
+}